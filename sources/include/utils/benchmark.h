@@ -0,0 +1,504 @@
+#ifndef utils_benchmark_h
+#define utils_benchmark_h
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+#include "timer.h"
+#include "type_list.h"
+#include "value_list.h"
+
+namespace utils
+{
+namespace bench
+{
+// Makes the compiler assume aValue is read (and, for the non-const overload,
+// modified), so the computation producing it can not be optimized away.
+template <typename T>
+inline void do_not_optimize(const T &aValue) noexcept
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    static_cast<void>(*reinterpret_cast<const volatile char *>(&aValue));
+    _ReadWriteBarrier();
+#else
+    if constexpr (std::is_trivially_copyable_v<T> &&
+                  (sizeof(T) <= sizeof(void *)))
+    {
+        asm volatile("" : : "r,m"(aValue) : "memory");
+    }
+    else
+    {
+        asm volatile("" : : "m"(aValue) : "memory");
+    }
+#endif
+}
+
+template <typename T>
+inline void do_not_optimize(T &aValue) noexcept
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    static_cast<void>(*reinterpret_cast<volatile char *>(&aValue));
+    _ReadWriteBarrier();
+#else
+    if constexpr (std::is_trivially_copyable_v<T> &&
+                  (sizeof(T) <= sizeof(void *)))
+    {
+#if defined(__clang__)
+        asm volatile("" : "+r,m"(aValue) : : "memory");
+#else
+        asm volatile("" : "+m,r"(aValue) : : "memory");
+#endif
+    }
+    else
+    {
+        asm volatile("" : "+m"(aValue) : : "memory");
+    }
+#endif
+}
+
+// Forces all pending writes to memory to be treated as observable.
+inline void clobber() noexcept
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    _ReadWriteBarrier();
+#else
+    asm volatile("" : : : "memory");
+#endif
+}
+
+struct settings
+{
+    // Time spent running the body before any sample is taken; the iteration
+    // count is calibrated during this phase.
+    std::chrono::nanoseconds warmup{std::chrono::milliseconds(20)};
+    // A sample runs the body often enough to last at least this long.
+    std::chrono::nanoseconds min_sample_time{std::chrono::microseconds(200)};
+    std::size_t samples{50};
+    std::size_t max_iterations{std::size_t{1} << 30};
+    // Samples whose modified z-score exceeds this are rejected.
+    double outlier_threshold{3.5};
+};
+
+struct summary
+{
+    std::size_t count{};
+    std::size_t outliers{};
+    double min{};
+    double max{};
+    double mean{};
+    double median{};
+    double mad{};
+    double p90{};
+    double p99{};
+};
+
+// All times are nanoseconds per iteration.
+struct result
+{
+    std::string name;
+    std::size_t iterations{};
+    double overhead_ns{};
+    summary stats;
+};
+
+// aPercentile (0-100) of sorted values, interpolated linearly.
+inline double percentile(const std::vector<double> &aSorted,
+                         double aPercentile) noexcept
+{
+    if (aSorted.empty())
+    {
+        return 0.0;
+    }
+    const double pos = std::clamp(aPercentile, 0.0, 100.0) / 100.0 *
+                       static_cast<double>(aSorted.size() - 1);
+    const auto lower = static_cast<std::size_t>(pos);
+    const std::size_t upper = std::min(lower + 1, aSorted.size() - 1);
+    const double fraction = pos - static_cast<double>(lower);
+    return aSorted[lower] + (aSorted[upper] - aSorted[lower]) * fraction;
+}
+
+namespace details
+{
+inline double median_absolute_deviation(const std::vector<double> &aSorted,
+                                        double aMedian) noexcept
+{
+    std::vector<double> deviations(aSorted.size());
+    std::transform(aSorted.begin(), aSorted.end(), deviations.begin(),
+                   [aMedian](double aValue) noexcept
+                   { return std::abs(aValue - aMedian); });
+    std::sort(deviations.begin(), deviations.end());
+    return percentile(deviations, 50.0);
+}
+}  // namespace details
+
+// Drops outliers from aSamples (by modified z-score against the median and
+// MAD) and describes the rest. aSamples is left sorted.
+inline summary summarize(std::vector<double> &aSamples,
+                         double aOutlierThreshold) noexcept
+{
+    summary s;
+    std::sort(aSamples.begin(), aSamples.end());
+    const double median = percentile(aSamples, 50.0);
+    const double mad = details::median_absolute_deviation(aSamples, median);
+    if (mad > 0.0)
+    {
+        // 0.6745 scales the MAD to the standard deviation of a normal
+        // distribution.
+        const auto last = std::remove_if(
+            aSamples.begin(), aSamples.end(),
+            [=](double aValue) noexcept {
+                return 0.6745 * std::abs(aValue - median) / mad >
+                       aOutlierThreshold;
+            });
+        s.outliers = static_cast<std::size_t>(aSamples.end() - last);
+        aSamples.erase(last, aSamples.end());
+    }
+
+    s.count = aSamples.size();
+    if (!s.count)
+    {
+        return s;
+    }
+    s.min = aSamples.front();
+    s.max = aSamples.back();
+    double sum = 0.0;
+    for (const double v: aSamples)
+    {
+        sum += v;
+    }
+    s.mean = sum / static_cast<double>(s.count);
+    s.median = percentile(aSamples, 50.0);
+    s.mad = details::median_absolute_deviation(aSamples, s.median);
+    s.p90 = percentile(aSamples, 90.0);
+    s.p99 = percentile(aSamples, 99.0);
+    return s;
+}
+
+// Runs benchmark bodies and keeps their results. A body is a callable taking
+// no arguments that performs one iteration; it is timed in batches with a
+// utils::timer over Clock and the cost of the timer itself is subtracted.
+template <typename Clock = std::chrono::steady_clock>
+class basic_runner
+{
+   public:
+    using clock = Clock;
+
+    explicit basic_runner(const settings &aSettings = {}) noexcept
+        : settings_(aSettings), overhead_ns_(measure_overhead())
+    {
+    }
+
+    template <typename Body>
+    const result &run(std::string aName, Body &&aBody) noexcept
+    {
+        std::size_t iterations = calibrate(aBody);
+
+        std::vector<double> samples;
+        samples.reserve(settings_.samples);
+        for (std::size_t i = 0; i < settings_.samples; ++i)
+        {
+            const double elapsed = time_batch(aBody, iterations);
+            samples.push_back(std::max(elapsed - overhead_ns_, 0.0) /
+                              static_cast<double>(iterations));
+        }
+
+        result r;
+        r.name = std::move(aName);
+        r.iterations = iterations;
+        r.overhead_ns = overhead_ns_;
+        r.stats = summarize(samples, settings_.outlier_threshold);
+        results_.push_back(std::move(r));
+        return results_.back();
+    }
+
+    const std::vector<result> &results() const noexcept { return results_; }
+
+    void clear() noexcept { results_.clear(); }
+
+    const settings &config() const noexcept { return settings_; }
+
+    // Median cost of starting and stopping one timer, in nanoseconds.
+    double timer_overhead() const noexcept { return overhead_ns_; }
+
+   private:
+    using duration = typename Clock::duration;
+
+    struct elapsed_sink
+    {
+        duration *elapsed;
+
+        template <typename Timer>
+        void operator()(const Timer &aTimer) const noexcept
+        {
+            *elapsed = aTimer.leaked();
+        }
+    };
+
+    using timer_type =
+        ::utils::details::timer<alignof(elapsed_sink), sizeof(elapsed_sink),
+                                Clock>;
+
+    template <typename Body>
+    static double time_batch(Body &aBody, std::size_t aIterations) noexcept
+    {
+        duration elapsed{};
+        {
+            timer_type t(elapsed_sink{&elapsed});
+            for (std::size_t i = 0; i < aIterations; ++i)
+            {
+                aBody();
+            }
+        }
+        return std::chrono::duration<double, std::nano>(elapsed).count();
+    }
+
+    static double measure_overhead() noexcept
+    {
+        constexpr std::size_t kRounds = 1001;
+        auto empty = []() noexcept {};
+        std::vector<double> samples(kRounds);
+        for (auto &s: samples)
+        {
+            s = time_batch(empty, 0);
+        }
+        std::sort(samples.begin(), samples.end());
+        return percentile(samples, 50.0);
+    }
+
+    // Warms the body up while doubling the batch size until one batch lasts
+    // min_sample_time.
+    template <typename Body>
+    std::size_t calibrate(Body &aBody) const noexcept
+    {
+        using ns = std::chrono::duration<double, std::nano>;
+        const double target = ns(settings_.min_sample_time).count();
+        const double warmup = ns(settings_.warmup).count();
+        const std::size_t limit = std::max<std::size_t>(
+            settings_.max_iterations, 1);
+
+        std::size_t iterations = 1;
+        double spent = 0.0;
+        for (;;)
+        {
+            const double elapsed = time_batch(aBody, iterations);
+            spent += elapsed;
+            const bool long_enough = elapsed - overhead_ns_ >= target;
+            if (long_enough || (iterations >= limit))
+            {
+                if (spent >= warmup)
+                {
+                    return iterations;
+                }
+            }
+            else
+            {
+                iterations = std::min(iterations * 2, limit);
+            }
+        }
+    }
+
+    settings settings_;
+    double overhead_ns_{};
+    std::vector<result> results_;
+};
+
+using runner = basic_runner<>;
+
+template <typename T>
+struct case_tag
+{
+    using type = T;
+};
+
+namespace details
+{
+template <typename T>
+bool append_value(std::string &aName, const T &aValue) noexcept
+{
+    if constexpr (std::is_same_v<T, bool>)
+    {
+        aName += aValue ? "true" : "false";
+    }
+    else if constexpr (std::is_integral_v<T>)
+    {
+        aName += std::to_string(aValue);
+    }
+    else if constexpr (std::is_enum_v<T>)
+    {
+        aName += std::to_string(static_cast<std::underlying_type_t<T>>(aValue));
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+template <typename Case>
+struct case_name
+{
+    static bool append(std::string &) noexcept { return false; }
+};
+
+template <decltype(auto)... Values>
+struct case_name<value_list<Values...>>
+{
+    static bool append(std::string &aName) noexcept
+    {
+        std::string suffix;
+        const bool printable =
+            (... && (suffix += '/', append_value(suffix, Values)));
+        if (printable)
+        {
+            aName += suffix;
+        }
+        return printable;
+    }
+};
+
+template <typename Cases>
+struct sweep_cases;
+
+template <typename... Ts>
+struct sweep_cases<type_list<Ts...>>
+{
+    using type = type_list<Ts...>;
+};
+
+template <decltype(auto)... Values>
+struct sweep_cases<value_list<Values...>>
+{
+    using type = type_list<value_list<Values>...>;
+};
+
+template <typename Runner, typename Factory, typename... Cases>
+void run_cases(Runner &aRunner, std::string_view aName, Factory &aFactory,
+               type_list<Cases...>) noexcept
+{
+    std::size_t index = 0;
+    (...,
+     [&]
+     {
+         std::string name(aName);
+         if (!case_name<Cases>::append(name))
+         {
+             name += '/';
+             name += std::to_string(index);
+         }
+         ++index;
+         aRunner.run(std::move(name), aFactory(case_tag<Cases>{}));
+     }());
+}
+}  // namespace details
+
+// Runs one benchmark per element of Cases, which is a value_list (such as
+// values_in_range_t<...>) or a type_list (such as the cartesian_product_t of
+// several lists). aFactory receives case_tag<Case> and returns the body to
+// run; value_list elements arrive as one-element value_lists. Results are
+// named aName followed by the case's values, or by its index for types.
+template <typename Cases, typename Runner, typename Factory>
+void sweep(Runner &aRunner, std::string_view aName, Factory &&aFactory) noexcept
+{
+    details::run_cases(aRunner, aName, aFactory,
+                       typename details::sweep_cases<Cases>::type{});
+}
+
+namespace details
+{
+inline bool write_json_string(std::FILE *aFile,
+                              std::string_view aText) noexcept
+{
+    bool ok = std::fputc('"', aFile) != EOF;
+    for (const char c: aText)
+    {
+        if ((c == '"') || (c == '\\'))
+        {
+            ok &= std::fputc('\\', aFile) != EOF;
+        }
+        if (static_cast<unsigned char>(c) < 0x20)
+        {
+            ok &= std::fprintf(aFile, "\\u%04x", c) > 0;
+            continue;
+        }
+        ok &= std::fputc(c, aFile) != EOF;
+    }
+    return (std::fputc('"', aFile) != EOF) && ok;
+}
+
+inline bool write_csv_string(std::FILE *aFile, std::string_view aText) noexcept
+{
+    if (aText.find_first_of(",\"\n") == std::string_view::npos)
+    {
+        return std::fwrite(aText.data(), 1, aText.size(), aFile) ==
+               aText.size();
+    }
+    bool ok = std::fputc('"', aFile) != EOF;
+    for (const char c: aText)
+    {
+        if (c == '"')
+        {
+            ok &= std::fputc('"', aFile) != EOF;
+        }
+        ok &= std::fputc(c, aFile) != EOF;
+    }
+    return (std::fputc('"', aFile) != EOF) && ok;
+}
+}  // namespace details
+
+// One header line, then one line per result. Returns false if a write failed.
+inline bool write_csv(std::FILE *aFile,
+                      const std::vector<result> &aResults) noexcept
+{
+    bool ok = std::fputs("name,iterations,samples,outliers,median_ns,mad_ns,"
+                         "mean_ns,min_ns,max_ns,p90_ns,p99_ns,overhead_ns\n",
+                         aFile) >= 0;
+    for (const auto &r: aResults)
+    {
+        ok &= details::write_csv_string(aFile, r.name);
+        ok &= std::fprintf(aFile, ",%zu,%zu,%zu,%g,%g,%g,%g,%g,%g,%g,%g\n",
+                           r.iterations, r.stats.count, r.stats.outliers,
+                           r.stats.median, r.stats.mad, r.stats.mean,
+                           r.stats.min, r.stats.max, r.stats.p90, r.stats.p99,
+                           r.overhead_ns) > 0;
+    }
+    return ok;
+}
+
+inline bool write_json(std::FILE *aFile,
+                       const std::vector<result> &aResults) noexcept
+{
+    bool ok = std::fputs("{\"benchmarks\":[", aFile) >= 0;
+    bool first = true;
+    for (const auto &r: aResults)
+    {
+        ok &= std::fputs(first ? "\n{\"name\":" : ",\n{\"name\":", aFile) >= 0;
+        first = false;
+        ok &= details::write_json_string(aFile, r.name);
+        ok &= std::fprintf(aFile,
+                           ",\"iterations\":%zu,\"samples\":%zu,"
+                           "\"outliers\":%zu,\"median_ns\":%g,\"mad_ns\":%g,"
+                           "\"mean_ns\":%g,\"min_ns\":%g,\"max_ns\":%g,"
+                           "\"p90_ns\":%g,\"p99_ns\":%g,\"overhead_ns\":%g}",
+                           r.iterations, r.stats.count, r.stats.outliers,
+                           r.stats.median, r.stats.mad, r.stats.mean,
+                           r.stats.min, r.stats.max, r.stats.p90, r.stats.p99,
+                           r.overhead_ns) > 0;
+    }
+    return (std::fputs("\n]}\n", aFile) >= 0) && ok;
+}
+}  // namespace bench
+}  // namespace utils
+
+#endif /* utils_benchmark_h */
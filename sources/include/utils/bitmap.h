@@ -0,0 +1,284 @@
+#ifndef utils_bitmap_h
+#define utils_bitmap_h
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include "common.h"
+#include "cpu_features.h"
+#include "ctz.h"
+#include "simd.h"
+
+// Operations on bitmaps stored as arrays of 64-bit words, bit i being bit
+// i % 64 of word i / 64. aSize is the bitmap length in bits; bits of the
+// last word past aSize may hold anything. Searches return aSize when there
+// is no match.
+namespace utils
+{
+namespace bitmap
+{
+inline constexpr std::size_t kWordBits = 64;
+
+constexpr std::size_t word_count(std::size_t aSize) noexcept
+{
+    return (aSize + kWordBits - 1) / kWordBits;
+}
+
+inline bool test(const std::uint64_t *aWords, std::size_t aIndex) noexcept
+{
+    return (aWords[aIndex / kWordBits] >> (aIndex % kWordBits)) & 1;
+}
+
+inline void set(std::uint64_t *aWords, std::size_t aIndex) noexcept
+{
+    aWords[aIndex / kWordBits] |= std::uint64_t{1} << (aIndex % kWordBits);
+}
+
+inline void reset(std::uint64_t *aWords, std::size_t aIndex) noexcept
+{
+    aWords[aIndex / kWordBits] &= ~(std::uint64_t{1} << (aIndex % kWordBits));
+}
+
+namespace details
+{
+// Blocks of a cache line are skipped with one vector compare when they hold
+// nothing but the bits that are not searched for.
+inline constexpr std::size_t kBlockWords = 8;
+
+inline bool block_equals(const std::uint64_t *aWords,
+                         std::uint64_t aPattern) noexcept
+{
+    using block_t = simd<std::uint8_t, kBlockWords * sizeof(std::uint64_t)>;
+    const auto bytes =
+        block_t::load(reinterpret_cast<const std::uint8_t *>(aWords));
+    return (bytes == block_t(static_cast<std::uint8_t>(aPattern))).all();
+}
+
+// First bit in [aFrom, aLimit) equal to Set, aLimit if there is none.
+template <bool Set>
+std::size_t find_next(const std::uint64_t *aWords, std::size_t aLimit,
+                      std::size_t aFrom) noexcept
+{
+    if (aFrom >= aLimit)
+    {
+        return aLimit;
+    }
+    constexpr std::uint64_t kFlip = Set ? 0 : ~std::uint64_t{};
+    std::size_t w = aFrom / kWordBits;
+    const std::uint64_t first =
+        (aWords[w] ^ kFlip) & (~std::uint64_t{} << (aFrom % kWordBits));
+    if (first)
+    {
+        const auto bit = static_cast<std::size_t>(ctz(first));
+        return std::min(aLimit, w * kWordBits + bit);
+    }
+    const std::size_t words = word_count(aLimit);
+    ++w;
+    while (w < words)
+    {
+        if ((w + kBlockWords <= words) && block_equals(aWords + w, kFlip))
+        {
+            w += kBlockWords;
+            continue;
+        }
+        const std::size_t end = std::min(words, w + kBlockWords);
+        for (; w < end; ++w)
+        {
+            if (const std::uint64_t word = aWords[w] ^ kFlip)
+            {
+                const auto bit = static_cast<std::size_t>(ctz(word));
+                return std::min(aLimit, w * kWordBits + bit);
+            }
+        }
+    }
+    return aLimit;
+}
+
+constexpr std::size_t popcount(std::uint64_t aWord) noexcept
+{
+    aWord -= (aWord >> 1) & 0x5555555555555555ull;
+    aWord = (aWord & 0x3333333333333333ull) +
+            ((aWord >> 2) & 0x3333333333333333ull);
+    aWord = (aWord + (aWord >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+    return static_cast<std::size_t>((aWord * 0x0101010101010101ull) >> 56);
+}
+
+inline std::size_t popcount_portable(const std::uint64_t *aWords,
+                                     std::size_t aCount) noexcept
+{
+    std::size_t result = 0;
+    for (std::size_t i = 0; i < aCount; ++i)
+    {
+        result += popcount(aWords[i]);
+    }
+    return result;
+}
+
+#if defined(UTILS_CPU_X86) && (defined(__GNUC__) || defined(__clang__))
+UTILS_TARGET("popcnt")
+inline std::size_t popcount_popcnt(const std::uint64_t *aWords,
+                                   std::size_t aCount) noexcept
+{
+    std::size_t result = 0;
+    for (std::size_t i = 0; i < aCount; ++i)
+    {
+        result += static_cast<std::size_t>(__builtin_popcountll(aWords[i]));
+    }
+    return result;
+}
+#endif
+
+using popcount_words_fn = std::size_t(const std::uint64_t *,
+                                      std::size_t) noexcept;
+
+// Resolved on first use to the popcnt instruction when the host has it,
+// whatever the translation unit was compiled for.
+inline const dispatched<popcount_words_fn> &popcount_words() noexcept
+{
+    static const dispatched<popcount_words_fn> kernel{
+#if defined(UTILS_CPU_X86) && (defined(__GNUC__) || defined(__clang__))
+        {&popcount_popcnt, {cpu_feature::kPopcnt}, "popcnt"},
+#endif
+        {&popcount_portable, {}, "portable"}};
+    return kernel;
+}
+
+inline std::uint64_t range_mask(std::size_t aFirst, std::size_t aLast) noexcept
+{
+    // Bits [aFirst, aLast) of one word, 0 <= aFirst < aLast <= 64.
+    const std::uint64_t high =
+        (aLast == kWordBits) ? ~std::uint64_t{}
+                             : (std::uint64_t{1} << aLast) - 1;
+    return high & (~std::uint64_t{} << aFirst);
+}
+
+template <bool Set>
+void fill_range(std::uint64_t *aWords, std::size_t aFirst,
+                std::size_t aLast) noexcept
+{
+    if (aFirst >= aLast)
+    {
+        return;
+    }
+    const std::size_t firstWord = aFirst / kWordBits;
+    const std::size_t lastWord = (aLast - 1) / kWordBits;
+    const auto apply = [aWords](std::size_t aWord, std::uint64_t aMask)
+    {
+        if constexpr (Set)
+        {
+            aWords[aWord] |= aMask;
+        }
+        else
+        {
+            aWords[aWord] &= ~aMask;
+        }
+    };
+    if (firstWord == lastWord)
+    {
+        apply(firstWord, range_mask(aFirst % kWordBits,
+                                    aLast - firstWord * kWordBits));
+        return;
+    }
+    apply(firstWord, range_mask(aFirst % kWordBits, kWordBits));
+    std::fill(aWords + firstWord + 1, aWords + lastWord,
+              Set ? ~std::uint64_t{} : std::uint64_t{});
+    apply(lastWord, range_mask(0, aLast - lastWord * kWordBits));
+}
+}  // namespace details
+
+inline std::size_t find_next_set(const std::uint64_t *aWords,
+                                  std::size_t aSize,
+                                  std::size_t aFrom) noexcept
+{
+    return details::find_next<true>(aWords, aSize, aFrom);
+}
+
+inline std::size_t find_first_set(const std::uint64_t *aWords,
+                                   std::size_t aSize) noexcept
+{
+    return find_next_set(aWords, aSize, 0);
+}
+
+inline std::size_t find_next_clear(const std::uint64_t *aWords,
+                                    std::size_t aSize,
+                                    std::size_t aFrom) noexcept
+{
+    return details::find_next<false>(aWords, aSize, aFrom);
+}
+
+inline std::size_t find_first_clear(const std::uint64_t *aWords,
+                                     std::size_t aSize) noexcept
+{
+    return find_next_clear(aWords, aSize, 0);
+}
+
+// Start of the first run of aCount clear bits at or after aFrom that ends
+// within the bitmap.
+inline std::size_t find_clear_run(const std::uint64_t *aWords,
+                                  std::size_t aSize, std::size_t aCount,
+                                  std::size_t aFrom = 0) noexcept
+{
+    if (aCount == 0)
+    {
+        return std::min(aFrom, aSize);
+    }
+    for (std::size_t start = find_next_clear(aWords, aSize, aFrom);
+         (start < aSize) && (aSize - start >= aCount);)
+    {
+        // Only the next aCount bits matter for this candidate.
+        const std::size_t limit = start + aCount;
+        const std::size_t end = details::find_next<true>(aWords, limit, start);
+        if (end == limit)
+        {
+            return start;
+        }
+        start = find_next_clear(aWords, aSize, end);
+    }
+    return aSize;
+}
+
+// Number of set bits in [aFirst, aLast).
+inline std::size_t count_set(const std::uint64_t *aWords, std::size_t aFirst,
+                             std::size_t aLast) noexcept
+{
+    if (aFirst >= aLast)
+    {
+        return 0;
+    }
+    const std::size_t firstWord = aFirst / kWordBits;
+    const std::size_t lastWord = (aLast - 1) / kWordBits;
+    if (firstWord == lastWord)
+    {
+        return details::popcount(
+            aWords[firstWord] &
+            details::range_mask(aFirst % kWordBits,
+                                aLast - firstWord * kWordBits));
+    }
+    return details::popcount(aWords[firstWord] &
+                             details::range_mask(aFirst % kWordBits,
+                                                 kWordBits)) +
+           details::popcount_words()(aWords + firstWord + 1,
+                                     lastWord - firstWord - 1) +
+           details::popcount(aWords[lastWord] &
+                             details::range_mask(
+                                 0, aLast - lastWord * kWordBits));
+}
+
+// Sets the bits in [aFirst, aLast).
+inline void set_range(std::uint64_t *aWords, std::size_t aFirst,
+                      std::size_t aLast) noexcept
+{
+    details::fill_range<true>(aWords, aFirst, aLast);
+}
+
+// Clears the bits in [aFirst, aLast).
+inline void clear_range(std::uint64_t *aWords, std::size_t aFirst,
+                        std::size_t aLast) noexcept
+{
+    details::fill_range<false>(aWords, aFirst, aLast);
+}
+}  // namespace bitmap
+}  // namespace utils
+
+#endif /* utils_bitmap_h */
@@ -0,0 +1,254 @@
+#ifndef utils_clocks_h
+#define utils_clocks_h
+
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+
+#include "timer.h"
+
+namespace utils
+{
+namespace details
+{
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || \
+    defined(_M_IX86)
+// CPUID.80000007H:EDX[8]: the TSC ticks at a constant rate in every P-, C-
+// and T-state, so it can be used as a wall clock.
+inline bool has_invariant_tsc() noexcept
+{
+#if defined(_MSC_VER)
+    int regs[4]{};
+    __cpuid(regs, 0x80000000);
+    if (static_cast<unsigned>(regs[0]) < 0x80000007u)
+    {
+        return false;
+    }
+    __cpuid(regs, 0x80000007);
+    return regs[3] & (1 << 8);
+#else
+    unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
+    if (!__get_cpuid(0x80000007u, &eax, &ebx, &ecx, &edx))
+    {
+        return false;
+    }
+    return edx & (1u << 8);
+#endif
+}
+
+template <bool Serialized>
+inline std::uint64_t read_tsc() noexcept
+{
+    if constexpr (Serialized)
+    {
+        unsigned int aux = 0;
+        return __rdtscp(&aux);
+    }
+    else
+    {
+        return __rdtsc();
+    }
+}
+#else
+inline bool has_invariant_tsc() noexcept { return false; }
+
+template <bool Serialized>
+inline std::uint64_t read_tsc() noexcept
+{
+    return 0;
+}
+#endif
+
+struct tsc_calibration
+{
+    bool invariant{};
+    double ns_per_tick{};
+    std::uint64_t base_ticks{};
+    std::int64_t base_ns{};
+};
+
+inline std::int64_t steady_ns() noexcept
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+inline constexpr std::int64_t kTscCalibrationNs = 20'000'000;
+inline constexpr int kTscSampleAttempts = 16;
+
+// Reads steady_clock bracketed by two TSC reads and returns the TSC midpoint.
+// Of kTscSampleAttempts tries the narrowest bracket is kept: a wide one means
+// the thread was interrupted between the reads and the midpoint is off.
+inline std::int64_t sample_tsc(std::uint64_t &aTicks) noexcept
+{
+    std::uint64_t best_width = ~std::uint64_t{};
+    std::int64_t best_ns = 0;
+    for (int i = 0; i < kTscSampleAttempts; ++i)
+    {
+        const std::uint64_t before = read_tsc<true>();
+        const std::int64_t ns = steady_ns();
+        const std::uint64_t after = read_tsc<true>();
+        if ((after >= before) && (after - before < best_width))
+        {
+            best_width = after - before;
+            best_ns = ns;
+            aTicks = before + best_width / 2;
+        }
+    }
+    return best_ns;
+}
+
+// Measures the TSC rate against steady_clock over kTscCalibrationNs. Each end
+// of the interval is the narrowest of kTscSampleAttempts samples.
+inline tsc_calibration calibrate_tsc() noexcept
+{
+    tsc_calibration result;
+    if (!has_invariant_tsc())
+    {
+        return result;
+    }
+
+    std::uint64_t first_ticks = 0;
+    std::uint64_t last_ticks = 0;
+    const std::int64_t first_ns = sample_tsc(first_ticks);
+    while (steady_ns() - first_ns < kTscCalibrationNs)
+    {
+    }
+    const std::int64_t last_ns = sample_tsc(last_ticks);
+    if ((last_ticks <= first_ticks) || (last_ns <= first_ns))
+    {
+        return result;
+    }
+
+    result.invariant = true;
+    result.ns_per_tick = static_cast<double>(last_ns - first_ns) /
+                         static_cast<double>(last_ticks - first_ticks);
+    result.base_ticks = last_ticks;
+    result.base_ns = last_ns;
+    return result;
+}
+
+// Calibrated once per process, on first use; see calibrate_tsc_clock().
+inline const tsc_calibration &tsc_calibration_data() noexcept
+{
+    static const tsc_calibration calibration = calibrate_tsc();
+    return calibration;
+}
+}  // namespace details
+
+// Clock reading the x86 time-stamp counter and converting it to nanoseconds
+// with a rate calibrated against steady_clock, whose epoch it shares. Without
+// an invariant TSC (or on other architectures) it forwards to steady_clock.
+// The Serialized flavour uses rdtscp, which waits for earlier instructions to
+// complete before reading the counter.
+template <bool Serialized>
+class basic_tsc_clock
+{
+   public:
+    using duration = std::chrono::nanoseconds;
+    using rep = duration::rep;
+    using period = duration::period;
+    using time_point = std::chrono::time_point<basic_tsc_clock>;
+
+    static constexpr bool is_steady = true;
+
+    static time_point now() noexcept
+    {
+        const auto &c = details::tsc_calibration_data();
+        if (!c.invariant)
+        {
+            return time_point(duration(details::steady_ns()));
+        }
+        const auto ticks = static_cast<std::int64_t>(
+            details::read_tsc<Serialized>() - c.base_ticks);
+        return time_point(duration(
+            c.base_ns +
+            static_cast<rep>(static_cast<double>(ticks) * c.ns_per_tick)));
+    }
+
+    static bool uses_tsc() noexcept
+    {
+        return details::tsc_calibration_data().invariant;
+    }
+
+    // Calibrated counter frequency, 0 when the fallback is in use.
+    static double frequency_hz() noexcept
+    {
+        const auto &c = details::tsc_calibration_data();
+        return c.invariant ? 1e9 / c.ns_per_tick : 0.0;
+    }
+
+    // Raw counter value, for callers that convert only at the end.
+    static std::uint64_t ticks() noexcept
+    {
+        return details::read_tsc<Serialized>();
+    }
+};
+
+using tsc_clock = basic_tsc_clock<false>;
+using tscp_clock = basic_tsc_clock<true>;
+
+// Runs the one-off calibration behind tsc_clock and tscp_clock, which spins
+// for kTscCalibrationNs. The first clock call does it otherwise; call this
+// at startup to keep the stall out of the first measurement. Returns
+// whether the TSC is in use.
+inline bool calibrate_tsc_clock() noexcept
+{
+    return details::tsc_calibration_data().invariant;
+}
+
+// CLOCK_MONOTONIC_COARSE: the time of the last scheduler tick, read without
+// touching the hardware counter. Much cheaper than steady_clock but only as
+// precise as resolution(). Falls back to steady_clock where unavailable.
+class coarse_steady_clock
+{
+   public:
+    using duration = std::chrono::nanoseconds;
+    using rep = duration::rep;
+    using period = duration::period;
+    using time_point = std::chrono::time_point<coarse_steady_clock>;
+
+    static constexpr bool is_steady = true;
+
+    static time_point now() noexcept
+    {
+#if defined(CLOCK_MONOTONIC_COARSE)
+        timespec ts{};
+        ::clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+        return time_point(std::chrono::seconds(ts.tv_sec) +
+                          std::chrono::nanoseconds(ts.tv_nsec));
+#else
+        return time_point(duration(details::steady_ns()));
+#endif
+    }
+
+    static duration resolution() noexcept
+    {
+#if defined(CLOCK_MONOTONIC_COARSE)
+        timespec ts{};
+        ::clock_getres(CLOCK_MONOTONIC_COARSE, &ts);
+        return std::chrono::seconds(ts.tv_sec) +
+               std::chrono::nanoseconds(ts.tv_nsec);
+#else
+        return std::chrono::duration_cast<duration>(
+            std::chrono::steady_clock::duration(1));
+#endif
+    }
+};
+
+using tsc_timer = details::timer<alignof(void (*)(int &)),
+                                 sizeof(void (*)(int &)), tsc_clock>;
+using coarse_timer = details::timer<alignof(void (*)(int &)),
+                                    sizeof(void (*)(int &)),
+                                    coarse_steady_clock>;
+}  // namespace utils
+
+#endif /* utils_clocks_h */
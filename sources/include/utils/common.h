@@ -1062,6 +1062,12 @@ struct unwrap_reference<std::reference_wrapper<T>>
 template <typename T>
 using unwrap_reference_t = typename unwrap_reference<T>::type;
 
+#if defined(__APPLE__) && defined(__aarch64__)
+inline constexpr std::size_t kCacheLineSize = 128;
+#else
+inline constexpr std::size_t kCacheLineSize = 64;
+#endif
+
 template <typename T>
 inline constexpr decltype(auto) shift_right(T&& aValue,
                                             const std::size_t aNumBits) noexcept
@@ -0,0 +1,342 @@
+#ifndef utils_cpu_features_h
+#define utils_cpu_features_h
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include "common.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || \
+    defined(_M_IX86)
+#define UTILS_CPU_X86 1
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+// Compiles one function for a wider instruction set than the translation
+// unit, e.g. UTILS_TARGET("avx2,bmi2"). It must only be called once
+// cpu_features reported the instructions. MSVC emits any instruction set
+// without it.
+#ifndef UTILS_TARGET
+#if defined(__GNUC__) || defined(__clang__)
+#define UTILS_TARGET(features) __attribute__((target(features)))
+#else
+#define UTILS_TARGET(features)
+#endif
+#else
+#error "UTILS_TARGET already defined somewhere"
+#endif
+
+namespace utils
+{
+enum class cpu_feature : std::uint8_t
+{
+    kSse2,
+    kSse3,
+    kSsse3,
+    kSse41,
+    kSse42,
+    kPopcnt,
+    kLzcnt,
+    kBmi1,
+    kBmi2,
+    kFma,
+    kAvx,
+    kAvx2,
+    kAvx512f,
+    kAvx512dq,
+    kAvx512bw,
+    kAvx512vl,
+};
+
+inline constexpr std::size_t kCpuFeatureCount = 16;
+
+constexpr std::string_view cpu_feature_name(cpu_feature aFeature) noexcept
+{
+    constexpr std::string_view kNames[kCpuFeatureCount] = {
+        "sse2",  "sse3", "ssse3", "sse4.1",  "sse4.2",   "popcnt",
+        "lzcnt", "bmi1", "bmi2",  "fma",     "avx",      "avx2",
+        "avx512f", "avx512dq", "avx512bw", "avx512vl"};
+    return kNames[static_cast<std::size_t>(aFeature)];
+}
+
+// A set of cpu_feature. Features needing operating system support (AVX and
+// AVX-512 register state) are only reported by detect() when the OS saves
+// that state on context switches.
+class cpu_features
+{
+   public:
+    constexpr cpu_features() noexcept = default;
+
+    constexpr cpu_features(
+        std::initializer_list<cpu_feature> aFeatures) noexcept
+    {
+        for (const cpu_feature feature: aFeatures)
+        {
+            set(feature);
+        }
+    }
+
+    constexpr cpu_features &set(cpu_feature aFeature) noexcept
+    {
+        bits_ |= bit(aFeature);
+        return *this;
+    }
+
+    constexpr cpu_features &reset(cpu_feature aFeature) noexcept
+    {
+        bits_ &= ~bit(aFeature);
+        return *this;
+    }
+
+    constexpr bool has(cpu_feature aFeature) const noexcept
+    {
+        return bits_ & bit(aFeature);
+    }
+
+    constexpr bool has_all(cpu_features aRequired) const noexcept
+    {
+        return (bits_ & aRequired.bits_) == aRequired.bits_;
+    }
+
+    constexpr bool empty() const noexcept { return !bits_; }
+
+    constexpr std::uint32_t bits() const noexcept { return bits_; }
+
+    friend constexpr cpu_features operator|(cpu_features aLhs,
+                                            cpu_features aRhs) noexcept
+    {
+        aLhs.bits_ |= aRhs.bits_;
+        return aLhs;
+    }
+
+    friend constexpr cpu_features operator&(cpu_features aLhs,
+                                            cpu_features aRhs) noexcept
+    {
+        aLhs.bits_ &= aRhs.bits_;
+        return aLhs;
+    }
+
+    friend constexpr bool operator==(cpu_features aLhs,
+                                     cpu_features aRhs) noexcept
+    {
+        return aLhs.bits_ == aRhs.bits_;
+    }
+
+    friend constexpr bool operator!=(cpu_features aLhs,
+                                     cpu_features aRhs) noexcept
+    {
+        return !(aLhs == aRhs);
+    }
+
+    // Queries the executing CPU with cpuid. Empty on other architectures.
+    static cpu_features detect() noexcept
+    {
+        cpu_features result;
+#ifdef UTILS_CPU_X86
+        std::uint32_t r[4]{};
+        if (!cpuid(0, 0, r))
+        {
+            return result;
+        }
+        const std::uint32_t maxLeaf = r[0];
+
+        cpuid(1, 0, r);
+        const std::uint32_t ecx1 = r[2];
+        const std::uint32_t edx1 = r[3];
+        result.set_if(edx1 & (1u << 26), cpu_feature::kSse2);
+        result.set_if(ecx1 & (1u << 0), cpu_feature::kSse3);
+        result.set_if(ecx1 & (1u << 9), cpu_feature::kSsse3);
+        result.set_if(ecx1 & (1u << 19), cpu_feature::kSse41);
+        result.set_if(ecx1 & (1u << 20), cpu_feature::kSse42);
+        result.set_if(ecx1 & (1u << 23), cpu_feature::kPopcnt);
+
+        // XCR0 bits 1 and 2: SSE and AVX state; 5 to 7: AVX-512 state.
+        const bool osxsave = ecx1 & (1u << 27);
+        const std::uint64_t xcr0 = osxsave ? xgetbv() : 0;
+        const bool avxState = (xcr0 & 0x6) == 0x6;
+        const bool avx512State = (xcr0 & 0xE6) == 0xE6;
+        result.set_if(avxState && (ecx1 & (1u << 28)), cpu_feature::kAvx);
+        result.set_if(avxState && (ecx1 & (1u << 12)), cpu_feature::kFma);
+
+        if (maxLeaf >= 7)
+        {
+            cpuid(7, 0, r);
+            const std::uint32_t ebx7 = r[1];
+            result.set_if(ebx7 & (1u << 3), cpu_feature::kBmi1);
+            result.set_if(ebx7 & (1u << 8), cpu_feature::kBmi2);
+            result.set_if(avxState && (ebx7 & (1u << 5)), cpu_feature::kAvx2);
+            result.set_if(avx512State && (ebx7 & (1u << 16)),
+                          cpu_feature::kAvx512f);
+            result.set_if(avx512State && (ebx7 & (1u << 17)),
+                          cpu_feature::kAvx512dq);
+            result.set_if(avx512State && (ebx7 & (1u << 30)),
+                          cpu_feature::kAvx512bw);
+            result.set_if(avx512State && (ebx7 & (1u << 31)),
+                          cpu_feature::kAvx512vl);
+        }
+
+        cpuid(0x80000000u, 0, r);
+        if (r[0] >= 0x80000001u)
+        {
+            cpuid(0x80000001u, 0, r);
+            result.set_if(r[2] & (1u << 5), cpu_feature::kLzcnt);
+        }
+#endif
+        return result;
+    }
+
+   private:
+    static constexpr std::uint32_t bit(cpu_feature aFeature) noexcept
+    {
+        return std::uint32_t{1} << static_cast<unsigned>(aFeature);
+    }
+
+    constexpr void set_if(bool aCondition, cpu_feature aFeature) noexcept
+    {
+        if (aCondition)
+        {
+            set(aFeature);
+        }
+    }
+
+#ifdef UTILS_CPU_X86
+    static bool cpuid(std::uint32_t aLeaf, std::uint32_t aSubleaf,
+                      std::uint32_t (&aRegs)[4]) noexcept
+    {
+#if defined(_MSC_VER) && !defined(__clang__)
+        int regs[4]{};
+        __cpuidex(regs, static_cast<int>(aLeaf), static_cast<int>(aSubleaf));
+        for (std::size_t i = 0; i < 4; ++i)
+        {
+            aRegs[i] = static_cast<std::uint32_t>(regs[i]);
+        }
+        return true;
+#else
+        unsigned regs[4]{};
+        const bool ok = __get_cpuid_count(aLeaf, aSubleaf, &regs[0], &regs[1],
+                                          &regs[2], &regs[3]);
+        for (std::size_t i = 0; i < 4; ++i)
+        {
+            aRegs[i] = ok ? regs[i] : 0;
+        }
+        return ok;
+#endif
+    }
+
+    static std::uint64_t xgetbv() noexcept
+    {
+#if defined(_MSC_VER) && !defined(__clang__)
+        return _xgetbv(0);
+#else
+        // The instruction rather than _xgetbv(), which needs -mxsave.
+        std::uint32_t eax{};
+        std::uint32_t edx{};
+        __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+        return (std::uint64_t{edx} << 32) | eax;
+#endif
+    }
+#endif
+
+    std::uint32_t bits_{};
+};
+
+// Features of the executing CPU, detected on first use.
+inline const cpu_features &host_cpu_features() noexcept
+{
+    static const cpu_features features = cpu_features::detect();
+    return features;
+}
+
+// One implementation of a kernel and the features it was compiled for.
+template <typename Fn>
+struct kernel_variant
+{
+    static_assert(std::is_function_v<Fn>);
+
+    Fn *function;
+    cpu_features required;
+    std::string_view name;
+};
+
+// The first variant whose requirements aFeatures satisfies, so variants are
+// listed best first. Its function is nullptr if none qualifies.
+template <typename Fn>
+constexpr kernel_variant<Fn> select_kernel(
+    std::initializer_list<kernel_variant<Fn>> aVariants,
+    cpu_features aFeatures) noexcept
+{
+    for (const auto &variant: aVariants)
+    {
+        if (aFeatures.has_all(variant.required))
+        {
+            return variant;
+        }
+    }
+    return {};
+}
+
+// A kernel resolved once, at construction, to the best variant the host
+// supports; every call is then a plain indirect call without any feature
+// test. Keep it in a function-local static, so that it is resolved on first
+// use rather than during static initialization, where another initializer
+// could call it before it is constructed:
+//
+//   using popcount_fn = std::size_t(const std::uint64_t *,
+//                                   std::size_t) noexcept;
+//
+//   inline const utils::dispatched<popcount_fn> &popcount() noexcept
+//   {
+//       static const utils::dispatched<popcount_fn> kernel{
+//           {&popcount_avx2, {utils::cpu_feature::kAvx2}, "avx2"},
+//           {&popcount_popcnt, {utils::cpu_feature::kPopcnt}, "popcnt"},
+//           {&popcount_portable, {}, "portable"}};
+//       return kernel;
+//   }
+//
+// The last variant should require nothing; construction aborts when no
+// variant qualifies.
+template <typename Fn>
+class dispatched
+{
+    static_assert(std::is_function_v<Fn>);
+
+   public:
+    using function_type = Fn;
+
+    dispatched(std::initializer_list<kernel_variant<Fn>> aVariants,
+               cpu_features aFeatures = host_cpu_features()) noexcept
+    {
+        const kernel_variant<Fn> variant = select_kernel(aVariants, aFeatures);
+        UTILS_ABORT_IF_REASON(!variant.function,
+                              "no kernel variant supports this CPU");
+        function_ = variant.function;
+        name_ = variant.name;
+    }
+
+    template <typename... Args>
+    decltype(auto) operator()(Args &&...aArgs) const
+        noexcept(std::is_nothrow_invocable_v<Fn *, Args &&...>)
+    {
+        return function_(std::forward<Args>(aArgs)...);
+    }
+
+    Fn *get() const noexcept { return function_; }
+
+    // Name of the selected variant.
+    std::string_view name() const noexcept { return name_; }
+
+   private:
+    Fn *function_{};
+    std::string_view name_;
+};
+}  // namespace utils
+
+#endif /* utils_cpu_features_h */
@@ -3,6 +3,11 @@
 
 #include <new>
 #include <type_traits>
+#include <utility>
+
+#include "common.h"
+#include "memory/memory.h"
+#include "memory/relocate.h"
 
 namespace utils
 {
@@ -103,6 +108,277 @@ class fast_pimpl final
    private:
     alignas(Alignment) std::byte data_[Size]{};
 };
+
+template <typename T, std::size_t Capacity, std::size_t Alignment>
+struct is_pimpl_inline
+    : std::bool_constant<(sizeof(T) <= Capacity) && (alignof(T) <= Alignment)>
+{
+};
+
+template <typename T, std::size_t Capacity, std::size_t Alignment>
+inline constexpr bool is_pimpl_inline_v =
+    is_pimpl_inline<T, Capacity, Alignment>::value;
+
+namespace details
+{
+template <typename T>
+[[deprecated(
+    "T does not fit into the inline storage of flex_pimpl and is allocated "
+    "from memory_resource")]] constexpr void
+report_pimpl_spill() noexcept
+{
+}
+}  // namespace details
+
+template <typename T, std::size_t Capacity,
+          std::size_t Alignment = alignof(std::max_align_t)>
+class flex_pimpl final
+{
+    struct heap_storage
+    {
+        T *ptr;
+        memory::memory_resource *resource;
+    };
+
+    static_assert(Capacity >= sizeof(heap_storage),
+                  "Error: Capacity must be enough to hold heap_storage");
+    static_assert(Alignment >= alignof(heap_storage),
+                  "Error: Alignment must be enough to hold heap_storage");
+
+   public:
+    ~flex_pimpl()
+    {
+        if constexpr (is_inline())
+        {
+            get().~T();
+        }
+        else
+        {
+            destroy(heap());
+        }
+    }
+
+    flex_pimpl() noexcept(std::is_nothrow_constructible_v<T>)
+        : flex_pimpl(memory::get_default_resource(), forwarding_constructor{})
+    {
+    }
+
+    template <typename... Args>
+    explicit flex_pimpl(forwarding_constructor, Args &&...args) noexcept(
+        std::is_nothrow_constructible_v<T, Args...>)
+        : flex_pimpl(memory::get_default_resource(), forwarding_constructor{},
+                     std::forward<Args>(args)...)
+    {
+    }
+
+    template <typename... Args>
+    flex_pimpl(
+        memory::memory_resource *aResource, forwarding_constructor,
+        Args &&...args) noexcept(std::is_nothrow_constructible_v<T, Args...>)
+    {
+        new (place(aResource)) T(std::forward<Args>(args)...);
+    }
+
+    flex_pimpl(const flex_pimpl &aOther) noexcept(
+        std::is_nothrow_copy_constructible_v<T>)
+        : flex_pimpl(aOther.resource(), forwarding_constructor{}, aOther.get())
+    {
+    }
+
+    flex_pimpl(const T &aOther) noexcept(
+        std::is_nothrow_copy_constructible_v<T>)
+        : flex_pimpl(memory::get_default_resource(), forwarding_constructor{},
+                     aOther)
+    {
+    }
+
+    flex_pimpl(flex_pimpl &&aOther) noexcept(
+        std::is_nothrow_move_constructible_v<T> || !is_inline())
+    {
+        if constexpr (is_inline())
+        {
+            new (data_) T(std::move(aOther.get()));
+        }
+        else
+        {
+            heap() = std::exchange(aOther.heap(), heap_storage{});
+        }
+    }
+
+    flex_pimpl(T &&aOther) noexcept(std::is_nothrow_move_constructible_v<T>)
+        : flex_pimpl(memory::get_default_resource(), forwarding_constructor{},
+                     std::move(aOther))
+    {
+    }
+
+    flex_pimpl &operator=(const flex_pimpl &aOther) noexcept(
+        std::is_nothrow_copy_assignable_v<T> &&
+        (is_inline() || std::is_nothrow_copy_constructible_v<T>))
+    {
+        return assign(aOther.get());
+    }
+
+    flex_pimpl &operator=(const T &aOther) noexcept(
+        std::is_nothrow_copy_assignable_v<T> &&
+        (is_inline() || std::is_nothrow_copy_constructible_v<T>))
+    {
+        return assign(aOther);
+    }
+
+    flex_pimpl &operator=(flex_pimpl &&aOther) noexcept(
+        std::is_nothrow_move_assignable_v<T> || !is_inline())
+    {
+        if constexpr (is_inline())
+        {
+            get() = std::move(aOther.get());
+        }
+        else
+        {
+            std::swap(heap(), aOther.heap());
+        }
+        return *this;
+    }
+
+    flex_pimpl &operator=(T &&aOther) noexcept(
+        std::is_nothrow_move_assignable_v<T> &&
+        (is_inline() || std::is_nothrow_move_constructible_v<T>))
+    {
+        return assign(std::move(aOther));
+    }
+
+    T *operator->() noexcept { return &get(); }
+
+    const T *operator->() const noexcept { return &get(); }
+
+    static constexpr bool is_inline() noexcept
+    {
+        return is_pimpl_inline_v<T, Capacity, Alignment>;
+    }
+
+    // Spilled instances which were moved from hold no object.
+    bool has_value() const noexcept
+    {
+        if constexpr (is_inline())
+        {
+            return true;
+        }
+        else
+        {
+            return heap().ptr;
+        }
+    }
+
+    memory::memory_resource *resource() const noexcept
+    {
+        if constexpr (is_inline())
+        {
+            return memory::get_default_resource();
+        }
+        else
+        {
+            return heap().resource ? heap().resource
+                                   : memory::get_default_resource();
+        }
+    }
+
+    T &get() noexcept
+    {
+        if constexpr (is_inline())
+        {
+            return reinterpret_cast<T &>(data_);
+        }
+        else
+        {
+            assert(heap().ptr);
+            return *heap().ptr;
+        }
+    }
+
+    const T &get() const noexcept
+    {
+        if constexpr (is_inline())
+        {
+            return reinterpret_cast<const T &>(data_);
+        }
+        else
+        {
+            assert(heap().ptr);
+            return *heap().ptr;
+        }
+    }
+
+   private:
+    heap_storage &heap() noexcept
+    {
+        return reinterpret_cast<heap_storage &>(data_);
+    }
+
+    const heap_storage &heap() const noexcept
+    {
+        return reinterpret_cast<const heap_storage &>(data_);
+    }
+
+    // A spilled instance that was moved from has no object to assign to, so
+    // a new one is allocated from its resource.
+    template <typename U>
+    flex_pimpl &assign(U &&aValue)
+    {
+        if constexpr (!is_inline())
+        {
+            if (!heap().ptr)
+            {
+                new (place(resource())) T(std::forward<U>(aValue));
+                return *this;
+            }
+        }
+        get() = std::forward<U>(aValue);
+        return *this;
+    }
+
+    void *place([[maybe_unused]] memory::memory_resource *aResource) noexcept
+    {
+        if constexpr (is_inline())
+        {
+            return data_;
+        }
+        else
+        {
+#ifdef UTILS_REPORT_PIMPL_SPILLS
+            details::report_pimpl_spill<T>();
+#endif
+            assert(aResource);
+            void *ptr = aResource->allocate(sizeof(T), alignof(T));
+            UTILS_ABORT_IF_REASON(!ptr, "failed to allocate %zu bytes",
+                                  sizeof(T));
+            heap() = heap_storage{static_cast<T *>(ptr), aResource};
+            return ptr;
+        }
+    }
+
+    static void destroy(heap_storage &aStorage) noexcept
+    {
+        if (aStorage.ptr)
+        {
+            aStorage.ptr->~T();
+            aStorage.resource->deallocate(aStorage.ptr);
+        }
+    }
+
+    alignas(Alignment) std::byte data_[Capacity]{};
+};
+
+template <typename T, std::size_t Size, std::size_t Alignment>
+struct is_trivially_relocatable<fast_pimpl<T, Size, Alignment>>
+    : is_trivially_relocatable<T>
+{
+};
+
+template <typename T, std::size_t Capacity, std::size_t Alignment>
+struct is_trivially_relocatable<flex_pimpl<T, Capacity, Alignment>>
+    : std::disjunction<std::negation<is_pimpl_inline<T, Capacity, Alignment>>,
+                       is_trivially_relocatable<T>>
+{
+};
 }  // namespace utils
 
 #endif /* utils_fast_pimpl_h */
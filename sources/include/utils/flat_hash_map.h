@@ -0,0 +1,902 @@
+#ifndef utils_flat_hash_map_h
+#define utils_flat_hash_map_h
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define UTILS_FLAT_HASH_SSE2 1
+#else
+#define UTILS_FLAT_HASH_SSE2 0
+#endif
+
+#include "common.h"
+#include "ctz.h"
+#include "memory/allocator.h"
+#include "memory/relocate.h"
+
+namespace utils
+{
+namespace details
+{
+namespace flat_hash
+{
+inline constexpr std::size_t kGroupWidth = 16;
+inline constexpr std::int8_t kEmpty = -128;
+inline constexpr std::int8_t kDeleted = -2;
+
+inline constexpr bool is_full(std::int8_t aCtrl) noexcept { return aCtrl >= 0; }
+
+class bitmask
+{
+   public:
+    explicit constexpr bitmask(std::uint32_t aMask) noexcept : mask_(aMask) {}
+
+    constexpr explicit operator bool() const noexcept { return mask_ != 0; }
+
+    std::size_t lowest() const noexcept
+    {
+        assert(mask_);
+        return static_cast<std::size_t>(ctz(mask_));
+    }
+
+    constexpr void clear_lowest() noexcept { mask_ &= mask_ - 1; }
+
+   private:
+    std::uint32_t mask_;
+};
+
+class group
+{
+   public:
+#if UTILS_FLAT_HASH_SSE2
+    explicit group(const std::int8_t *aCtrl) noexcept
+        : ctrl_(_mm_load_si128(reinterpret_cast<const __m128i *>(aCtrl)))
+    {
+    }
+
+    bitmask match(std::int8_t aH2) const noexcept
+    {
+        return to_mask(_mm_cmpeq_epi8(_mm_set1_epi8(aH2), ctrl_));
+    }
+
+    bitmask match_empty() const noexcept
+    {
+        return to_mask(_mm_cmpeq_epi8(_mm_set1_epi8(kEmpty), ctrl_));
+    }
+
+    bitmask match_empty_or_deleted() const noexcept
+    {
+        return to_mask(ctrl_);
+    }
+
+   private:
+    static bitmask to_mask(__m128i aVector) noexcept
+    {
+        return bitmask(static_cast<std::uint32_t>(_mm_movemask_epi8(aVector)));
+    }
+
+    __m128i ctrl_;
+#else
+    explicit group(const std::int8_t *aCtrl) noexcept
+    {
+        for (std::size_t i = 0; i < kGroupWidth; ++i)
+        {
+            ctrl_[i] = aCtrl[i];
+        }
+    }
+
+    bitmask match(std::int8_t aH2) const noexcept
+    {
+        std::uint32_t mask{};
+        for (std::size_t i = 0; i < kGroupWidth; ++i)
+        {
+            mask |= static_cast<std::uint32_t>(ctrl_[i] == aH2) << i;
+        }
+        return bitmask(mask);
+    }
+
+    bitmask match_empty() const noexcept { return match(kEmpty); }
+
+    bitmask match_empty_or_deleted() const noexcept
+    {
+        std::uint32_t mask{};
+        for (std::size_t i = 0; i < kGroupWidth; ++i)
+        {
+            mask |= static_cast<std::uint32_t>(!is_full(ctrl_[i])) << i;
+        }
+        return bitmask(mask);
+    }
+
+   private:
+    std::int8_t ctrl_[kGroupWidth];
+#endif
+};
+
+inline constexpr std::uint64_t mix(std::uint64_t aHash) noexcept
+{
+    // std::hash is the identity for integers, spread it over all bits first
+    aHash ^= aHash >> 33;
+    aHash *= 0xff51afd7ed558ccdULL;
+    aHash ^= aHash >> 33;
+    return aHash;
+}
+
+inline constexpr std::size_t h1(std::uint64_t aHash) noexcept
+{
+    return static_cast<std::size_t>(aHash >> 7);
+}
+
+inline constexpr std::int8_t h2(std::uint64_t aHash) noexcept
+{
+    return static_cast<std::int8_t>(aHash & 0x7F);
+}
+
+// Slots hold a mutable pair so that a rehash can move the key out of them;
+// they are only handed out as value_type, whose layout is the same.
+template <typename K, typename V>
+struct map_policy
+{
+    using key_type = K;
+    using value_type = std::pair<const K, V>;
+    using slot_type = std::pair<K, V>;
+
+    static_assert(std::is_nothrow_move_constructible_v<K>);
+    static_assert(std::is_nothrow_move_constructible_v<V>);
+    static_assert(sizeof(slot_type) == sizeof(value_type) &&
+                  alignof(slot_type) == alignof(value_type));
+
+    template <typename Pair>
+    static const K &key(const Pair &aValue) noexcept
+    {
+        return aValue.first;
+    }
+
+    static value_type &element(slot_type &aSlot) noexcept
+    {
+        return *std::launder(reinterpret_cast<value_type *>(&aSlot));
+    }
+
+    static const value_type &element(const slot_type &aSlot) noexcept
+    {
+        return *std::launder(reinterpret_cast<const value_type *>(&aSlot));
+    }
+
+    static void transfer(slot_type *aDst, slot_type *aSrc) noexcept
+    {
+        memory::relocate(aSrc, aDst);
+    }
+};
+
+template <typename K>
+struct set_policy
+{
+    using key_type = K;
+    using value_type = K;
+    using slot_type = K;
+
+    static const K &key(const value_type &aValue) noexcept { return aValue; }
+
+    static value_type &element(slot_type &aSlot) noexcept { return aSlot; }
+
+    static const value_type &element(const slot_type &aSlot) noexcept
+    {
+        return aSlot;
+    }
+
+    static void transfer(slot_type *aDst, slot_type *aSrc) noexcept
+    {
+        memory::relocate(aSrc, aDst);
+    }
+};
+
+template <typename Hash, typename Eq, typename = void>
+struct is_transparent : std::false_type
+{
+};
+
+template <typename Hash, typename Eq>
+struct is_transparent<Hash, Eq,
+                      std::void_t<typename Hash::is_transparent,
+                                  typename Eq::is_transparent>>
+    : std::true_type
+{
+};
+
+template <bool IsTransparent>
+struct key_arg_impl
+{
+    template <typename K, typename Key>
+    using type = Key;
+};
+
+template <>
+struct key_arg_impl<true>
+{
+    template <typename K, typename Key>
+    using type = K;
+};
+
+template <typename Policy, typename Hash, typename Eq>
+class raw_table
+{
+   public:
+    using key_type = typename Policy::key_type;
+    using value_type = typename Policy::value_type;
+    using slot_type = typename Policy::slot_type;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using hasher = Hash;
+    using key_equal = Eq;
+    using allocator_type = memory::allocator<value_type>;
+
+    static_assert(std::is_nothrow_destructible_v<slot_type>);
+
+    template <typename K>
+    using key_arg = typename key_arg_impl<is_transparent<Hash, Eq>::value>::
+        template type<K, key_type>;
+
+    template <bool IsConst>
+    class iterator_impl
+    {
+        friend class raw_table;
+        template <bool>
+        friend class iterator_impl;
+
+       public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = typename raw_table::value_type;
+        using difference_type = std::ptrdiff_t;
+        using reference =
+            std::conditional_t<IsConst, const value_type &, value_type &>;
+        using pointer =
+            std::conditional_t<IsConst, const value_type *, value_type *>;
+
+        iterator_impl() noexcept = default;
+
+        template <bool C = IsConst, typename = std::enable_if_t<C>>
+        iterator_impl(const iterator_impl<false> &aOther) noexcept
+            : ctrl_(aOther.ctrl_), slot_(aOther.slot_), end_(aOther.end_)
+        {
+        }
+
+        reference operator*() const noexcept { return Policy::element(*slot_); }
+        pointer operator->() const noexcept { return &**this; }
+
+        iterator_impl &operator++() noexcept
+        {
+            ++ctrl_;
+            ++slot_;
+            skip_empty();
+            return *this;
+        }
+
+        iterator_impl operator++(int) noexcept
+        {
+            auto copy = *this;
+            ++*this;
+            return copy;
+        }
+
+        friend bool operator==(const iterator_impl &aLhs,
+                               const iterator_impl &aRhs) noexcept
+        {
+            return aLhs.ctrl_ == aRhs.ctrl_;
+        }
+
+        friend bool operator!=(const iterator_impl &aLhs,
+                               const iterator_impl &aRhs) noexcept
+        {
+            return !(aLhs == aRhs);
+        }
+
+       private:
+        using slot_pointer =
+            std::conditional_t<IsConst, const slot_type *, slot_type *>;
+
+        iterator_impl(const std::int8_t *aCtrl, slot_pointer aSlot,
+                      const std::int8_t *aEnd) noexcept
+            : ctrl_(aCtrl), slot_(aSlot), end_(aEnd)
+        {
+        }
+
+        void skip_empty() noexcept
+        {
+            while ((ctrl_ != end_) && !is_full(*ctrl_))
+            {
+                ++ctrl_;
+                ++slot_;
+            }
+        }
+
+        const std::int8_t *ctrl_{};
+        slot_pointer slot_{};
+        const std::int8_t *end_{};
+    };
+
+    using iterator = iterator_impl<false>;
+    using const_iterator = iterator_impl<true>;
+
+    raw_table() noexcept = default;
+
+    explicit raw_table(memory::memory_resource *aResource) noexcept
+        : alloc_(aResource)
+    {
+    }
+
+    explicit raw_table(const allocator_type &aAllocator) noexcept
+        : alloc_(aAllocator)
+    {
+    }
+
+    raw_table(const raw_table &aOther) noexcept(
+        std::is_nothrow_copy_constructible_v<value_type>)
+        : raw_table(aOther, aOther.alloc_)
+    {
+    }
+
+    raw_table(const raw_table &aOther,
+              const allocator_type &aAllocator) noexcept(
+        std::is_nothrow_copy_constructible_v<value_type>)
+        : raw_table(aAllocator)
+    {
+        copy_from(aOther);
+    }
+
+    raw_table(raw_table &&aOther, const allocator_type &aAllocator) noexcept
+        : raw_table(aAllocator)
+    {
+        *this = std::move(aOther);
+    }
+
+    raw_table(raw_table &&aOther) noexcept
+        : alloc_(aOther.alloc_)
+        , ctrl_(std::exchange(aOther.ctrl_, nullptr))
+        , slots_(std::exchange(aOther.slots_, nullptr))
+        , capacity_(std::exchange(aOther.capacity_, 0))
+        , size_(std::exchange(aOther.size_, 0))
+        , growth_left_(std::exchange(aOther.growth_left_, 0))
+    {
+    }
+
+    raw_table &operator=(const raw_table &aOther) noexcept(
+        std::is_nothrow_copy_constructible_v<value_type>)
+    {
+        if (this != &aOther)
+        {
+            clear();
+            copy_from(aOther);
+        }
+        return *this;
+    }
+
+    raw_table &operator=(raw_table &&aOther) noexcept
+    {
+        if (this == &aOther)
+        {
+            return *this;
+        }
+
+        clear();
+        if (alloc_ == aOther.alloc_)
+        {
+            release_storage();
+            ctrl_ = std::exchange(aOther.ctrl_, nullptr);
+            slots_ = std::exchange(aOther.slots_, nullptr);
+            capacity_ = std::exchange(aOther.capacity_, 0);
+            size_ = std::exchange(aOther.size_, 0);
+            growth_left_ = std::exchange(aOther.growth_left_, 0);
+        }
+        else
+        {
+            UTILS_ABORT_IF_REASON(!reserve(aOther.size_),
+                                  "failed to reserve %zu elements",
+                                  aOther.size_);
+            aOther.relocate_into(*this);
+        }
+        return *this;
+    }
+
+    ~raw_table()
+    {
+        clear();
+        release_storage();
+    }
+
+    iterator begin() noexcept
+    {
+        iterator it(ctrl_, slots_, ctrl_ + capacity_);
+        it.skip_empty();
+        return it;
+    }
+
+    const_iterator begin() const noexcept
+    {
+        const_iterator it(ctrl_, slots_, ctrl_ + capacity_);
+        it.skip_empty();
+        return it;
+    }
+
+    iterator end() noexcept
+    {
+        return iterator(ctrl_ + capacity_, slots_ + capacity_,
+                        ctrl_ + capacity_);
+    }
+
+    const_iterator end() const noexcept
+    {
+        return const_iterator(ctrl_ + capacity_, slots_ + capacity_,
+                              ctrl_ + capacity_);
+    }
+
+    const_iterator cbegin() const noexcept { return begin(); }
+    const_iterator cend() const noexcept { return end(); }
+
+    size_type size() const noexcept { return size_; }
+    bool empty() const noexcept { return !size_; }
+    size_type capacity() const noexcept { return capacity_; }
+
+    float load_factor() const noexcept
+    {
+        return capacity_ ? static_cast<float>(size_) /
+                               static_cast<float>(capacity_)
+                         : 0.f;
+    }
+
+    hasher hash_function() const { return hasher{}; }
+    key_equal key_eq() const { return key_equal{}; }
+    allocator_type get_allocator() const noexcept { return alloc_; }
+
+    void clear() noexcept
+    {
+        if (!capacity_)
+        {
+            return;
+        }
+        for (size_type i = 0; i < capacity_; ++i)
+        {
+            if (is_full(ctrl_[i]))
+            {
+                slots_[i].~slot_type();
+            }
+            ctrl_[i] = kEmpty;
+        }
+        size_ = 0;
+        growth_left_ = max_load(capacity_);
+    }
+
+    bool reserve(size_type aCount) noexcept
+    {
+        if (aCount <= size_ + growth_left_)
+        {
+            return true;
+        }
+        return resize(capacity_for(aCount));
+    }
+
+    bool rehash(size_type aCount) noexcept
+    {
+        const size_type capacity =
+            capacity_for(aCount > size_ ? aCount : size_);
+        return resize(capacity);
+    }
+
+    template <typename K = key_type>
+    iterator find(const key_arg<K> &aKey) noexcept
+    {
+        const size_type i = find_index(aKey);
+        return (i != capacity_) ? iterator_at(i) : end();
+    }
+
+    template <typename K = key_type>
+    const_iterator find(const key_arg<K> &aKey) const noexcept
+    {
+        const size_type i = find_index(aKey);
+        return (i != capacity_) ? const_iterator_at(i) : end();
+    }
+
+    template <typename K = key_type>
+    bool contains(const key_arg<K> &aKey) const noexcept
+    {
+        return find_index(aKey) != capacity_;
+    }
+
+    template <typename K = key_type>
+    size_type count(const key_arg<K> &aKey) const noexcept
+    {
+        return contains<K>(aKey);
+    }
+
+    template <typename K = key_type>
+    size_type erase(const key_arg<K> &aKey) noexcept
+    {
+        const size_type i = find_index(aKey);
+        if (i == capacity_)
+        {
+            return 0;
+        }
+        erase_at(i);
+        return 1;
+    }
+
+    iterator erase(const_iterator aPos) noexcept
+    {
+        const auto i = static_cast<size_type>(aPos.ctrl_ - ctrl_);
+        assert(i < capacity_ && is_full(ctrl_[i]));
+        erase_at(i);
+        iterator next = iterator_at(i);
+        next.skip_empty();
+        return next;
+    }
+
+    iterator erase(iterator aPos) noexcept
+    {
+        return erase(const_iterator(aPos));
+    }
+
+   protected:
+    // Returns {index, inserted}. On allocation failure index is capacity_.
+    template <typename K, typename... Args>
+    std::pair<size_type, bool> emplace_key(
+        const K &aKey,
+        Args &&...aArgs) noexcept(std::is_nothrow_constructible_v<slot_type,
+                                                                  Args...>)
+    {
+        const std::uint64_t hash = hash_of(aKey);
+        const size_type found = find_index(aKey, hash);
+        if (found != capacity_)
+        {
+            return {found, false};
+        }
+
+        if (!growth_left_ && !grow())
+        {
+            return {capacity_, false};
+        }
+
+        const size_type i = find_insert_slot(hash);
+        alloc_.construct(slots_ + i, std::forward<Args>(aArgs)...);
+        commit_insert(i, hash);
+        return {i, true};
+    }
+
+    iterator iterator_at(size_type aIndex) noexcept
+    {
+        return iterator(ctrl_ + aIndex, slots_ + aIndex, ctrl_ + capacity_);
+    }
+
+    const_iterator const_iterator_at(size_type aIndex) const noexcept
+    {
+        return const_iterator(ctrl_ + aIndex, slots_ + aIndex,
+                              ctrl_ + capacity_);
+    }
+
+    std::pair<iterator, bool> to_result(
+        std::pair<size_type, bool> aResult) noexcept
+    {
+        return {(aResult.first != capacity_) ? iterator_at(aResult.first)
+                                             : end(),
+                aResult.second};
+    }
+
+   private:
+    static constexpr size_type max_load(size_type aCapacity) noexcept
+    {
+        return aCapacity - aCapacity / 8;
+    }
+
+    static size_type capacity_for(size_type aCount) noexcept
+    {
+        size_type capacity = kGroupWidth;
+        while (max_load(capacity) < aCount)
+        {
+            capacity *= 2;
+        }
+        return capacity;
+    }
+
+    template <typename K>
+    static std::uint64_t hash_of(const K &aKey) noexcept
+    {
+        return mix(static_cast<std::uint64_t>(hasher{}(aKey)));
+    }
+
+    template <typename K>
+    size_type find_index(const K &aKey) const noexcept
+    {
+        return find_index(aKey, hash_of(aKey));
+    }
+
+    template <typename K>
+    size_type find_index(const K &aKey, std::uint64_t aHash) const noexcept
+    {
+        if (!capacity_)
+        {
+            return capacity_;
+        }
+
+        const std::int8_t tag = h2(aHash);
+        const size_type group_mask = capacity_ / kGroupWidth - 1;
+        size_type g = h1(aHash) & group_mask;
+        for (size_type step = 1;; ++step)
+        {
+            const size_type offset = g * kGroupWidth;
+            const group grp(ctrl_ + offset);
+            for (auto m = grp.match(tag); m; m.clear_lowest())
+            {
+                const size_type i = offset + m.lowest();
+                if (key_equal{}(Policy::key(slots_[i]), aKey))
+                {
+                    return i;
+                }
+            }
+            if (grp.match_empty() || step > group_mask)
+            {
+                return capacity_;
+            }
+            g = (g + step) & group_mask;
+        }
+    }
+
+    size_type find_insert_slot(std::uint64_t aHash) const noexcept
+    {
+        assert(capacity_);
+        const size_type group_mask = capacity_ / kGroupWidth - 1;
+        size_type g = h1(aHash) & group_mask;
+        for (size_type step = 1;; ++step)
+        {
+            const size_type offset = g * kGroupWidth;
+            const auto m = group(ctrl_ + offset).match_empty_or_deleted();
+            if (m)
+            {
+                return offset + m.lowest();
+            }
+            assert(step <= group_mask);
+            g = (g + step) & group_mask;
+        }
+    }
+
+    void commit_insert(size_type aIndex, std::uint64_t aHash) noexcept
+    {
+        if (ctrl_[aIndex] == kEmpty)
+        {
+            assert(growth_left_);
+            --growth_left_;
+        }
+        ctrl_[aIndex] = h2(aHash);
+        ++size_;
+    }
+
+    void copy_from(const raw_table &aOther) noexcept(
+        std::is_nothrow_copy_constructible_v<value_type>)
+    {
+        UTILS_ABORT_IF_REASON(!reserve(aOther.size_),
+                              "failed to reserve %zu elements", aOther.size_);
+        for (const auto &v: aOther)
+        {
+            const std::uint64_t hash = hash_of(Policy::key(v));
+            const size_type i = find_insert_slot(hash);
+            alloc_.construct(slots_ + i, v);
+            commit_insert(i, hash);
+        }
+    }
+
+    void erase_at(size_type aIndex) noexcept
+    {
+        slots_[aIndex].~slot_type();
+        --size_;
+        const size_type offset = aIndex - aIndex % kGroupWidth;
+        // a probe sequence never passed through a group that still had an
+        // empty slot, so such a slot can become empty again
+        if (group(ctrl_ + offset).match_empty())
+        {
+            ctrl_[aIndex] = kEmpty;
+            ++growth_left_;
+        }
+        else
+        {
+            ctrl_[aIndex] = kDeleted;
+        }
+    }
+
+    bool grow() noexcept
+    {
+        // tombstones are dropped by rehashing into the same capacity when the
+        // table is not actually full
+        const bool mostly_deleted =
+            capacity_ && (size_ * 2 <= max_load(capacity_));
+        return resize(mostly_deleted ? capacity_
+                                     : (capacity_ ? capacity_ * 2
+                                                  : kGroupWidth));
+    }
+
+    static size_type slots_offset(size_type aCapacity) noexcept
+    {
+        return next_multiple_of(alignof(slot_type), aCapacity);
+    }
+
+    static constexpr std::size_t storage_alignment() noexcept
+    {
+        return alignof(slot_type) > kGroupWidth ? alignof(slot_type)
+                                                : kGroupWidth;
+    }
+
+    bool resize(size_type aCapacity) noexcept
+    {
+        assert(aCapacity >= kGroupWidth && is_power_of_2(aCapacity));
+        void *storage = alloc_.allocate_bytes(
+            slots_offset(aCapacity) + aCapacity * sizeof(slot_type),
+            storage_alignment());
+        if (!storage)
+        {
+            return false;
+        }
+
+        raw_table old(alloc_);
+        old.ctrl_ = std::exchange(ctrl_, static_cast<std::int8_t *>(storage));
+        old.slots_ = std::exchange(
+            slots_, reinterpret_cast<slot_type *>(
+                        static_cast<std::byte *>(storage) +
+                        slots_offset(aCapacity)));
+        old.capacity_ = std::exchange(capacity_, aCapacity);
+        old.size_ = std::exchange(size_, 0);
+        for (size_type i = 0; i < capacity_; ++i)
+        {
+            ctrl_[i] = kEmpty;
+        }
+        growth_left_ = max_load(capacity_);
+
+        old.relocate_into(*this);
+        return true;
+    }
+
+    void relocate_into(raw_table &aOther) noexcept
+    {
+        for (size_type i = 0; i < capacity_; ++i)
+        {
+            if (is_full(ctrl_[i]))
+            {
+                const std::uint64_t hash = hash_of(Policy::key(slots_[i]));
+                const size_type dst = aOther.find_insert_slot(hash);
+                Policy::transfer(aOther.slots_ + dst, slots_ + i);
+                aOther.commit_insert(dst, hash);
+                ctrl_[i] = kEmpty;
+            }
+        }
+        size_ = 0;
+        growth_left_ = max_load(capacity_);
+    }
+
+    void release_storage() noexcept
+    {
+        if (ctrl_)
+        {
+            alloc_.deallocate_bytes(ctrl_);
+        }
+        ctrl_ = nullptr;
+        slots_ = nullptr;
+        capacity_ = 0;
+        growth_left_ = 0;
+    }
+
+    allocator_type alloc_{};
+    std::int8_t *ctrl_{};
+    slot_type *slots_{};
+    size_type capacity_{};
+    size_type size_{};
+    size_type growth_left_{};
+};
+}  // namespace flat_hash
+}  // namespace details
+
+template <typename K, typename V, typename Hash = std::hash<K>,
+          typename Eq = std::equal_to<K>>
+class flat_hash_map
+    : public details::flat_hash::raw_table<
+          details::flat_hash::map_policy<K, V>, Hash, Eq>
+{
+    using base =
+        details::flat_hash::raw_table<details::flat_hash::map_policy<K, V>,
+                                      Hash, Eq>;
+
+   public:
+    using mapped_type = V;
+    using typename base::iterator;
+    using typename base::key_type;
+    using typename base::value_type;
+
+    using base::base;
+
+    std::pair<iterator, bool> insert(const value_type &aValue) noexcept(
+        std::is_nothrow_copy_constructible_v<value_type>)
+    {
+        return this->to_result(this->emplace_key(aValue.first, aValue));
+    }
+
+    std::pair<iterator, bool> insert(value_type &&aValue) noexcept(
+        std::is_nothrow_constructible_v<value_type, value_type &&>)
+    {
+        return this->to_result(
+            this->emplace_key(aValue.first, std::move(aValue)));
+    }
+
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(
+        const key_type &aKey,
+        Args &&...aArgs) noexcept(std::is_nothrow_copy_constructible_v<K> &&
+                                  std::is_nothrow_constructible_v<V, Args...>)
+    {
+        return this->to_result(this->emplace_key(
+            aKey, std::piecewise_construct, std::forward_as_tuple(aKey),
+            std::forward_as_tuple(std::forward<Args>(aArgs)...)));
+    }
+
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(
+        key_type &&aKey,
+        Args &&...aArgs) noexcept(std::is_nothrow_constructible_v<V, Args...>)
+    {
+        return this->to_result(this->emplace_key(
+            aKey, std::piecewise_construct,
+            std::forward_as_tuple(std::move(aKey)),
+            std::forward_as_tuple(std::forward<Args>(aArgs)...)));
+    }
+
+    template <typename... Args>
+    std::pair<iterator, bool> emplace(
+        const key_type &aKey,
+        Args &&...aArgs) noexcept(std::is_nothrow_copy_constructible_v<K> &&
+                                  std::is_nothrow_constructible_v<V, Args...>)
+    {
+        return try_emplace(aKey, std::forward<Args>(aArgs)...);
+    }
+
+    V &operator[](const key_type &aKey) noexcept(
+        std::is_nothrow_copy_constructible_v<K> &&
+        std::is_nothrow_default_constructible_v<V>)
+    {
+        const auto result = try_emplace(aKey);
+        UTILS_ABORT_IF_REASON(result.first == this->end(),
+                              "failed to grow flat_hash_map");
+        return result.first->second;
+    }
+};
+
+template <typename K, typename Hash = std::hash<K>,
+          typename Eq = std::equal_to<K>>
+class flat_hash_set
+    : public details::flat_hash::raw_table<details::flat_hash::set_policy<K>,
+                                           Hash, Eq>
+{
+    using base =
+        details::flat_hash::raw_table<details::flat_hash::set_policy<K>, Hash,
+                                      Eq>;
+
+   public:
+    using typename base::iterator;
+    using typename base::key_type;
+    using typename base::value_type;
+
+    using base::base;
+
+    std::pair<iterator, bool> insert(const K &aValue) noexcept(
+        std::is_nothrow_copy_constructible_v<K>)
+    {
+        return this->to_result(this->emplace_key(aValue, aValue));
+    }
+
+    std::pair<iterator, bool> insert(K &&aValue) noexcept
+    {
+        return this->to_result(this->emplace_key(aValue, std::move(aValue)));
+    }
+};
+}  // namespace utils
+
+#endif /* utils_flat_hash_map_h */
@@ -0,0 +1,435 @@
+#ifndef utils_inplace_function_h
+#define utils_inplace_function_h
+
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "function_traits.h"
+#include "type_list.h"
+
+namespace utils
+{
+namespace details
+{
+// Splits a function signature R(Args...) [const] [noexcept] into its parts.
+// volatile and reference qualifiers are not supported.
+template <typename Sig>
+struct callable_signature
+{
+    static_assert(std::is_function_v<Sig>,
+                  "expected a function signature such as void(int) noexcept");
+    static_assert(not function_traits::has_volatile_qualifier_v<Sig> &&
+                      not function_traits::has_lvalue_reference_qualifier_v<
+                          Sig> &&
+                      not function_traits::has_rvalue_reference_qualifier_v<
+                          Sig>,
+                  "only const and noexcept qualifiers are supported");
+
+    using result_type = function_traits::return_type_t<Sig>;
+    using params = function_traits::params_list_t<Sig>;
+    static constexpr bool kConst = function_traits::has_const_qualifier_v<Sig>;
+    static constexpr bool kNoexcept =
+        function_traits::has_noexcept_qualifier_v<Sig>;
+
+    // Whether F, held as an lvalue (const for const signatures), can be
+    // called with the signature's parameters.
+    template <typename F, typename... Args>
+    static constexpr bool accepts(type_list<Args...>) noexcept
+    {
+        using target = std::conditional_t<kConst, const F &, F &>;
+        if constexpr (kNoexcept)
+        {
+            return std::is_nothrow_invocable_r_v<result_type, target, Args...>;
+        }
+        else
+        {
+            return std::is_invocable_r_v<result_type, target, Args...>;
+        }
+    }
+
+    template <typename F>
+    static constexpr bool kAccepts = accepts<F>(params{});
+};
+
+template <bool Noexcept, typename R, typename... Args>
+struct inplace_function_ops
+{
+    using invoke_t = R (*)(std::byte *, Args &&...) noexcept(Noexcept);
+    using copy_t = void (*)(std::byte *, const std::byte *);
+    using move_t = void (*)(std::byte *, std::byte *) noexcept;
+    using destroy_t = void (*)(std::byte *) noexcept;
+
+    invoke_t invoke;
+    copy_t copy;
+    move_t move;
+    destroy_t destroy;
+
+    template <typename F>
+    static F &target(std::byte *aData) noexcept
+    {
+        return *std::launder(reinterpret_cast<F *>(aData));
+    }
+
+    template <typename F>
+    static R invoke_impl(std::byte *aData,
+                         Args &&...aArgs) noexcept(Noexcept)
+    {
+        return std::invoke(target<F>(aData), std::forward<Args>(aArgs)...);
+    }
+
+    template <typename F>
+    static void copy_impl(std::byte *aDst, const std::byte *aSrc)
+    {
+        new (aDst) F(*std::launder(reinterpret_cast<const F *>(aSrc)));
+    }
+
+    template <typename F>
+    static void move_impl(std::byte *aDst, std::byte *aSrc) noexcept
+    {
+        new (aDst) F(std::move(target<F>(aSrc)));
+        target<F>(aSrc).~F();
+    }
+
+    template <typename F>
+    static void destroy_impl(std::byte *aData) noexcept
+    {
+        target<F>(aData).~F();
+    }
+
+    template <typename F>
+    static constexpr inplace_function_ops kFor{
+        &invoke_impl<F>, &copy_impl<F>, &move_impl<F>, &destroy_impl<F>};
+};
+
+template <typename Sig, typename Params = typename callable_signature<
+                            Sig>::params>
+struct inplace_function_ops_for;
+
+template <typename Sig, typename... Args>
+struct inplace_function_ops_for<Sig, type_list<Args...>>
+{
+    using type =
+        inplace_function_ops<callable_signature<Sig>::kNoexcept,
+                             typename callable_signature<Sig>::result_type,
+                             Args...>;
+};
+
+union function_ref_target
+{
+    void *object;
+    void (*function)();
+};
+
+// Declares the call operator with the exact parameters of Sig. Derived
+// provides invoke().
+template <typename Derived, typename Sig,
+          typename Params = typename callable_signature<Sig>::params>
+class callable_call_operator;
+
+template <typename Derived, typename Sig, typename... Args>
+class callable_call_operator<Derived, Sig, type_list<Args...>>
+{
+    using signature = callable_signature<Sig>;
+
+   public:
+    typename signature::result_type operator()(Args... aArgs) const
+        noexcept(signature::kNoexcept)
+    {
+        return static_cast<const Derived &>(*this).invoke(
+            std::forward<Args>(aArgs)...);
+    }
+};
+
+template <typename Sig, typename Params = typename callable_signature<
+                            Sig>::params>
+struct function_ref_ops;
+
+template <typename Sig, typename... Args>
+struct function_ref_ops<Sig, type_list<Args...>>
+{
+    using signature = callable_signature<Sig>;
+    using result_type = typename signature::result_type;
+    using call_t = result_type (*)(function_ref_target,
+                                   Args &&...) noexcept(signature::kNoexcept);
+
+    template <typename F>
+    static result_type call_object(function_ref_target aTarget,
+                                   Args &&...aArgs) noexcept(
+        signature::kNoexcept)
+    {
+        return std::invoke(*static_cast<F *>(aTarget.object),
+                           std::forward<Args>(aArgs)...);
+    }
+
+    template <typename F>
+    static result_type call_function(function_ref_target aTarget,
+                                     Args &&...aArgs) noexcept(
+        signature::kNoexcept)
+    {
+        return std::invoke(reinterpret_cast<F *>(aTarget.function),
+                           std::forward<Args>(aArgs)...);
+    }
+};
+}  // namespace details
+
+template <typename Sig, std::size_t Capacity, std::size_t Alignment>
+class inplace_function;
+
+namespace details
+{
+template <typename T>
+struct is_inplace_function : std::false_type
+{
+};
+
+template <typename Sig, std::size_t Capacity, std::size_t Alignment>
+struct is_inplace_function<inplace_function<Sig, Capacity, Alignment>>
+    : std::true_type
+{
+};
+}  // namespace details
+
+// Type-erased callable stored entirely inside the object, the technique
+// details::timer uses for its callback, generalized: it never allocates and
+// rejects at compile time callables larger than Capacity or more aligned
+// than Alignment. Sig is R(Args...) with optional const and noexcept
+// qualifiers; the stored callable must be invocable accordingly. Callables
+// must be nothrow move constructible; copying requires them to be copyable.
+template <typename Sig, std::size_t Capacity = 4 * sizeof(void *),
+          std::size_t Alignment = alignof(std::max_align_t)>
+class inplace_function
+    : public details::callable_call_operator<
+          inplace_function<Sig, Capacity, Alignment>, Sig>
+{
+    using signature = details::callable_signature<Sig>;
+    using ops = typename details::inplace_function_ops_for<Sig>::type;
+
+    template <typename, std::size_t, std::size_t>
+    friend class inplace_function;
+    friend class details::callable_call_operator<inplace_function, Sig>;
+
+   public:
+    static constexpr std::size_t kCapacity = Capacity;
+    static constexpr std::size_t kAlignment = Alignment;
+    using result_type = typename signature::result_type;
+
+    inplace_function() noexcept = default;
+    inplace_function(std::nullptr_t) noexcept {}
+
+    template <typename F, typename Stored = std::decay_t<F>,
+              typename = std::enable_if_t<
+                  not details::is_inplace_function<Stored>::value &&
+                  signature::template kAccepts<Stored>>>
+    inplace_function(F &&aCallable) noexcept(
+        std::is_nothrow_constructible_v<Stored, F &&>)
+    {
+        static_assert(sizeof(Stored) <= Capacity,
+                      "callable does not fit into inplace_function");
+        static_assert(alignof(Stored) <= Alignment,
+                      "callable is over-aligned for inplace_function");
+        static_assert(std::is_nothrow_move_constructible_v<Stored>);
+        static_assert(std::is_copy_constructible_v<Stored>,
+                      "inplace_function requires copyable callables");
+        // Functions passed by reference decay to pointers that cannot be
+        // null; only actual pointers are checked.
+        using passed_t = std::remove_cv_t<std::remove_reference_t<F>>;
+        if constexpr (std::is_pointer_v<passed_t> ||
+                      std::is_member_pointer_v<passed_t>)
+        {
+            if (!aCallable)
+            {
+                return;
+            }
+        }
+        new (data_) Stored(std::forward<F>(aCallable));
+        ops_ = &ops::template kFor<Stored>;
+    }
+
+    inplace_function(const inplace_function &aOther) { copy_from(aOther); }
+
+    inplace_function(inplace_function &&aOther) noexcept
+    {
+        move_from(aOther);
+    }
+
+    // From a smaller inplace_function with the same signature.
+    template <std::size_t C, std::size_t A,
+              typename = std::enable_if_t<(C < Capacity) && (A <= Alignment)>>
+    inplace_function(const inplace_function<Sig, C, A> &aOther)
+    {
+        copy_from(aOther);
+    }
+
+    template <std::size_t C, std::size_t A,
+              typename = std::enable_if_t<(C < Capacity) && (A <= Alignment)>>
+    inplace_function(inplace_function<Sig, C, A> &&aOther) noexcept
+    {
+        move_from(aOther);
+    }
+
+    inplace_function &operator=(const inplace_function &aOther)
+    {
+        if (this != &aOther)
+        {
+            reset();
+            copy_from(aOther);
+        }
+        return *this;
+    }
+
+    inplace_function &operator=(inplace_function &&aOther) noexcept
+    {
+        if (this != &aOther)
+        {
+            reset();
+            move_from(aOther);
+        }
+        return *this;
+    }
+
+    inplace_function &operator=(std::nullptr_t) noexcept
+    {
+        reset();
+        return *this;
+    }
+
+    template <typename F, typename Stored = std::decay_t<F>,
+              typename = std::enable_if_t<
+                  not details::is_inplace_function<Stored>::value &&
+                  signature::template kAccepts<Stored>>>
+    inplace_function &operator=(F &&aCallable) noexcept(
+        std::is_nothrow_constructible_v<Stored, F &&>)
+    {
+        return *this = inplace_function(std::forward<F>(aCallable));
+    }
+
+    ~inplace_function() { reset(); }
+
+    explicit operator bool() const noexcept { return ops_; }
+
+    friend bool operator==(const inplace_function &aFunction,
+                           std::nullptr_t) noexcept
+    {
+        return !aFunction;
+    }
+
+    friend bool operator!=(const inplace_function &aFunction,
+                           std::nullptr_t) noexcept
+    {
+        return static_cast<bool>(aFunction);
+    }
+
+    void swap(inplace_function &aOther) noexcept
+    {
+        inplace_function tmp(std::move(aOther));
+        aOther = std::move(*this);
+        *this = std::move(tmp);
+    }
+
+    friend void swap(inplace_function &aLhs, inplace_function &aRhs) noexcept
+    {
+        aLhs.swap(aRhs);
+    }
+
+   private:
+    // Like std::function, callable through a const reference whatever the
+    // constness of the signature.
+    template <typename... Args>
+    result_type invoke(Args &&...aArgs) const noexcept(signature::kNoexcept)
+    {
+        assert(ops_ && "calling an empty inplace_function");
+        return ops_->invoke(data_, std::forward<Args>(aArgs)...);
+    }
+
+    void reset() noexcept
+    {
+        if (ops_)
+        {
+            ops_->destroy(data_);
+            ops_ = nullptr;
+        }
+    }
+
+    template <typename Other>
+    void copy_from(const Other &aOther)
+    {
+        if (aOther.ops_)
+        {
+            aOther.ops_->copy(data_, aOther.data_);
+            ops_ = aOther.ops_;
+        }
+    }
+
+    template <typename Other>
+    void move_from(Other &aOther) noexcept
+    {
+        if (aOther.ops_)
+        {
+            aOther.ops_->move(data_, aOther.data_);
+            ops_ = std::exchange(aOther.ops_, nullptr);
+        }
+    }
+
+    const ops *ops_{};
+    alignas(Alignment) mutable std::byte data_[Capacity];
+};
+
+// Non-owning reference to a callable with signature Sig (qualified as for
+// inplace_function): two pointers, trivially copyable, never allocates. The
+// referenced callable must outlive every call through the function_ref.
+template <typename Sig>
+class function_ref
+    : public details::callable_call_operator<function_ref<Sig>, Sig>
+{
+    using signature = details::callable_signature<Sig>;
+    using ops = details::function_ref_ops<Sig>;
+
+    friend class details::callable_call_operator<function_ref, Sig>;
+
+   public:
+    using result_type = typename signature::result_type;
+
+    template <typename F, typename Stored = std::remove_reference_t<F>,
+              typename = std::enable_if_t<
+                  not std::is_same_v<std::remove_cv_t<Stored>, function_ref> &&
+                  not std::is_function_v<Stored> &&
+                  signature::template kAccepts<std::remove_cv_t<Stored>>>>
+    function_ref(F &&aCallable) noexcept
+        : call_(&ops::template call_object<Stored>)
+    {
+        target_.object = const_cast<void *>(
+            static_cast<const volatile void *>(std::addressof(aCallable)));
+    }
+
+    // Free functions are held by address, so passing a function name
+    // directly does not leave a dangling reference.
+    template <typename F, typename = std::enable_if_t<
+                              std::is_function_v<F> &&
+                              signature::template kAccepts<F *>>>
+    function_ref(F *aFunction) noexcept
+        : call_(&ops::template call_function<F>)
+    {
+        assert(aFunction && "function_ref to a null function pointer");
+        target_.function = reinterpret_cast<void (*)()>(aFunction);
+    }
+
+    function_ref(const function_ref &) noexcept = default;
+    function_ref &operator=(const function_ref &) noexcept = default;
+
+   private:
+    template <typename... Args>
+    result_type invoke(Args &&...aArgs) const noexcept(signature::kNoexcept)
+    {
+        return call_(target_, std::forward<Args>(aArgs)...);
+    }
+
+    details::function_ref_target target_;
+    typename ops::call_t call_;
+};
+}  // namespace utils
+
+#endif /* utils_inplace_function_h */
@@ -0,0 +1,404 @@
+#ifndef utils_latency_histogram_h
+#define utils_latency_histogram_h
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+
+#include "clz.h"
+#include "common.h"
+#include "memory/allocator.h"
+
+namespace utils
+{
+// Log-linear (HDR-style) histogram of nanosecond values. Values below
+// 2^PrecisionBits are counted exactly; larger ones land in buckets whose
+// width is at most 1/2^(PrecisionBits-1) of their lower bound, so every
+// recorded value is reported within that relative error. The footprint is
+// fixed: (66 - PrecisionBits) * 2^(PrecisionBits-1) counters.
+//
+// Recording is meant for a single thread and uses relaxed loads and stores
+// only; any thread may read or merge from the histogram concurrently.
+template <std::size_t PrecisionBits = 5>
+class latency_histogram
+{
+    static_assert((PrecisionBits >= 1) && (PrecisionBits <= 16));
+
+   public:
+    using value_type = std::uint64_t;
+    using count_type = std::uint64_t;
+
+    static constexpr std::size_t kPrecisionBits = PrecisionBits;
+    static constexpr std::size_t kSubBucketCount =
+        std::size_t{1} << (PrecisionBits - 1);
+    static constexpr std::size_t kBucketCount =
+        (66 - PrecisionBits) * kSubBucketCount;
+
+    // Pointer-sized callable that records a timer's elapsed time; pass it as
+    // a utils::timer finish callback.
+    class sink_type
+    {
+       public:
+        explicit sink_type(latency_histogram &aHistogram) noexcept
+            : histogram_(&aHistogram)
+        {
+        }
+
+        template <typename Timer>
+        void operator()(const Timer &aTimer) const noexcept
+        {
+            histogram_->record(aTimer.leaked());
+        }
+
+       private:
+        latency_histogram *histogram_;
+    };
+
+    latency_histogram() noexcept = default;
+
+    latency_histogram(const latency_histogram &aOther) noexcept
+    {
+        merge(aOther);
+    }
+
+    latency_histogram &operator=(const latency_histogram &aOther) noexcept
+    {
+        if (this != &aOther)
+        {
+            reset();
+            merge(aOther);
+        }
+        return *this;
+    }
+
+    static std::size_t bucket_index(value_type aValue) noexcept
+    {
+        if (aValue < (value_type{1} << PrecisionBits))
+        {
+            return static_cast<std::size_t>(aValue);
+        }
+        const auto msb = static_cast<std::size_t>(63 - clz(aValue));
+        const std::size_t shift = msb - (PrecisionBits - 1);
+        return shift * kSubBucketCount +
+               static_cast<std::size_t>(aValue >> shift);
+    }
+
+    static value_type bucket_lower(std::size_t aIndex) noexcept
+    {
+        assert(aIndex < kBucketCount);
+        if (aIndex < kSubBucketCount)
+        {
+            return aIndex;
+        }
+        const std::size_t shift = aIndex / kSubBucketCount - 1;
+        return static_cast<value_type>(aIndex - shift * kSubBucketCount)
+               << shift;
+    }
+
+    static value_type bucket_upper(std::size_t aIndex) noexcept
+    {
+        if (aIndex + 1 == kBucketCount)
+        {
+            return std::numeric_limits<value_type>::max();
+        }
+        return bucket_lower(aIndex + 1) - 1;
+    }
+
+    void record(value_type aValue, count_type aCount = 1) noexcept
+    {
+        add(counts_[bucket_index(aValue)], aCount);
+        add(count_, aCount);
+        add(sum_, aValue * aCount);
+        if (aValue < min_.load(std::memory_order_relaxed))
+        {
+            min_.store(aValue, std::memory_order_relaxed);
+        }
+        if (aValue > max_.load(std::memory_order_relaxed))
+        {
+            max_.store(aValue, std::memory_order_relaxed);
+        }
+    }
+
+    template <typename Rep, typename Period>
+    void record(std::chrono::duration<Rep, Period> aDuration) noexcept
+    {
+        const auto ns =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(aDuration)
+                .count();
+        record(ns > 0 ? static_cast<value_type>(ns) : 0);
+    }
+
+    sink_type sink() noexcept { return sink_type(*this); }
+
+    // Adds aOther's counts to this histogram.
+    void merge(const latency_histogram &aOther) noexcept
+    {
+        count_type total = 0;
+        for (std::size_t i = 0; i < kBucketCount; ++i)
+        {
+            const count_type c =
+                aOther.counts_[i].load(std::memory_order_relaxed);
+            if (c)
+            {
+                add(counts_[i], c);
+                total += c;
+            }
+        }
+        // Derived from the buckets so that a merge racing with the recording
+        // thread still yields a consistent total.
+        add(count_, total);
+        add(sum_, aOther.sum_.load(std::memory_order_relaxed));
+        const value_type min = aOther.min_.load(std::memory_order_relaxed);
+        if (min < min_.load(std::memory_order_relaxed))
+        {
+            min_.store(min, std::memory_order_relaxed);
+        }
+        const value_type max = aOther.max_.load(std::memory_order_relaxed);
+        if (max > max_.load(std::memory_order_relaxed))
+        {
+            max_.store(max, std::memory_order_relaxed);
+        }
+    }
+
+    void reset() noexcept
+    {
+        for (auto &c: counts_)
+        {
+            c.store(0, std::memory_order_relaxed);
+        }
+        count_.store(0, std::memory_order_relaxed);
+        sum_.store(0, std::memory_order_relaxed);
+        min_.store(std::numeric_limits<value_type>::max(),
+                   std::memory_order_relaxed);
+        max_.store(0, std::memory_order_relaxed);
+    }
+
+    count_type count() const noexcept
+    {
+        return count_.load(std::memory_order_relaxed);
+    }
+
+    bool empty() const noexcept { return !count(); }
+
+    count_type count_at(std::size_t aIndex) const noexcept
+    {
+        assert(aIndex < kBucketCount);
+        return counts_[aIndex].load(std::memory_order_relaxed);
+    }
+
+    value_type min() const noexcept
+    {
+        return empty() ? 0 : min_.load(std::memory_order_relaxed);
+    }
+
+    value_type max() const noexcept
+    {
+        return max_.load(std::memory_order_relaxed);
+    }
+
+    double mean() const noexcept
+    {
+        const count_type n = count();
+        return n ? static_cast<double>(sum_.load(std::memory_order_relaxed)) /
+                       static_cast<double>(n)
+                 : 0.0;
+    }
+
+    // Highest value equivalent to the one at aPercentile (0-100), i.e. the
+    // upper bound of its bucket clamped to max(). 0 for an empty histogram.
+    value_type value_at_percentile(double aPercentile) const noexcept
+    {
+        const count_type n = count();
+        if (!n)
+        {
+            return 0;
+        }
+        const double p = std::clamp(aPercentile, 0.0, 100.0);
+        const auto rank = std::max<count_type>(
+            1, static_cast<count_type>(
+                   std::ceil(p / 100.0 * static_cast<double>(n))));
+        count_type seen = 0;
+        for (std::size_t i = 0; i < kBucketCount; ++i)
+        {
+            seen += counts_[i].load(std::memory_order_relaxed);
+            if (seen >= rank)
+            {
+                return std::clamp(bucket_upper(i), min(), max());
+            }
+        }
+        return max();
+    }
+
+   private:
+    // Single writer: a plain load and store, no locked instruction.
+    static void add(std::atomic<count_type> &aCounter,
+                    count_type aValue) noexcept
+    {
+        aCounter.store(aCounter.load(std::memory_order_relaxed) + aValue,
+                       std::memory_order_relaxed);
+    }
+
+    std::array<std::atomic<count_type>, kBucketCount> counts_{};
+    std::atomic<count_type> count_{};
+    std::atomic<value_type> sum_{};
+    std::atomic<value_type> min_{std::numeric_limits<value_type>::max()};
+    std::atomic<value_type> max_{};
+};
+
+// Fixed set of per-thread histograms. Each recording thread attaches once and
+// records into its own slot without synchronization; snapshot() merges all
+// slots from any thread.
+template <std::size_t PrecisionBits = 5>
+class latency_histogram_group
+{
+   public:
+    using histogram_type = latency_histogram<PrecisionBits>;
+    using allocator_type = memory::allocator<std::byte>;
+
+   private:
+    struct slot
+    {
+        alignas(kCacheLineSize) std::atomic<bool> claimed{};
+        histogram_type histogram;
+    };
+
+   public:
+    class handle
+    {
+       public:
+        handle() noexcept = default;
+        handle(const handle &) = delete;
+        handle &operator=(const handle &) = delete;
+
+        handle(handle &&aOther) noexcept
+            : slot_(std::exchange(aOther.slot_, nullptr))
+        {
+        }
+
+        handle &operator=(handle &&aOther) noexcept
+        {
+            if (this != &aOther)
+            {
+                detach();
+                slot_ = std::exchange(aOther.slot_, nullptr);
+            }
+            return *this;
+        }
+
+        ~handle() { detach(); }
+
+        explicit operator bool() const noexcept { return slot_; }
+
+        histogram_type &histogram() const noexcept
+        {
+            assert(slot_);
+            return slot_->histogram;
+        }
+
+        template <typename Value>
+        void record(Value aValue) const noexcept
+        {
+            histogram().record(aValue);
+        }
+
+        typename histogram_type::sink_type sink() const noexcept
+        {
+            return histogram().sink();
+        }
+
+        // The slot keeps its counts; a later attach() continues from them.
+        void detach() noexcept
+        {
+            if (slot_)
+            {
+                slot_->claimed.store(false, std::memory_order_release);
+                slot_ = nullptr;
+            }
+        }
+
+       private:
+        friend class latency_histogram_group;
+
+        explicit handle(slot *aSlot) noexcept : slot_(aSlot) {}
+
+        slot *slot_{};
+    };
+
+    explicit latency_histogram_group(
+        std::size_t aMaxThreads, const allocator_type &aAllocator = {}) noexcept
+        : alloc_(aAllocator), size_(aMaxThreads)
+    {
+        slots_ = alloc_.allocate_object<slot>(size_);
+        UTILS_ABORT_IF_REASON(!slots_, "failed to allocate %zu histograms",
+                              size_);
+        for (std::size_t i = 0; i < size_; ++i)
+        {
+            new (slots_ + i) slot();
+        }
+    }
+
+    latency_histogram_group(const latency_histogram_group &) = delete;
+    latency_histogram_group &operator=(const latency_histogram_group &) =
+        delete;
+
+    ~latency_histogram_group()
+    {
+        for (std::size_t i = 0; i < size_; ++i)
+        {
+            assert(!slots_[i].claimed.load() && "handle outlives its group");
+            slots_[i].~slot();
+        }
+        alloc_.deallocate_object(slots_);
+    }
+
+    // Returns an empty handle when every slot is in use.
+    [[nodiscard]] handle attach() noexcept
+    {
+        for (std::size_t i = 0; i < size_; ++i)
+        {
+            bool expected = false;
+            if (!slots_[i].claimed.load(std::memory_order_relaxed) &&
+                slots_[i].claimed.compare_exchange_strong(
+                    expected, true, std::memory_order_acquire))
+            {
+                return handle(slots_ + i);
+            }
+        }
+        return {};
+    }
+
+    histogram_type snapshot() const noexcept
+    {
+        histogram_type result;
+        for (std::size_t i = 0; i < size_; ++i)
+        {
+            result.merge(slots_[i].histogram);
+        }
+        return result;
+    }
+
+    // Not safe while any thread records.
+    void reset() noexcept
+    {
+        for (std::size_t i = 0; i < size_; ++i)
+        {
+            slots_[i].histogram.reset();
+        }
+    }
+
+    std::size_t max_threads() const noexcept { return size_; }
+
+   private:
+    allocator_type alloc_;
+    slot *slots_{};
+    std::size_t size_{};
+};
+}  // namespace utils
+
+#endif /* utils_latency_histogram_h */
@@ -1,7 +1,11 @@
 #ifndef utils_allocator_h
 #define utils_allocator_h
 
+#include <memory>
+#include <new>
+#include <tuple>
 #include <type_traits>
+#include <utility>
 
 #include "memory.h"
 
@@ -9,9 +13,174 @@ namespace utils
 {
 namespace memory
 {
+template <typename T, typename Alloc, typename... Args>
+auto uses_allocator_construction_args(const Alloc& aAlloc,
+                                      Args&&... aArgs) noexcept;
+
+namespace details
+{
+template <typename T>
+struct is_pair : std::false_type
+{
+};
+
+template <typename T1, typename T2>
+struct is_pair<std::pair<T1, T2>> : std::true_type
+{
+};
+
+template <typename T>
+inline constexpr bool is_pair_v = is_pair<T>::value;
+
+template <typename T>
+struct dependent_false : std::false_type
+{
+};
+
+template <typename T, typename Alloc, typename Tuple1, typename Tuple2>
+auto pair_construction_args(const Alloc& aAlloc, std::piecewise_construct_t,
+                            Tuple1&& aFirst, Tuple2&& aSecond) noexcept
+{
+    return std::make_tuple(
+        std::piecewise_construct,
+        std::apply(
+            [&aAlloc](auto&&... aArgs) noexcept
+            {
+                return uses_allocator_construction_args<
+                    typename T::first_type>(
+                    aAlloc, std::forward<decltype(aArgs)>(aArgs)...);
+            },
+            std::forward<Tuple1>(aFirst)),
+        std::apply(
+            [&aAlloc](auto&&... aArgs) noexcept
+            {
+                return uses_allocator_construction_args<
+                    typename T::second_type>(
+                    aAlloc, std::forward<decltype(aArgs)>(aArgs)...);
+            },
+            std::forward<Tuple2>(aSecond)));
+}
+
+template <typename T, typename Alloc>
+auto pair_construction_args(const Alloc& aAlloc) noexcept
+{
+    return pair_construction_args<T>(aAlloc, std::piecewise_construct,
+                                     std::tuple<>{}, std::tuple<>{});
+}
+
+template <typename T, typename Alloc, typename U, typename V>
+auto pair_construction_args(const Alloc& aAlloc, U&& aFirst,
+                            V&& aSecond) noexcept
+{
+    return pair_construction_args<T>(
+        aAlloc, std::piecewise_construct,
+        std::forward_as_tuple(std::forward<U>(aFirst)),
+        std::forward_as_tuple(std::forward<V>(aSecond)));
+}
+
+template <typename T, typename Alloc, typename U, typename V>
+auto pair_construction_args(const Alloc& aAlloc,
+                            const std::pair<U, V>& aPair) noexcept
+{
+    return pair_construction_args<T>(aAlloc, std::piecewise_construct,
+                                     std::forward_as_tuple(aPair.first),
+                                     std::forward_as_tuple(aPair.second));
+}
+
+template <typename T, typename Alloc, typename U, typename V>
+auto pair_construction_args(const Alloc& aAlloc,
+                            std::pair<U, V>&& aPair) noexcept
+{
+    return pair_construction_args<T>(
+        aAlloc, std::piecewise_construct,
+        std::forward_as_tuple(std::get<0>(std::move(aPair))),
+        std::forward_as_tuple(std::get<1>(std::move(aPair))));
+}
+}  // namespace details
+
+// C++17 counterpart of std::uses_allocator_construction_args: returns the
+// argument tuple that constructs T from aArgs and, if T uses allocators,
+// passes aAlloc down using the leading-allocator or trailing-allocator
+// convention. Pairs are handled element-wise.
+template <typename T, typename Alloc, typename... Args>
+auto uses_allocator_construction_args(const Alloc& aAlloc,
+                                      Args&&... aArgs) noexcept
+{
+    if constexpr (details::is_pair_v<T>)
+    {
+        return details::pair_construction_args<T>(
+            aAlloc, std::forward<Args>(aArgs)...);
+    }
+    else if constexpr (!std::uses_allocator_v<T, Alloc>)
+    {
+        return std::forward_as_tuple(std::forward<Args>(aArgs)...);
+    }
+    else if constexpr (std::is_constructible_v<T, std::allocator_arg_t,
+                                               const Alloc&, Args...>)
+    {
+        return std::tuple<std::allocator_arg_t, const Alloc&, Args&&...>(
+            std::allocator_arg, aAlloc, std::forward<Args>(aArgs)...);
+    }
+    else if constexpr (std::is_constructible_v<T, Args..., const Alloc&>)
+    {
+        return std::forward_as_tuple(std::forward<Args>(aArgs)..., aAlloc);
+    }
+    else
+    {
+        static_assert(details::dependent_false<T>::value,
+                      "T uses allocator but has no allocator-extended "
+                      "constructor for these arguments");
+    }
+}
+
+namespace details
+{
+// Whether T is nothrow constructible from the arguments in Tuple, as produced
+// by uses_allocator_construction_args; pairs are checked element-wise.
+template <typename T, typename Tuple>
+struct is_nothrow_constructible_from_tuple : std::false_type
+{
+};
+
+template <typename T, typename... Args>
+struct is_nothrow_constructible_from_tuple<T, std::tuple<Args...>>
+    : std::is_nothrow_constructible<T, Args...>
+{
+};
+
+template <typename T1, typename T2, typename Tuple1, typename Tuple2>
+struct is_nothrow_constructible_from_tuple<
+    std::pair<T1, T2>, std::tuple<std::piecewise_construct_t, Tuple1, Tuple2>>
+    : std::conjunction<is_nothrow_constructible_from_tuple<T1, Tuple1>,
+                       is_nothrow_constructible_from_tuple<T2, Tuple2>>
+{
+};
+}  // namespace details
+
+// Whether uses-allocator construction of T from Args with Alloc is noexcept.
+template <typename T, typename Alloc, typename... Args>
+inline constexpr bool is_nothrow_uses_allocator_constructible_v =
+    details::is_nothrow_constructible_from_tuple<
+        T, decltype(uses_allocator_construction_args<T>(
+               std::declval<const Alloc&>(), std::declval<Args>()...))>::value;
+
+template <typename T, typename Alloc, typename... Args>
+T* uninitialized_construct_using_allocator(T* aPtr, const Alloc& aAlloc,
+                                           Args&&... aArgs) noexcept
+{
+    return std::apply(
+        [aPtr](auto&&... aArgs) noexcept
+        { return new (aPtr) T(std::forward<decltype(aArgs)>(aArgs)...); },
+        uses_allocator_construction_args<T>(aAlloc,
+                                            std::forward<Args>(aArgs)...));
+}
+
 template <typename T>
 class allocator
 {
+    template <typename U>
+    friend class allocator;
+
    public:
     using value_type = T;
 
@@ -32,12 +201,23 @@ class allocator
             resource_->allocate(aCount * sizeof(T), alignof(T)));
     }
 
+    [[nodiscard]] allocation_result<T*> allocate_at_least(
+        std::size_t aCount) noexcept
+    {
+        const auto result =
+            resource_->allocate_at_least(aCount * sizeof(T), alignof(T));
+        return {static_cast<T*>(result.ptr), result.count / sizeof(T)};
+    }
+
     void deallocate(T* aPtr) noexcept { resource_->deallocate(aPtr); }
 
+    // Constructs U in place, passing this allocator on to U (or to both
+    // members of a pair) when U uses allocators.
     template <typename U, typename... Args>
     void construct(U* aPtr, Args&&... aArgs) noexcept
     {
-        new (aPtr) U(std::forward<T>(aArgs)...);
+        uninitialized_construct_using_allocator(aPtr, *this,
+                                                std::forward<Args>(aArgs)...);
     }
 
     [[nodiscard]] void* allocate_bytes(
@@ -64,11 +244,15 @@ class allocator
     template <typename U, typename... CtorArgs>
     [[nodiscard]] U* new_object(CtorArgs&&... aArgs) noexcept
     {
-        static_assert(std::is_nothrow_constructible_v<U, CtorArgs...>);
+        static_assert(
+            is_nothrow_uses_allocator_constructible_v<U, allocator,
+                                                      CtorArgs...>,
+            "U must be nothrow constructible from the arguments, including "
+            "the allocator it is passed");
         U* ptr = this->allocate_object<U>();
         if (ptr)
         {
-            this->construct(ptr, aArgs...);
+            this->construct(ptr, std::forward<CtorArgs>(aArgs)...);
         }
         return ptr;
     }
@@ -104,7 +288,7 @@ class allocator
 template <class T1, class T2>
 bool operator==(const allocator<T1>& aLhs, const allocator<T2>& aRhs) noexcept
 {
-    return *aLhs.resource_ == *aRhs.resource_;
+    return *aLhs.resource() == *aRhs.resource();
 }
 
 template <class T1, class T2>
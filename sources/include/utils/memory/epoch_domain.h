@@ -0,0 +1,379 @@
+#ifndef utils_epoch_domain_h
+#define utils_epoch_domain_h
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+#include "../common.h"
+#include "../padding_checker.h"
+#include "../small_vector.h"
+#include "allocator.h"
+#include "memory.h"
+
+namespace utils
+{
+namespace memory
+{
+// Epoch-based reclamation: readers pin the current epoch while they may hold
+// pointers into a lock-free structure, writers retire unlinked blocks instead
+// of deallocating them. A block retired in epoch E is returned to its
+// memory_resource once the global epoch reaches E + 2, which can only happen
+// after every reader pinned at or before E has unpinned.
+class epoch_domain
+{
+    using destroy_t = void (*)(void *aPtr) noexcept;
+
+    struct retired
+    {
+        void *ptr;
+        memory_resource *resource;
+        destroy_t destroy;
+    };
+
+    static constexpr std::size_t kInlineRetired = 8;
+    using limbo_list = small_vector<retired, kInlineRetired>;
+
+    struct bucket
+    {
+        explicit bucket(const allocator<retired> &aAllocator) noexcept
+            : items(aAllocator)
+        {
+        }
+
+        std::uint64_t epoch{};
+        limbo_list items;
+    };
+
+    struct alignas(kCacheLineSize) record
+    {
+        explicit record(const allocator<retired> &aAllocator) noexcept
+            : limbo{{bucket(aAllocator), bucket(aAllocator),
+                     bucket(aAllocator)}}
+        {
+        }
+
+        // Read by every thread that tries to advance the epoch.
+        std::atomic<std::uint64_t> state{};
+        std::atomic<bool> claimed{};
+
+        // Touched by the owning participant only.
+        alignas(kCacheLineSize) std::size_t nesting{};
+        std::size_t pending{};
+        std::array<bucket, 3> limbo;
+    };
+
+    static_assert(is_cache_line_isolated_v<record>);
+
+   public:
+    using allocator_type = allocator<std::byte>;
+
+    static constexpr std::size_t kCollectThreshold = 64;
+
+    class guard
+    {
+       public:
+        guard() noexcept = default;
+        guard(const guard &) = delete;
+        guard &operator=(const guard &) = delete;
+
+        guard(guard &&aOther) noexcept
+            : domain_(std::exchange(aOther.domain_, nullptr))
+            , record_(std::exchange(aOther.record_, nullptr))
+        {
+        }
+
+        guard &operator=(guard &&aOther) noexcept
+        {
+            if (this != &aOther)
+            {
+                release();
+                domain_ = std::exchange(aOther.domain_, nullptr);
+                record_ = std::exchange(aOther.record_, nullptr);
+            }
+            return *this;
+        }
+
+        ~guard() { release(); }
+
+        explicit operator bool() const noexcept { return record_; }
+
+        void release() noexcept
+        {
+            if (record_)
+            {
+                domain_->unpin(*record_);
+                domain_ = nullptr;
+                record_ = nullptr;
+            }
+        }
+
+       private:
+        friend class epoch_domain;
+
+        guard(epoch_domain *aDomain, record *aRecord) noexcept
+            : domain_(aDomain), record_(aRecord)
+        {
+            domain_->pin(*record_);
+        }
+
+        epoch_domain *domain_{};
+        record *record_{};
+    };
+
+    // Per-thread handle to the domain. A participant must only be used by one
+    // thread at a time.
+    class participant
+    {
+       public:
+        participant() noexcept = default;
+        participant(const participant &) = delete;
+        participant &operator=(const participant &) = delete;
+
+        participant(participant &&aOther) noexcept
+            : domain_(std::exchange(aOther.domain_, nullptr))
+            , record_(std::exchange(aOther.record_, nullptr))
+        {
+        }
+
+        participant &operator=(participant &&aOther) noexcept
+        {
+            if (this != &aOther)
+            {
+                detach();
+                domain_ = std::exchange(aOther.domain_, nullptr);
+                record_ = std::exchange(aOther.record_, nullptr);
+            }
+            return *this;
+        }
+
+        ~participant() { detach(); }
+
+        explicit operator bool() const noexcept { return record_; }
+
+        [[nodiscard]] guard pin() noexcept
+        {
+            assert(record_);
+            return guard(domain_, record_);
+        }
+
+        template <typename T>
+        void retire(T *aPtr, memory_resource *aResource) noexcept
+        {
+            static_assert(std::is_nothrow_destructible_v<T>);
+            destroy_t destroy = nullptr;
+            if constexpr (!std::is_trivially_destructible_v<T>)
+            {
+                destroy = [](void *aObj) noexcept
+                { static_cast<T *>(aObj)->~T(); };
+            }
+            retire_impl(aPtr, aResource, destroy);
+        }
+
+        void retire_bytes(void *aPtr, memory_resource *aResource) noexcept
+        {
+            retire_impl(aPtr, aResource, nullptr);
+        }
+
+        // Tries to advance the epoch and returns the number of blocks that
+        // were handed back to their resources.
+        std::size_t collect() noexcept
+        {
+            assert(record_);
+            domain_->try_advance();
+            return domain_->reclaim(*record_);
+        }
+
+        std::size_t pending() const noexcept
+        {
+            return record_ ? record_->pending : 0;
+        }
+
+        void detach() noexcept
+        {
+            if (record_)
+            {
+                assert(!record_->nesting && "detached while pinned");
+                record_->claimed.store(false, std::memory_order_release);
+                domain_ = nullptr;
+                record_ = nullptr;
+            }
+        }
+
+       private:
+        friend class epoch_domain;
+
+        participant(epoch_domain *aDomain, record *aRecord) noexcept
+            : domain_(aDomain), record_(aRecord)
+        {
+        }
+
+        void retire_impl(void *aPtr, memory_resource *aResource,
+                         destroy_t aDestroy) noexcept
+        {
+            assert(record_);
+            assert(aResource);
+            if (!aPtr)
+            {
+                return;
+            }
+            domain_->push_retired(*record_, {aPtr, aResource, aDestroy});
+            if (record_->pending >= kCollectThreshold)
+            {
+                collect();
+            }
+        }
+
+        epoch_domain *domain_{};
+        record *record_{};
+    };
+
+    explicit epoch_domain(std::size_t aMaxParticipants = 64,
+                          const allocator_type &aAllocator = {}) noexcept
+        : alloc_(aAllocator), size_(aMaxParticipants)
+    {
+        records_ = alloc_.allocate_object<record>(size_);
+        UTILS_ABORT_IF_REASON(!records_,
+                              "failed to allocate %zu epoch records", size_);
+        for (std::size_t i = 0; i < size_; ++i)
+        {
+            new (records_ + i) record(alloc_.resource());
+        }
+    }
+
+    epoch_domain(const epoch_domain &) = delete;
+    epoch_domain &operator=(const epoch_domain &) = delete;
+
+    ~epoch_domain()
+    {
+        for (std::size_t i = 0; i < size_; ++i)
+        {
+            record &r = records_[i];
+            assert(!r.claimed.load() && "participant outlives its domain");
+            for (auto &b: r.limbo)
+            {
+                free_all(b.items);
+            }
+            r.~record();
+        }
+        alloc_.deallocate_object(records_);
+    }
+
+    // Returns an empty participant when all records are in use.
+    [[nodiscard]] participant attach() noexcept
+    {
+        for (std::size_t i = 0; i < size_; ++i)
+        {
+            bool expected = false;
+            if (!records_[i].claimed.load(std::memory_order_relaxed) &&
+                records_[i].claimed.compare_exchange_strong(
+                    expected, true, std::memory_order_acquire))
+            {
+                return participant(this, records_ + i);
+            }
+        }
+        return {};
+    }
+
+    bool try_advance() noexcept
+    {
+        std::uint64_t epoch = epoch_.load(std::memory_order_seq_cst);
+        for (std::size_t i = 0; i < size_; ++i)
+        {
+            const auto state =
+                records_[i].state.load(std::memory_order_seq_cst);
+            if ((state & kActive) && ((state >> 1) != epoch))
+            {
+                return false;
+            }
+        }
+        return epoch_.compare_exchange_strong(epoch, epoch + 1,
+                                              std::memory_order_seq_cst);
+    }
+
+    std::uint64_t epoch() const noexcept
+    {
+        return epoch_.load(std::memory_order_acquire);
+    }
+
+    std::size_t max_participants() const noexcept { return size_; }
+
+   private:
+    static constexpr std::uint64_t kActive = 1;
+
+    void pin(record &aRecord) noexcept
+    {
+        if (!aRecord.nesting++)
+        {
+            const auto epoch = epoch_.load(std::memory_order_relaxed);
+            aRecord.state.store((epoch << 1) | kActive,
+                                std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+    }
+
+    void unpin(record &aRecord) noexcept
+    {
+        assert(aRecord.nesting);
+        if (!--aRecord.nesting)
+        {
+            aRecord.state.store(0, std::memory_order_release);
+        }
+    }
+
+    void push_retired(record &aRecord, const retired &aRetired) noexcept
+    {
+        const auto epoch = epoch_.load(std::memory_order_seq_cst);
+        bucket &b = aRecord.limbo[epoch % aRecord.limbo.size()];
+        if (b.epoch != epoch)
+        {
+            // Anything left here was retired at least three epochs ago.
+            aRecord.pending -= free_all(b.items);
+            b.epoch = epoch;
+        }
+        b.items.push_back(aRetired);
+        ++aRecord.pending;
+    }
+
+    std::size_t reclaim(record &aRecord) noexcept
+    {
+        const auto epoch = epoch_.load(std::memory_order_seq_cst);
+        std::size_t count = 0;
+        for (auto &b: aRecord.limbo)
+        {
+            if (b.epoch + 2 <= epoch)
+            {
+                count += free_all(b.items);
+            }
+        }
+        aRecord.pending -= count;
+        return count;
+    }
+
+    static std::size_t free_all(limbo_list &aItems) noexcept
+    {
+        const std::size_t count = aItems.size();
+        for (const auto &r: aItems)
+        {
+            if (r.destroy)
+            {
+                r.destroy(r.ptr);
+            }
+            r.resource->deallocate(r.ptr);
+        }
+        aItems.clear();
+        return count;
+    }
+
+    allocator_type alloc_;
+    record *records_{};
+    std::size_t size_{};
+    alignas(kCacheLineSize) std::atomic<std::uint64_t> epoch_{};
+};
+}  // namespace memory
+}  // namespace utils
+
+#endif /* utils_epoch_domain_h */
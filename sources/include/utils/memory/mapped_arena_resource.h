@@ -0,0 +1,377 @@
+#ifndef utils_mapped_arena_resource_h
+#define utils_mapped_arena_resource_h
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <system_error>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "memory.h"
+
+namespace utils
+{
+namespace memory
+{
+namespace details
+{
+struct mapped_arena_header
+{
+    std::uint64_t magic;
+    std::uint32_t version;
+    std::uint32_t data_offset;
+    std::uint64_t base;
+    std::uint64_t size;
+    std::uint64_t used;
+    std::uint64_t root;
+};
+
+// "UTLARENA" read as a little-endian integer.
+inline constexpr std::uint64_t kMappedArenaMagic = 0x414e4552414c5455;
+inline constexpr std::uint32_t kMappedArenaVersion = 1;
+inline constexpr std::size_t kMappedArenaDataOffset =
+    next_multiple_of<std::size_t{64}>(sizeof(mapped_arena_header));
+}  // namespace details
+
+// Monotonic arena that lives in a memory-mapped file. Everything allocated
+// from it is written to the file, so structures built inside can be flushed
+// with snapshot() and mapped again on the next start without parsing. Raw
+// pointers inside the arena stay valid only when it is re-mapped at the same
+// base; otherwise store offsets (see relocated()).
+class mapped_arena_resource : public memory_resource
+{
+    friend class memory_resource;
+    using header = details::mapped_arena_header;
+
+   public:
+    enum class access
+    {
+        read_only,
+        read_write
+    };
+
+    mapped_arena_resource(const mapped_arena_resource &) = delete;
+    mapped_arena_resource &operator=(const mapped_arena_resource &) = delete;
+
+    // Creates (or truncates) aPath with room for aSize bytes of allocations
+    // and maps it. A non-null aBase must be page aligned, and the mapping
+    // then fails unless it lands exactly there.
+    mapped_arena_resource(const char *aPath, std::size_t aSize, void *aBase,
+                          std::error_code &aError) noexcept
+        : mapped_arena_resource()
+    {
+        aError.clear();
+#if defined(_WIN32)
+        (void)aPath;
+        (void)aSize;
+        (void)aBase;
+        aError = std::make_error_code(std::errc::not_supported);
+#else
+        const std::size_t length = details::kMappedArenaDataOffset + aSize;
+        fd_ = ::open(aPath, O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if ((fd_ < 0) || (::ftruncate(fd_, static_cast<off_t>(length)) != 0))
+        {
+            aError = last_error();
+            return;
+        }
+        if (!map(length, aBase, true, aError))
+        {
+            return;
+        }
+
+        header &h = *hdr();
+        h.magic = details::kMappedArenaMagic;
+        h.version = details::kMappedArenaVersion;
+        h.data_offset = details::kMappedArenaDataOffset;
+        h.base = reinterpret_cast<std::uintptr_t>(mapping_);
+        h.size = aSize;
+        h.used = 0;
+        h.root = 0;
+#endif
+    }
+
+    // Maps an existing arena file. The mapping is requested at the address
+    // recorded in the file; when aRequireSameBase is false it may land
+    // elsewhere, which relocated() then reports.
+    mapped_arena_resource(const char *aPath, access aAccess,
+                          bool aRequireSameBase,
+                          std::error_code &aError) noexcept
+        : mapped_arena_resource()
+    {
+        aError.clear();
+#if defined(_WIN32)
+        (void)aPath;
+        (void)aAccess;
+        (void)aRequireSameBase;
+        aError = std::make_error_code(std::errc::not_supported);
+#else
+        writable_ = aAccess == access::read_write;
+        fd_ = ::open(aPath, writable_ ? O_RDWR : O_RDONLY);
+        struct stat st;
+        if ((fd_ < 0) || (::fstat(fd_, &st) != 0))
+        {
+            aError = last_error();
+            return;
+        }
+
+        header h;
+        const auto file_size = static_cast<std::uint64_t>(st.st_size);
+        if ((file_size < sizeof(h)) ||
+            (::pread(fd_, &h, sizeof(h), 0) != sizeof(h)) ||
+            (h.magic != details::kMappedArenaMagic) ||
+            (h.version != details::kMappedArenaVersion) ||
+            (h.data_offset != details::kMappedArenaDataOffset) ||
+            (h.used > h.size) ||
+            (file_size < details::kMappedArenaDataOffset + h.size))
+        {
+            aError = std::make_error_code(std::errc::invalid_argument);
+            return;
+        }
+
+        void *base = reinterpret_cast<void *>(
+            static_cast<std::uintptr_t>(h.base));
+        map(details::kMappedArenaDataOffset + h.size, base, aRequireSameBase,
+            aError);
+#endif
+    }
+
+    ~mapped_arena_resource() override
+    {
+#if !defined(_WIN32)
+        if (mapping_)
+        {
+            ::munmap(mapping_, length_);
+        }
+        if (fd_ >= 0)
+        {
+            ::close(fd_);
+        }
+#endif
+    }
+
+    bool is_equal(const memory_resource &aOther) const noexcept override
+    {
+        return &aOther == this;
+    }
+
+    explicit operator bool() const noexcept { return mapping_; }
+
+    std::byte const *data() const noexcept { return data_; }
+
+    std::size_t size() const noexcept { return mapping_ ? hdr()->size : 0; }
+
+    std::size_t used() const noexcept { return mapping_ ? hdr()->used : 0; }
+
+    bool writable() const noexcept { return writable_; }
+
+    // True when the arena was mapped at a different address than the one it
+    // was created at; raw pointers stored inside are then invalid.
+    bool relocated() const noexcept { return relocation_offset() != 0; }
+
+    std::ptrdiff_t relocation_offset() const noexcept
+    {
+        if (!mapping_)
+        {
+            return 0;
+        }
+        return static_cast<std::ptrdiff_t>(
+            reinterpret_cast<std::uintptr_t>(mapping_) - hdr()->base);
+    }
+
+    // The root is the entry point a reader uses to find the structures built
+    // inside the arena. It is stored as an offset, so it survives relocation.
+    void set_root(const void *aRoot) noexcept
+    {
+        assert(mapping_ && writable_);
+        assert(!aRoot || contains(aRoot));
+        hdr()->root =
+            aRoot ? static_cast<std::uint64_t>(
+                        static_cast<const std::byte *>(aRoot) - data_ + 1)
+                  : 0;
+    }
+
+    void *root() const noexcept
+    {
+        if (!mapping_ || !hdr()->root)
+        {
+            return nullptr;
+        }
+        return data_ + (hdr()->root - 1);
+    }
+
+    template <typename T>
+    T *root_as() const noexcept
+    {
+        return static_cast<T *>(root());
+    }
+
+    bool contains(const void *aPtr) const noexcept
+    {
+        return std::less_equal<const void *>{}(data_, aPtr) &&
+               std::less<const void *>{}(aPtr, data_ + size());
+    }
+
+    // Writes everything allocated so far, together with the header, to the
+    // file and waits for completion.
+    std::error_code snapshot() noexcept
+    {
+#if defined(_WIN32)
+        return std::make_error_code(std::errc::not_supported);
+#else
+        if (!mapping_)
+        {
+            return std::make_error_code(std::errc::bad_file_descriptor);
+        }
+        if (!writable_)
+        {
+            return {};
+        }
+        const std::size_t page = page_size();
+        const std::size_t dirty = next_multiple_of(
+            page, details::kMappedArenaDataOffset + hdr()->used);
+        if (::msync(mapping_, std::min(dirty, length_), MS_SYNC) != 0)
+        {
+            return last_error();
+        }
+        return {};
+#endif
+    }
+
+    void release() noexcept
+    {
+        if (mapping_ && writable_)
+        {
+            hdr()->used = 0;
+            hdr()->root = 0;
+        }
+    }
+
+   private:
+    mapped_arena_resource() noexcept
+        : memory_resource(
+              &mapped_arena_resource::allocate<mapped_arena_resource>,
+              &mapped_arena_resource::deallocate<mapped_arena_resource>,
+              &mapped_arena_resource::allocate_at_least<
+                  mapped_arena_resource>)
+    {
+    }
+
+    header *hdr() const noexcept { return static_cast<header *>(mapping_); }
+
+#if !defined(_WIN32)
+    static std::error_code last_error() noexcept
+    {
+        return {errno, std::system_category()};
+    }
+
+    static std::size_t page_size() noexcept
+    {
+        return static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    }
+
+    bool map(std::size_t aLength, void *aBase, bool aExact,
+             std::error_code &aError) noexcept
+    {
+        assert(!aBase || is_aligned(aBase, page_size()));
+        const int prot = writable_ ? (PROT_READ | PROT_WRITE) : PROT_READ;
+        int flags = MAP_SHARED;
+#if defined(MAP_FIXED_NOREPLACE)
+        if (aBase && aExact)
+        {
+            flags |= MAP_FIXED_NOREPLACE;
+        }
+#endif
+        void *ptr = ::mmap(aBase, aLength, prot, flags, fd_, 0);
+        if (ptr == MAP_FAILED)
+        {
+            aError = last_error();
+            return false;
+        }
+        if (aBase && aExact && (ptr != aBase))
+        {
+            ::munmap(ptr, aLength);
+            aError = std::make_error_code(std::errc::address_in_use);
+            return false;
+        }
+
+        mapping_ = ptr;
+        length_ = aLength;
+        data_ = static_cast<std::byte *>(ptr) + details::kMappedArenaDataOffset;
+        return true;
+    }
+#endif
+
+    [[nodiscard]] void *allocate_impl(std::size_t aSize,
+                                      std::size_t aAlignment) noexcept
+    {
+        std::byte *const result = fit(aSize, aAlignment);
+        if (result)
+        {
+            hdr()->used = static_cast<std::uint64_t>(result + aSize - data_);
+        }
+        return result;
+    }
+
+    allocation_result<void *> allocate_at_least_impl(
+        std::size_t aSize, std::size_t aAlignment) noexcept
+    {
+        std::byte *const result = fit(aSize, aAlignment);
+        if (!result)
+        {
+            return {};
+        }
+
+        header &h = *hdr();
+        const auto size = std::min<std::size_t>(
+            next_multiple_of(alignof(std::max_align_t),
+                             reinterpret_cast<std::uintptr_t>(result + aSize)) -
+                reinterpret_cast<std::uintptr_t>(result),
+            static_cast<std::size_t>(data_ + h.size - result));
+        h.used = static_cast<std::uint64_t>(result + size - data_);
+        return {result, size};
+    }
+
+    // Where an aSize-byte block would start in the arena, or nullptr if it
+    // does not fit or the arena is not writable.
+    std::byte *fit(std::size_t aSize, std::size_t aAlignment) const noexcept
+    {
+        if (!aSize || !mapping_ || !writable_)
+        {
+            return nullptr;
+        }
+
+        assert(is_power_of_2(aAlignment));
+
+        const header &h = *hdr();
+        std::byte *const next = data_ + h.used;
+        std::byte *const result = next + skip_to_align(next, aAlignment);
+        std::byte *const end = data_ + h.size;
+        if (std::less<std::byte *>{}(end, result) ||
+            (static_cast<std::size_t>(end - result) < aSize))
+        {
+            return nullptr;
+        }
+        return result;
+    }
+
+    void deallocate_impl(void *) noexcept {}
+
+    void *mapping_{};
+    std::size_t length_{};
+    std::byte *data_{};
+    int fd_{-1};
+    bool writable_{true};
+};
+}  // namespace memory
+}  // namespace utils
+
+#endif /* utils_mapped_arena_resource_h */
@@ -154,6 +154,13 @@ constexpr void memcpy(To *aTo, const From *aFrom, std::size_t aCount) noexcept
     }
 }
 
+template <typename Pointer>
+struct allocation_result
+{
+    Pointer ptr{};
+    std::size_t count{};
+};
+
 class memory_resource
 {
    protected:
@@ -161,6 +168,8 @@ class memory_resource
         memory_resource::*)(std::size_t aSize, std::size_t aAlignment) noexcept;
     using deallocate_t =
         void (memory_resource::*)(void *aPtrToDeallocate) noexcept;
+    using allocate_at_least_t = allocation_result<void *> (
+        memory_resource::*)(std::size_t aSize, std::size_t aAlignment) noexcept;
 
     template <typename Resource>
     void *allocate(std::size_t aSize, std::size_t aAlignment) noexcept
@@ -174,8 +183,27 @@ class memory_resource
         static_cast<Resource *>(this)->deallocate_impl(aPtr);
     }
 
+    template <typename Resource>
+    allocation_result<void *> allocate_at_least(
+        std::size_t aSize, std::size_t aAlignment) noexcept
+    {
+        return static_cast<Resource *>(this)->allocate_at_least_impl(
+            aSize, aAlignment);
+    }
+
+    memory_resource(allocate_t aAllocate, deallocate_t aDeallocate,
+                    allocate_at_least_t aAllocateAtLeast) noexcept
+        : allocate_(aAllocate)
+        , deallocate_(aDeallocate)
+        , allocate_at_least_(aAllocateAtLeast)
+    {
+    }
+
+    // Resources without a native allocate_at_least report exactly the
+    // requested size.
     memory_resource(allocate_t aAllocate, deallocate_t aDeallocate) noexcept
-        : allocate_(aAllocate), deallocate_(aDeallocate)
+        : memory_resource(aAllocate, aDeallocate,
+                          &memory_resource::allocate_exactly)
     {
     }
 
@@ -199,6 +227,15 @@ class memory_resource
         std::invoke(deallocate_, this, aPtr);
     }
 
+    // Like allocate, but also reports how many bytes are actually usable at
+    // the returned address, which may be more than requested.
+    [[nodiscard]] allocation_result<void *> allocate_at_least(
+        std::size_t aSize,
+        std::size_t aAlignment = alignof(std::max_align_t)) noexcept
+    {
+        return std::invoke(allocate_at_least_, this, aSize, aAlignment);
+    }
+
     virtual bool is_equal(const memory_resource &aOther) const noexcept = 0;
 
     friend bool operator==(const memory_resource &a,
@@ -216,6 +253,15 @@ class memory_resource
    protected:
     allocate_t allocate_{};
     deallocate_t deallocate_{};
+    allocate_at_least_t allocate_at_least_{};
+
+   private:
+    allocation_result<void *> allocate_exactly(std::size_t aSize,
+                                               std::size_t aAlignment) noexcept
+    {
+        void *ptr = allocate(aSize, aAlignment);
+        return {ptr, ptr ? aSize : 0};
+    }
 };
 
 static memory_resource *system_memory_resource() noexcept;
@@ -243,7 +289,9 @@ class system_memory_resource : public memory_resource
     system_memory_resource()
         : memory_resource(
               &system_memory_resource::allocate<system_memory_resource>,
-              &system_memory_resource::deallocate<system_memory_resource>)
+              &system_memory_resource::deallocate<system_memory_resource>,
+              &system_memory_resource::allocate_at_least<
+                  system_memory_resource>)
     {
     }
 
@@ -253,6 +301,17 @@ class system_memory_resource : public memory_resource
         return aligned_malloc(aSize, aAlignment);
     }
 
+    // The usable size of an aligned_malloc block is not portably queryable,
+    // so only the alignment padding the allocator must add anyway is exposed.
+    allocation_result<void *> allocate_at_least_impl(
+        std::size_t aSize, std::size_t aAlignment) noexcept
+    {
+        const std::size_t size = next_multiple_of(
+            std::max(aAlignment, alignof(std::max_align_t)), aSize);
+        void *ptr = aligned_malloc(size, aAlignment);
+        return {ptr, ptr ? size : 0};
+    }
+
     void deallocate_impl(void *aPtr) noexcept { aligned_free(aPtr); }
 };
 
@@ -273,7 +332,8 @@ class null_memory_resource : public memory_resource
     null_memory_resource()
         : memory_resource(
               &null_memory_resource::allocate<null_memory_resource>,
-              &null_memory_resource::deallocate<null_memory_resource>)
+              &null_memory_resource::deallocate<null_memory_resource>,
+              &null_memory_resource::allocate_at_least<null_memory_resource>)
     {
     }
 
@@ -282,6 +342,12 @@ class null_memory_resource : public memory_resource
         return nullptr;
     }
 
+    allocation_result<void *> allocate_at_least_impl(std::size_t,
+                                                     std::size_t) noexcept
+    {
+        return {};
+    }
+
     void deallocate_impl(void *) noexcept {}
 };
 }  // namespace details
@@ -19,7 +19,9 @@ class monotonic_buffer_resource : public memory_resource
                               memory_resource *aUpstream) noexcept
         : memory_resource(
               &monotonic_buffer_resource::allocate<monotonic_buffer_resource>,
-              &monotonic_buffer_resource::deallocate<monotonic_buffer_resource>)
+              &monotonic_buffer_resource::deallocate<monotonic_buffer_resource>,
+              &monotonic_buffer_resource::allocate_at_least<
+                  monotonic_buffer_resource>)
         , data_(aSize ? aBuffer : nullptr)
         , size_(aBuffer ? aSize : 0)
         , upstream_(aUpstream)
@@ -66,28 +68,62 @@ class monotonic_buffer_resource : public memory_resource
             return nullptr;
         }
 
-        assert(is_power_of_2(aAlignment));
+        if (std::byte *const pointer = fit(aSize, aAlignment))
+        {
+            next_ = pointer + aSize;
+            return pointer;
+        }
+
+        return upstream_ ? upstream_->allocate(aSize, aAlignment) : nullptr;
+    }
+
+    // Padding up to the next max_align_t boundary would be skipped by the
+    // next typical allocation anyway, so it is handed to the caller.
+    allocation_result<void *> allocate_at_least_impl(
+        std::size_t aSize, std::size_t aAlignment) noexcept
+    {
+        if (!aSize)
+        {
+            return {};
+        }
 
-        std::byte *pointer{};
-        if (data_)
+        if (std::byte *const pointer = fit(aSize, aAlignment))
         {
-            const auto skip = skip_to_align(next_, aAlignment);
-            std::byte *supposed_result = next_ + skip;
-            if (std::less_equal<std::byte *>{}(supposed_result + aSize,
-                                               data_ + size_))
-            {
-                next_ = supposed_result + aSize;
-                pointer = supposed_result;
-            }
+            const auto size = std::min<std::size_t>(
+                next_multiple_of(
+                    alignof(std::max_align_t),
+                    reinterpret_cast<std::uintptr_t>(pointer + aSize)) -
+                    reinterpret_cast<std::uintptr_t>(pointer),
+                static_cast<std::size_t>(data_ + size_ - pointer));
+            next_ = pointer + size;
+            return {pointer, size};
         }
 
-        if (!pointer && upstream_)
+        if (upstream_)
         {
-            pointer = static_cast<std::byte *>(
-                upstream_->allocate(aSize, aAlignment));
+            return upstream_->allocate_at_least(aSize, aAlignment);
+        }
+
+        return {};
+    }
+
+    // Where an aSize-byte block would start in the buffer, or nullptr if
+    // it does not fit.
+    std::byte *fit(std::size_t aSize, std::size_t aAlignment) const noexcept
+    {
+        assert(is_power_of_2(aAlignment));
+
+        if (!data_)
+        {
+            return nullptr;
         }
 
-        return pointer;
+        std::byte *const supposed_result =
+            next_ + skip_to_align(next_, aAlignment);
+        return std::less_equal<std::byte *>{}(supposed_result + aSize,
+                                              data_ + size_)
+                   ? supposed_result
+                   : nullptr;
     }
 
     void deallocate_impl(void *) noexcept {}
@@ -0,0 +1,327 @@
+#ifndef utils_offset_ptr_h
+#define utils_offset_ptr_h
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+
+#include "../common.h"
+
+namespace utils
+{
+namespace memory
+{
+// Self-relative pointer: stores the distance from its own address to the
+// pointee, so a structure linked with offset_ptr stays valid when the memory
+// holding it is copied or mapped at another address as a whole. Like every
+// self-relative pointer it must live in the same block as its pointee.
+template <typename T>
+class offset_ptr
+{
+   public:
+    using element_type = T;
+    using value_type = std::remove_cv_t<T>;
+    using difference_type = std::ptrdiff_t;
+    using pointer = T *;
+    using reference = std::add_lvalue_reference_t<T>;
+    using iterator_category = std::random_access_iterator_tag;
+
+    template <typename U>
+    using rebind = offset_ptr<U>;
+
+    offset_ptr() noexcept = default;
+    offset_ptr(std::nullptr_t) noexcept {}
+    offset_ptr(T *aPtr) noexcept { set(aPtr); }
+    offset_ptr(const offset_ptr &aOther) noexcept { set(aOther.get()); }
+
+    template <typename U,
+              typename = std::enable_if_t<std::is_convertible_v<U *, T *>>>
+    offset_ptr(const offset_ptr<U> &aOther) noexcept
+    {
+        set(aOther.get());
+    }
+
+    offset_ptr &operator=(const offset_ptr &aOther) noexcept
+    {
+        set(aOther.get());
+        return *this;
+    }
+
+    offset_ptr &operator=(T *aPtr) noexcept
+    {
+        set(aPtr);
+        return *this;
+    }
+
+    template <typename U = T,
+              typename = std::enable_if_t<!std::is_void_v<U>>>
+    static offset_ptr pointer_to(U &aRef) noexcept
+    {
+        return offset_ptr(std::addressof(aRef));
+    }
+
+    T *get() const noexcept
+    {
+        if (offset_ == kNull)
+        {
+            return nullptr;
+        }
+        return reinterpret_cast<T *>(self() + offset_);
+    }
+
+    explicit operator bool() const noexcept { return offset_ != kNull; }
+
+    reference operator*() const noexcept
+    {
+        assert(*this);
+        return *get();
+    }
+
+    T *operator->() const noexcept
+    {
+        assert(*this);
+        return get();
+    }
+
+    reference operator[](difference_type aIndex) const noexcept
+    {
+        return get()[aIndex];
+    }
+
+    offset_ptr &operator+=(difference_type aCount) noexcept
+    {
+        return *this = get() + aCount;
+    }
+
+    offset_ptr &operator-=(difference_type aCount) noexcept
+    {
+        return *this = get() - aCount;
+    }
+
+    offset_ptr &operator++() noexcept { return *this += 1; }
+    offset_ptr &operator--() noexcept { return *this -= 1; }
+
+    offset_ptr operator++(int) noexcept
+    {
+        offset_ptr result(get());
+        ++*this;
+        return result;
+    }
+
+    offset_ptr operator--(int) noexcept
+    {
+        offset_ptr result(get());
+        --*this;
+        return result;
+    }
+
+    friend offset_ptr operator+(const offset_ptr &aPtr,
+                                difference_type aCount) noexcept
+    {
+        return offset_ptr(aPtr.get() + aCount);
+    }
+
+    friend offset_ptr operator-(const offset_ptr &aPtr,
+                                difference_type aCount) noexcept
+    {
+        return offset_ptr(aPtr.get() - aCount);
+    }
+
+    friend difference_type operator-(const offset_ptr &aLhs,
+                                     const offset_ptr &aRhs) noexcept
+    {
+        return aLhs.get() - aRhs.get();
+    }
+
+    friend bool operator==(const offset_ptr &aLhs,
+                           const offset_ptr &aRhs) noexcept
+    {
+        return aLhs.get() == aRhs.get();
+    }
+
+    friend bool operator!=(const offset_ptr &aLhs,
+                           const offset_ptr &aRhs) noexcept
+    {
+        return !(aLhs == aRhs);
+    }
+
+    friend bool operator<(const offset_ptr &aLhs,
+                          const offset_ptr &aRhs) noexcept
+    {
+        return std::less<T *>{}(aLhs.get(), aRhs.get());
+    }
+
+   private:
+    // An offset of one byte would point inside the offset_ptr itself, so it
+    // is free to encode null.
+    static constexpr difference_type kNull = 1;
+
+    std::uintptr_t self() const noexcept
+    {
+        return reinterpret_cast<std::uintptr_t>(this);
+    }
+
+    void set(T *aPtr) noexcept
+    {
+        if (!aPtr)
+        {
+            offset_ = kNull;
+            return;
+        }
+        offset_ = static_cast<difference_type>(
+            reinterpret_cast<std::uintptr_t>(aPtr) - self());
+        assert(offset_ != kNull);
+    }
+
+    difference_type offset_{kNull};
+};
+
+// Minimal Arena for arena_ptr: a process-wide base address selected by Tag
+// and bound once the backing memory is mapped.
+template <typename Tag>
+class arena_base
+{
+   public:
+    static std::byte *base() noexcept { return base_; }
+
+    static void bind(void *aBase) noexcept
+    {
+        base_ = static_cast<std::byte *>(aBase);
+    }
+
+   private:
+    static inline std::byte *base_{};
+};
+
+namespace details
+{
+template <typename T>
+inline constexpr std::size_t arena_granularity_v =
+    std::conditional_t<std::is_void_v<T>,
+                       std::integral_constant<std::size_t, 1>,
+                       std::alignment_of<T>>::value;
+}  // namespace details
+
+// Compressed pointer stored as a Bits-wide index relative to Arena::base(),
+// counted in units of alignof(T) (bytes for void). With the default 32 bits
+// it covers almost 4 GiB * alignof(T) of arena and halves the size of node
+// links. Index zero is null, so a pointer is stored as its offset in granules
+// plus one: the arena base itself is addressable, and only kMaxIndex granules
+// (offsets 0 to kMaxIndex - 1) can be reached.
+template <typename T, typename Arena, std::size_t Bits = 32>
+class arena_ptr
+{
+   public:
+    using element_type = T;
+    using index_type = uint_from_nbits_t<Bits>;
+    using difference_type = std::ptrdiff_t;
+    using reference = std::add_lvalue_reference_t<T>;
+
+    template <typename U>
+    using rebind = arena_ptr<U, Arena, Bits>;
+
+    static constexpr std::size_t kGranularity =
+        details::arena_granularity_v<T>;
+    static constexpr std::uint64_t kMaxIndex =
+        Bits == 64 ? ~std::uint64_t{} : (std::uint64_t{1} << Bits) - 1;
+
+    arena_ptr() noexcept = default;
+    arena_ptr(std::nullptr_t) noexcept {}
+    arena_ptr(T *aPtr) noexcept : index_(to_index(aPtr)) {}
+
+    // The index is recomputed since the granularity may differ.
+    template <typename U,
+              typename = std::enable_if_t<std::is_convertible_v<U *, T *>>>
+    arena_ptr(const arena_ptr<U, Arena, Bits> &aOther) noexcept
+        : index_(to_index(aOther.get()))
+    {
+    }
+
+    template <typename U = T,
+              typename = std::enable_if_t<!std::is_void_v<U>>>
+    static arena_ptr pointer_to(U &aRef) noexcept
+    {
+        return arena_ptr(std::addressof(aRef));
+    }
+
+    static arena_ptr from_index(index_type aIndex) noexcept
+    {
+        arena_ptr result;
+        result.index_ = aIndex;
+        return result;
+    }
+
+    index_type index() const noexcept { return index_; }
+
+    T *get() const noexcept
+    {
+        if (!index_)
+        {
+            return nullptr;
+        }
+        return reinterpret_cast<T *>(
+            Arena::base() + (static_cast<std::size_t>(index_) - 1) *
+                                kGranularity);
+    }
+
+    explicit operator bool() const noexcept { return index_; }
+
+    reference operator*() const noexcept
+    {
+        assert(index_);
+        return *get();
+    }
+
+    T *operator->() const noexcept
+    {
+        assert(index_);
+        return get();
+    }
+
+    reference operator[](difference_type aIndex) const noexcept
+    {
+        return get()[aIndex];
+    }
+
+    friend bool operator==(arena_ptr aLhs, arena_ptr aRhs) noexcept
+    {
+        return aLhs.index_ == aRhs.index_;
+    }
+
+    friend bool operator!=(arena_ptr aLhs, arena_ptr aRhs) noexcept
+    {
+        return aLhs.index_ != aRhs.index_;
+    }
+
+    friend bool operator<(arena_ptr aLhs, arena_ptr aRhs) noexcept
+    {
+        return aLhs.index_ < aRhs.index_;
+    }
+
+   private:
+    static index_type to_index(T *aPtr) noexcept
+    {
+        if (!aPtr)
+        {
+            return 0;
+        }
+        const std::byte *base = Arena::base();
+        const auto *bytes = reinterpret_cast<const std::byte *>(aPtr);
+        assert(base && (base <= bytes));
+        const auto offset = static_cast<std::uint64_t>(bytes - base);
+        assert(offset % kGranularity == 0);
+        const std::uint64_t index = offset / kGranularity + 1;
+        assert(index <= kMaxIndex && "arena_ptr index out of range");
+        return static_cast<index_type>(index);
+    }
+
+    index_type index_{};
+};
+}  // namespace memory
+}  // namespace utils
+
+#endif /* utils_offset_ptr_h */
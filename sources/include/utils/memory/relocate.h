@@ -0,0 +1,90 @@
+#ifndef utils_relocate_h
+#define utils_relocate_h
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "../detector.h"
+#include "memory.h"
+
+namespace utils
+{
+namespace details
+{
+template <typename T>
+using trivially_relocatable_tag = typename T::trivially_relocatable;
+}  // namespace details
+
+// Types may opt in either by specializing this trait or by declaring
+// "using trivially_relocatable = std::true_type;".
+template <typename T>
+struct is_trivially_relocatable
+    : std::disjunction<
+          std::is_trivially_copyable<T>,
+          is_detected_exact<std::true_type, details::trivially_relocatable_tag,
+                            T>>
+{
+};
+
+template <typename T>
+inline constexpr bool is_trivially_relocatable_v =
+    is_trivially_relocatable<T>::value;
+
+namespace memory
+{
+template <typename T>
+T *relocate(T *aSource, T *aDest) noexcept
+{
+    assert(aSource);
+    assert(aDest);
+    if constexpr (is_trivially_relocatable_v<T>)
+    {
+        memcpy(static_cast<void *>(aDest), static_cast<const void *>(aSource),
+               sizeof(T));
+    }
+    else
+    {
+        static_assert(std::is_nothrow_move_constructible_v<T>);
+        new (aDest) T(std::move(*aSource));
+        aSource->~T();
+    }
+    return aDest;
+}
+
+template <typename T>
+T *uninitialized_relocate(T *aFirst, T *aLast, T *aDest) noexcept
+{
+    if (aFirst == aLast)
+    {
+        return aDest;
+    }
+
+    assert(aFirst < aLast);
+    const auto count = static_cast<std::size_t>(aLast - aFirst);
+    if constexpr (is_trivially_relocatable_v<T>)
+    {
+        memcpy(static_cast<void *>(aDest), static_cast<const void *>(aFirst),
+               count * sizeof(T));
+        return aDest + count;
+    }
+    else
+    {
+        for (; aFirst != aLast; ++aFirst, ++aDest)
+        {
+            relocate(aFirst, aDest);
+        }
+        return aDest;
+    }
+}
+
+template <typename T>
+T *uninitialized_relocate_n(T *aFirst, std::size_t aCount, T *aDest) noexcept
+{
+    return uninitialized_relocate(aFirst, aFirst + aCount, aDest);
+}
+}  // namespace memory
+}  // namespace utils
+
+#endif /* utils_relocate_h */
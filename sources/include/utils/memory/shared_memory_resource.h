@@ -0,0 +1,432 @@
+#ifndef utils_shared_memory_resource_h
+#define utils_shared_memory_resource_h
+
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <system_error>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "../common.h"
+#include "memory.h"
+#include "simple_resource.h"
+
+namespace utils
+{
+namespace memory
+{
+// Position of a buffer inside a shared region; valid in every process that
+// maps the region. Zero is the null handle.
+struct shared_handle
+{
+    std::uint64_t offset{};
+
+    explicit operator bool() const noexcept { return offset; }
+
+    friend bool operator==(shared_handle aLhs, shared_handle aRhs) noexcept
+    {
+        return aLhs.offset == aRhs.offset;
+    }
+
+    friend bool operator!=(shared_handle aLhs, shared_handle aRhs) noexcept
+    {
+        return aLhs.offset != aRhs.offset;
+    }
+};
+
+namespace details
+{
+struct shared_region_header
+{
+    std::uint64_t magic;
+    std::uint64_t size;
+    std::uint64_t block_size;
+    std::uint64_t return_capacity;
+    std::uint64_t data_offset;
+    alignas(kCacheLineSize) std::atomic<std::uint64_t> return_tail;
+    alignas(kCacheLineSize) std::atomic<std::uint64_t> return_head;
+};
+
+struct shared_return_slot
+{
+    std::atomic<std::uint64_t> sequence;
+    std::uint64_t offset;
+};
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free);
+
+// "UTLSHMEM" read as a little-endian integer.
+inline constexpr std::uint64_t kSharedRegionMagic = 0x4d454d48534c5455;
+}  // namespace details
+
+// memory_resource over a shared memory region (memfd_create, or shm_open when
+// a name is given) for zero-copy exchange between co-located processes.
+//
+// The process that creates the region owns its simple_resource block
+// allocator. Peers attach by descriptor or by name, turn handles received
+// from the owner into pointers, and hand buffers back with deallocate(),
+// which queues them on a lock-free ring inside the region; the owner frees
+// them on its next allocation or reclaim(). Peers cannot allocate.
+template <std::size_t MaxBlockCount, std::size_t BlockSize>
+class shared_memory_resource : public memory_resource
+{
+    friend class memory_resource;
+    using header = details::shared_region_header;
+    using return_slot = details::shared_return_slot;
+    using block_resource = simple_resource<MaxBlockCount, BlockSize>;
+
+   public:
+    // Every allocation takes at least one block, so the ring can hold all of
+    // them and peers never wait for room.
+    static constexpr std::size_t kReturnCapacity =
+        std::size_t{1} << bits_count(MaxBlockCount - 1);
+
+    shared_memory_resource(const shared_memory_resource &) = delete;
+    shared_memory_resource &operator=(const shared_memory_resource &) =
+        delete;
+
+    // Creates a region with room for aSize bytes of buffers. A null aName
+    // creates an anonymous memfd, to be shared through fd(); a named region
+    // exists until remove() is called.
+    shared_memory_resource(const char *aName, std::size_t aSize,
+                           std::error_code &aError) noexcept
+        : shared_memory_resource()
+    {
+        aError.clear();
+#if defined(__linux__)
+        owner_ = true;
+        if (aName)
+        {
+            fd_ = ::shm_open(aName, O_RDWR | O_CREAT | O_EXCL, 0600);
+        }
+        else
+        {
+            fd_ = ::memfd_create("utils_shared_memory", MFD_CLOEXEC);
+        }
+
+        // The mapping and kDataOffset are block aligned, so the blocks start
+        // right at kDataOffset unless BlockSize exceeds the page size; only
+        // then is an extra block reserved for simple_resource's alignment
+        // skip.
+        const auto page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+        const std::size_t length = kDataOffset +
+                                   next_multiple_of<BlockSize>(aSize) +
+                                   (BlockSize > page ? BlockSize : 0);
+        if ((fd_ < 0) || (::ftruncate(fd_, static_cast<off_t>(length)) != 0))
+        {
+            aError = last_error();
+            return;
+        }
+        if (!map(length, aError))
+        {
+            return;
+        }
+
+        header *h = new (mapping_) header{};
+        h->magic = details::kSharedRegionMagic;
+        h->size = length;
+        h->block_size = BlockSize;
+        h->return_capacity = kReturnCapacity;
+        h->data_offset = kDataOffset;
+        for (std::size_t i = 0; i < kReturnCapacity; ++i)
+        {
+            new (slots() + i) return_slot{{i}, 0};
+        }
+        blocks_.emplace(base() + kDataOffset, length - kDataOffset, nullptr);
+#else
+        (void)aName;
+        (void)aSize;
+        aError = std::make_error_code(std::errc::not_supported);
+#endif
+    }
+
+    // Attaches to a region through a descriptor inherited or received from
+    // the owner. The descriptor is duplicated.
+    shared_memory_resource(int aFd, std::error_code &aError) noexcept
+        : shared_memory_resource()
+    {
+        aError.clear();
+#if defined(__linux__)
+        fd_ = ::fcntl(aFd, F_DUPFD_CLOEXEC, 0);
+        attach(aError);
+#else
+        (void)aFd;
+        aError = std::make_error_code(std::errc::not_supported);
+#endif
+    }
+
+    // Attaches to a region created under aName.
+    shared_memory_resource(const char *aName,
+                           std::error_code &aError) noexcept
+        : shared_memory_resource()
+    {
+        aError.clear();
+#if defined(__linux__)
+        fd_ = ::shm_open(aName, O_RDWR, 0);
+        attach(aError);
+#else
+        (void)aName;
+        aError = std::make_error_code(std::errc::not_supported);
+#endif
+    }
+
+    // Destroying the owner releases every block, including those still held
+    // by peers.
+    ~shared_memory_resource() override
+    {
+        if (blocks_)
+        {
+            blocks_->release();
+            blocks_.reset();
+        }
+#if defined(__linux__)
+        if (mapping_)
+        {
+            ::munmap(mapping_, length_);
+        }
+        if (fd_ >= 0)
+        {
+            ::close(fd_);
+        }
+#endif
+    }
+
+    bool is_equal(const memory_resource &aOther) const noexcept override
+    {
+        return &aOther == this;
+    }
+
+    static std::error_code remove(const char *aName) noexcept
+    {
+#if defined(__linux__)
+        if (::shm_unlink(aName) != 0)
+        {
+            return last_error();
+        }
+        return {};
+#else
+        (void)aName;
+        return std::make_error_code(std::errc::not_supported);
+#endif
+    }
+
+    explicit operator bool() const noexcept { return mapping_; }
+
+    bool owner() const noexcept { return owner_; }
+
+    int fd() const noexcept { return fd_; }
+
+    std::size_t size() const noexcept { return length_; }
+
+    shared_handle to_handle(const void *aPtr) const noexcept
+    {
+        if (!aPtr)
+        {
+            return {};
+        }
+        const auto *bytes = static_cast<const std::byte *>(aPtr);
+        assert((base() + kDataOffset <= bytes) && (bytes < base() + length_));
+        return {static_cast<std::uint64_t>(bytes - base())};
+    }
+
+    void *from_handle(shared_handle aHandle) const noexcept
+    {
+        if (!aHandle)
+        {
+            return nullptr;
+        }
+        assert((aHandle.offset >= kDataOffset) && (aHandle.offset < length_));
+        return base() + aHandle.offset;
+    }
+
+    // Frees the buffers peers have handed back and returns how many there
+    // were. Owner only.
+    std::size_t reclaim() noexcept
+    {
+        assert(owner_ && blocks_);
+        header &h = *hdr();
+        std::size_t count = 0;
+        std::uint64_t head = h.return_head.load(std::memory_order_relaxed);
+        for (;; ++head, ++count)
+        {
+            return_slot &s = slots()[head & (kReturnCapacity - 1)];
+            if (s.sequence.load(std::memory_order_acquire) != head + 1)
+            {
+                break;
+            }
+            // the slot is released before its block can be handed out again,
+            // so the ring never holds more entries than there are blocks
+            const std::uint64_t offset = s.offset;
+            s.sequence.store(head + kReturnCapacity, std::memory_order_release);
+            blocks_->deallocate(base() + offset);
+        }
+        h.return_head.store(head, std::memory_order_relaxed);
+        return count;
+    }
+
+    // Block allocator statistics; available in the owner only.
+    const block_resource *blocks() const noexcept
+    {
+        return blocks_ ? &*blocks_ : nullptr;
+    }
+
+   private:
+    static constexpr std::size_t kDataOffset = next_multiple_of<BlockSize>(
+        next_multiple_of<alignof(return_slot)>(sizeof(header)) +
+        kReturnCapacity * sizeof(return_slot));
+
+    shared_memory_resource() noexcept
+        : memory_resource(
+              &shared_memory_resource::allocate<shared_memory_resource>,
+              &shared_memory_resource::deallocate<shared_memory_resource>,
+              &shared_memory_resource::allocate_at_least<
+                  shared_memory_resource>)
+    {
+    }
+
+    std::byte *base() const noexcept
+    {
+        return static_cast<std::byte *>(mapping_);
+    }
+
+    header *hdr() const noexcept { return static_cast<header *>(mapping_); }
+
+    return_slot *slots() const noexcept
+    {
+        return reinterpret_cast<return_slot *>(
+            base() + next_multiple_of<alignof(return_slot)>(sizeof(header)));
+    }
+
+#if defined(__linux__)
+    static std::error_code last_error() noexcept
+    {
+        return {errno, std::system_category()};
+    }
+
+    bool map(std::size_t aLength, std::error_code &aError) noexcept
+    {
+        void *ptr = ::mmap(nullptr, aLength, PROT_READ | PROT_WRITE,
+                           MAP_SHARED, fd_, 0);
+        if (ptr == MAP_FAILED)
+        {
+            aError = last_error();
+            return false;
+        }
+        mapping_ = ptr;
+        length_ = aLength;
+        return true;
+    }
+
+    void attach(std::error_code &aError) noexcept
+    {
+        struct stat st;
+        if ((fd_ < 0) || (::fstat(fd_, &st) != 0))
+        {
+            aError = last_error();
+            return;
+        }
+
+        std::uint64_t fields[5];
+        if ((static_cast<std::size_t>(st.st_size) < sizeof(header)) ||
+            (::pread(fd_, fields, sizeof(fields), 0) != sizeof(fields)) ||
+            (fields[0] != details::kSharedRegionMagic) ||
+            (fields[1] != static_cast<std::uint64_t>(st.st_size)) ||
+            (fields[2] != BlockSize) || (fields[3] != kReturnCapacity) ||
+            (fields[4] != kDataOffset))
+        {
+            aError = std::make_error_code(std::errc::invalid_argument);
+            return;
+        }
+        map(static_cast<std::size_t>(st.st_size), aError);
+    }
+#endif
+
+    void give_back(std::uint64_t aOffset) noexcept
+    {
+        header &h = *hdr();
+        std::uint64_t pos = h.return_tail.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            return_slot &s = slots()[pos & (kReturnCapacity - 1)];
+            const auto seq = s.sequence.load(std::memory_order_acquire);
+            if (seq == pos)
+            {
+                if (h.return_tail.compare_exchange_weak(
+                        pos, pos + 1, std::memory_order_relaxed))
+                {
+                    s.offset = aOffset;
+                    s.sequence.store(pos + 1, std::memory_order_release);
+                    return;
+                }
+            }
+            else
+            {
+                // The ring has a slot for every block, so it is only full
+                // when a buffer was returned twice.
+                UTILS_ABORT_IF_REASON(static_cast<std::int64_t>(seq - pos) < 0,
+                                      "shared_memory_resource return ring is "
+                                      "full: a buffer was returned twice");
+                pos = h.return_tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    [[nodiscard]] void *allocate_impl(std::size_t aSize,
+                                      std::size_t aAlignment) noexcept
+    {
+        return allocate_at_least_impl(aSize, aAlignment).ptr;
+    }
+
+    allocation_result<void *> allocate_at_least_impl(
+        std::size_t aSize, std::size_t aAlignment) noexcept
+    {
+        if (!blocks_)
+        {
+            return {};
+        }
+        auto result = blocks_->allocate_at_least(aSize, aAlignment);
+        if (!result.ptr && reclaim())
+        {
+            result = blocks_->allocate_at_least(aSize, aAlignment);
+        }
+        return result;
+    }
+
+    void deallocate_impl(void *aPtr) noexcept
+    {
+        if (!aPtr)
+        {
+            return;
+        }
+        if (blocks_)
+        {
+            blocks_->deallocate(aPtr);
+        }
+        else
+        {
+            UTILS_ABORT_IF_REASON(!mapping_,
+                                  "deallocating %p on a detached "
+                                  "shared_memory_resource",
+                                  aPtr);
+            give_back(to_handle(aPtr).offset);
+        }
+    }
+
+    void *mapping_{};
+    std::size_t length_{};
+    int fd_{-1};
+    bool owner_{};
+    std::optional<block_resource> blocks_;
+};
+}  // namespace memory
+}  // namespace utils
+
+#endif /* utils_shared_memory_resource_h */
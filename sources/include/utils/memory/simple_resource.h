@@ -2,6 +2,7 @@
 #define utils_simple_resource_h
 
 #include <algorithm>
+#include <array>
 #include <bitset>
 #include <climits>
 #include <cstddef>
@@ -166,6 +167,24 @@ class simple_resource : public memory_resource
     static constexpr std::size_t kBlockSize = BlockSize;
     static constexpr std::size_t kMaxResourceSize = BlockSize * MaxBlockCount;
 
+    struct usage_stats
+    {
+        std::size_t free_bytes{};
+        std::size_t busy_bytes{};
+        std::size_t free_region_count{};
+        std::size_t largest_free_run{};
+        // Entry i counts free regions of [2^i, 2^(i+1)) blocks.
+        std::array<std::size_t, bits_count(MaxBlockCount)> free_histogram{};
+        // 1 - largest_free_run / free_bytes, 0 when there is no free space.
+        double external_fragmentation{};
+        std::size_t allocation_count{};
+        // Bytes lost to block rounding inside allocated regions.
+        double average_internal_waste{};
+        // Bytes of free blocks skipped to satisfy the requested alignment.
+        double average_alignment_skip{};
+        std::size_t upstream_spills{};
+    };
+
     ~simple_resource() override
     {
         UTILS_ABORT_IF(busy_count_,
@@ -214,7 +233,7 @@ class simple_resource : public memory_resource
     void release() noexcept
     {
         apply([this](BIndex aIndex) noexcept -> bool { return in_use(aIndex); },
-              [this](BIndex aIndex) mutable noexcept -> bool
+              [this](BIndex aIndex) mutable noexcept -> BIndex
               { return at(deallocate_blocks(aIndex)).next_index(); });
     }
 
@@ -256,6 +275,52 @@ class simple_resource : public memory_resource
 
     std::size_t size() const noexcept { return BlockSize * block_count_; }
 
+    usage_stats usage() const noexcept
+    {
+        usage_stats stats;
+        stats.allocation_count = allocation_count_;
+        stats.upstream_spills = upstream_spills_;
+        if (allocation_count_)
+        {
+            const auto count = static_cast<double>(allocation_count_);
+            stats.average_internal_waste =
+                static_cast<double>(rounding_waste_) / count;
+            stats.average_alignment_skip =
+                static_cast<double>(alignment_skip_) / count;
+        }
+        if (!data_ || !block_count_)
+        {
+            return stats;
+        }
+
+        BIndex i = 0;
+        do
+        {
+            const std::size_t blocks = block_size(i);
+            if (in_use(i))
+            {
+                stats.busy_bytes += blocks * BlockSize;
+            }
+            else
+            {
+                stats.free_bytes += blocks * BlockSize;
+                ++stats.free_region_count;
+                ++stats.free_histogram[bits_count(blocks) - 1];
+                stats.largest_free_run =
+                    std::max(stats.largest_free_run, blocks * BlockSize);
+            }
+            i = at(i).next_index();
+        } while (i);
+
+        if (stats.free_bytes)
+        {
+            stats.external_fragmentation =
+                1.0 - static_cast<double>(stats.largest_free_run) /
+                          static_cast<double>(stats.free_bytes);
+        }
+        return stats;
+    }
+
    private:
     friend void details::allocate_not_matched<simple_resource>(
         simple_resource &aResource, BIndex aFreeFirst, BIndex aFirst,
@@ -272,7 +337,8 @@ class simple_resource : public memory_resource
     simple_resource(std::tuple<std::byte *, std::size_t> aOriginAndBlockCount,
                     memory_resource *aUpstream) noexcept
         : memory_resource(&simple_resource::allocate<simple_resource>,
-                          &simple_resource::deallocate<simple_resource>)
+                          &simple_resource::deallocate<simple_resource>,
+                          &simple_resource::allocate_at_least<simple_resource>)
         , data_(std::get<0>(aOriginAndBlockCount))
         , block_count_(
               std::min(std::get<1>(aOriginAndBlockCount), MaxBlockCount))
@@ -282,16 +348,24 @@ class simple_resource : public memory_resource
 
     [[nodiscard]] void *allocate_impl(std::size_t aSize,
                                       std::size_t aAlignment) noexcept
+    {
+        return allocate_at_least_impl(aSize, aAlignment).ptr;
+    }
+
+    // The whole block-rounded region is usable by the caller.
+    allocation_result<void *> allocate_at_least_impl(
+        std::size_t aSize, std::size_t aAlignment) noexcept
     {
         if (!aSize)
         {
-            return nullptr;
+            return {};
         }
 
         assert(is_power_of_2(aAlignment));
         static_assert(is_power_of_2(BlockSize));
 
         std::byte *pointer = nullptr;
+        std::size_t usable = 0;
         if (data_)
         {
             const std::size_t kBufferAlignment =
@@ -301,8 +375,8 @@ class simple_resource : public memory_resource
             {
                 apply([this](BIndex aIndex) noexcept -> bool
                       { return not in_use(aIndex); },
-                      [this, &pointer, aAlignment,
-                       aSize](BIndex aIndex) mutable noexcept -> bool
+                      [this, &pointer, &usable, aAlignment,
+                       aSize](BIndex aIndex) mutable noexcept -> BIndex
                       {
                           const auto block_size = block_size_in_bytes(aIndex);
                           std::byte *const block_pointer =
@@ -313,6 +387,11 @@ class simple_resource : public memory_resource
                           {
                               pointer = block_pointer + skip;
                               allocate_blocks(aIndex, pointer, aSize);
+                              usable = block_size_in_bytes(
+                                  pointer_to_block_index(pointer));
+                              ++allocation_count_;
+                              alignment_skip_ += skip;
+                              rounding_waste_ += usable - aSize;
                               return 0;
                           }
                           return at(aIndex).next_index();
@@ -322,13 +401,15 @@ class simple_resource : public memory_resource
 
         if (!pointer && upstream_)
         {
-            pointer = static_cast<std::byte *>(
-                upstream_->allocate(aSize, aAlignment));
+            const auto result = upstream_->allocate_at_least(aSize, aAlignment);
+            pointer = static_cast<std::byte *>(result.ptr);
+            usable = result.count;
+            upstream_spills_ += pointer != nullptr;
         }
 
         assert(is_aligned(pointer, BlockSize));
 
-        return pointer;
+        return {pointer, usable};
     }
 
     void deallocate_impl(void *aPtr) noexcept
@@ -391,7 +472,7 @@ class simple_resource : public memory_resource
 
     template <typename Predicate, typename Action>
     std::enable_if_t<std::is_nothrow_invocable_r_v<bool, Predicate, BIndex> &&
-                     std::is_nothrow_invocable_r_v<bool, Action, BIndex>>
+                     std::is_nothrow_invocable_r_v<BIndex, Action, BIndex>>
     apply(Predicate &&aPredicate, Action &&aAction) noexcept
     {
         BIndex i = 0;
@@ -413,7 +494,7 @@ class simple_resource : public memory_resource
                          std::size_t aSize) noexcept
     {
         const BIndex first = pointer_to_block_index(aPtr);
-        const BIndex last = pointer_to_block_index(aPtr + aSize);
+        const BIndex last = pointer_to_block_index(aPtr + aSize - 1);
         const BIndex after_free = at(aFreeRegion).next_index();
         const BIndex last_of_free =
             after_free ? after_free - 1 : static_cast<BIndex>(block_count_ - 1);
@@ -553,6 +634,10 @@ class simple_resource : public memory_resource
     std::bitset<MaxBlockCount> in_use_{};
     std::size_t free_count_{1};
     std::size_t busy_count_{};
+    std::size_t allocation_count_{};
+    std::size_t rounding_waste_{};
+    std::size_t alignment_skip_{};
+    std::size_t upstream_spills_{};
 };
 }  // namespace memory
 }  // namespace utils
@@ -5,6 +5,8 @@
 #include <type_traits>
 #include <utility>
 
+#include "common.h"
+
 namespace utils
 {
 namespace pfr = boost::pfr;
@@ -53,6 +55,24 @@ struct has_padding
 
 template <typename T>
 inline constexpr bool has_padding_v = has_padding<T>::value;
+
+// True when no other object can share a cache line with any part of T.
+template <typename T, std::size_t LineSize = kCacheLineSize>
+struct is_cache_line_isolated
+    : std::bool_constant<(alignof(T) % LineSize == 0) &&
+                         (sizeof(T) % LineSize == 0)>
+{
+};
+
+template <typename T, std::size_t LineSize = kCacheLineSize>
+inline constexpr bool is_cache_line_isolated_v =
+    is_cache_line_isolated<T, LineSize>::value;
+
+template <typename T>
+struct alignas(kCacheLineSize) cache_line_padded
+{
+    T value;
+};
 }  // namespace utils
 
 #endif /* utils_padding_checker_h */
@@ -0,0 +1,359 @@
+#ifndef utils_perf_counters_h
+#define utils_perf_counters_h
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+namespace utils
+{
+enum class perf_counter : std::uint8_t
+{
+    kCycles,
+    kInstructions,
+    kCacheReferences,
+    kCacheMisses,
+    kBranchMisses,
+    kPageFaults,
+    kContextSwitches,
+    // Nanoseconds of CPU time.
+    kTaskClock,
+};
+
+inline constexpr std::size_t kPerfCounterCount = 8;
+
+// Where a perf_counter_group gets its values from.
+enum class perf_source : std::uint8_t
+{
+    kNone,
+    // getrusage() and the thread CPU clock; software counters only.
+    kRusage,
+    // perf_event_open() software events; the hardware PMU is unavailable.
+    kSoftware,
+    // perf_event_open() with at least one hardware counter.
+    kHardware,
+};
+
+struct perf_sample
+{
+    std::array<std::uint64_t, kPerfCounterCount> values{};
+    // Bit i is set when values[i] was measured.
+    std::uint32_t available{};
+
+    bool has(perf_counter aCounter) const noexcept
+    {
+        return available & (1u << static_cast<unsigned>(aCounter));
+    }
+
+    std::uint64_t operator[](perf_counter aCounter) const noexcept
+    {
+        return values[static_cast<std::size_t>(aCounter)];
+    }
+
+    friend perf_sample operator-(const perf_sample &aLhs,
+                                 const perf_sample &aRhs) noexcept
+    {
+        perf_sample result;
+        result.available = aLhs.available & aRhs.available;
+        for (std::size_t i = 0; i < kPerfCounterCount; ++i)
+        {
+            result.values[i] = aLhs.values[i] - aRhs.values[i];
+        }
+        return result;
+    }
+};
+
+namespace details
+{
+inline constexpr std::uint32_t kSoftwarePerfCounters =
+    (1u << static_cast<unsigned>(perf_counter::kPageFaults)) |
+    (1u << static_cast<unsigned>(perf_counter::kContextSwitches)) |
+    (1u << static_cast<unsigned>(perf_counter::kTaskClock));
+
+#if defined(__linux__)
+struct perf_event_spec
+{
+    std::uint32_t type;
+    std::uint64_t config;
+};
+
+inline constexpr std::array<perf_event_spec, kPerfCounterCount> kPerfEvents{{
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS},
+    {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES},
+    {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK},
+}};
+
+inline int open_perf_event(const perf_event_spec &aSpec, int aGroup) noexcept
+{
+    perf_event_attr attr{};
+    attr.size = sizeof(attr);
+    attr.type = aSpec.type;
+    attr.config = aSpec.config;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                       PERF_FORMAT_TOTAL_TIME_RUNNING;
+    attr.disabled = aGroup < 0;
+    attr.exclude_hv = 1;
+    // Counting kernel time needs perf_event_paranoid < 2; fall back to user
+    // space only.
+    for (const bool excludeKernel: {false, true})
+    {
+        attr.exclude_kernel = excludeKernel;
+        const long fd = syscall(SYS_perf_event_open, &attr, 0, -1, aGroup,
+                                PERF_FLAG_FD_CLOEXEC);
+        if (fd >= 0)
+        {
+            return static_cast<int>(fd);
+        }
+    }
+    return -1;
+}
+#endif
+}  // namespace details
+
+// The counters of the thread that constructs the group, read as one group
+// with a single syscall. Hardware counters that can not be opened (no PMU,
+// containers, VMs) are left out; software counters come from perf software
+// events or, when perf_event_open() is not permitted at all, from
+// getrusage() and the thread CPU clock. When the kernel multiplexes the group
+// with other events, its counts are scaled up to the time it was enabled.
+class perf_counter_group
+{
+   public:
+    perf_counter_group() noexcept
+    {
+#if defined(__linux__)
+        for (std::size_t i = 0; i < kPerfCounterCount; ++i)
+        {
+            const int fd = details::open_perf_event(details::kPerfEvents[i],
+                                                    leader_fd());
+            if (fd < 0)
+            {
+                continue;
+            }
+            fds_[count_] = fd;
+            order_[count_] = static_cast<std::uint8_t>(i);
+            ++count_;
+            perf_ |= 1u << i;
+        }
+        if (count_)
+        {
+            ioctl(fds_[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            ioctl(fds_[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        }
+        rusage_ = details::kSoftwarePerfCounters & ~perf_;
+#endif
+    }
+
+    perf_counter_group(const perf_counter_group &) = delete;
+    perf_counter_group &operator=(const perf_counter_group &) = delete;
+
+    ~perf_counter_group()
+    {
+#if defined(__linux__)
+        for (std::size_t i = count_; i > 0; --i)
+        {
+            close(fds_[i - 1]);
+        }
+#endif
+    }
+
+    perf_source source() const noexcept
+    {
+        if (perf_ & ~details::kSoftwarePerfCounters)
+        {
+            return perf_source::kHardware;
+        }
+        if (perf_)
+        {
+            return perf_source::kSoftware;
+        }
+        return rusage_ ? perf_source::kRusage : perf_source::kNone;
+    }
+
+    bool available(perf_counter aCounter) const noexcept
+    {
+        return (perf_ | rusage_) & (1u << static_cast<unsigned>(aCounter));
+    }
+
+    // Current totals. The getrusage() fallback measures the calling thread,
+    // so read from the thread that constructed the group.
+    perf_sample read() const noexcept
+    {
+        perf_sample sample;
+#if defined(__linux__)
+        if (count_)
+        {
+            // nr, time_enabled, time_running, then one value per counter.
+            std::uint64_t buffer[3 + kPerfCounterCount];
+            const auto size =
+                static_cast<ssize_t>((3 + count_) * sizeof(std::uint64_t));
+            const std::uint64_t &enabled = buffer[1];
+            const std::uint64_t &running = buffer[2];
+            // A group that was never scheduled on the PMU counted nothing.
+            if ((::read(fds_[0], buffer, sizeof(buffer)) == size) &&
+                (buffer[0] == count_) && running)
+            {
+                const double scale = running < enabled
+                                         ? static_cast<double>(enabled) /
+                                               static_cast<double>(running)
+                                         : 1.0;
+                for (std::size_t i = 0; i < count_; ++i)
+                {
+                    sample.values[order_[i]] =
+                        scale == 1.0
+                            ? buffer[3 + i]
+                            : static_cast<std::uint64_t>(
+                                  static_cast<double>(buffer[3 + i]) * scale);
+                }
+                sample.available |= perf_;
+            }
+        }
+        if (rusage_)
+        {
+            read_rusage(sample);
+        }
+#endif
+        return sample;
+    }
+
+   private:
+#if defined(__linux__)
+    int leader_fd() const noexcept { return count_ ? fds_[0] : -1; }
+
+    void read_rusage(perf_sample &aSample) const noexcept
+    {
+        auto set = [&](perf_counter aCounter, std::uint64_t aValue) noexcept
+        {
+            const unsigned bit = 1u << static_cast<unsigned>(aCounter);
+            if (rusage_ & bit)
+            {
+                aSample.values[static_cast<std::size_t>(aCounter)] = aValue;
+                aSample.available |= bit;
+            }
+        };
+        rusage usage{};
+        if (getrusage(RUSAGE_THREAD, &usage) == 0)
+        {
+            set(perf_counter::kPageFaults,
+                static_cast<std::uint64_t>(usage.ru_minflt + usage.ru_majflt));
+            set(perf_counter::kContextSwitches,
+                static_cast<std::uint64_t>(usage.ru_nvcsw + usage.ru_nivcsw));
+        }
+        timespec ts{};
+        if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0)
+        {
+            set(perf_counter::kTaskClock,
+                static_cast<std::uint64_t>(ts.tv_sec) * 1'000'000'000u +
+                    static_cast<std::uint64_t>(ts.tv_nsec));
+        }
+    }
+
+    std::array<int, kPerfCounterCount> fds_{};
+    std::array<std::uint8_t, kPerfCounterCount> order_{};
+    std::size_t count_{};
+#endif
+    std::uint32_t perf_{};
+    std::uint32_t rusage_{};
+};
+
+namespace details
+{
+// Like details::timer, but also samples a perf_counter_group when it starts
+// and when it finishes. The finish callback receives the timer and can read
+// both the elapsed time and counters(), the counter deltas.
+template <std::size_t MaxCallbackAlignment, std::size_t MaxCallbackSize,
+          typename Clock>
+class perf_timer
+{
+    using callback_t = void (*)(std::byte *, const perf_timer &) noexcept;
+
+    template <typename Callable>
+    static void call_finish_callback(std::byte *aData,
+                                     const perf_timer &aTimer) noexcept
+    {
+        (*reinterpret_cast<Callable *>(aData))(aTimer);
+    }
+
+   public:
+    using clock = Clock;
+    using time_point = typename clock::time_point;
+    using duration = typename clock::duration;
+
+    template <typename FinishCallback,
+              typename Stored = std::decay_t<FinishCallback>,
+              typename = std::enable_if_t<
+                  std::is_invocable_r_v<void, Stored &, const perf_timer &>>>
+    perf_timer(const perf_counter_group &aGroup,
+               FinishCallback &&aCallback) noexcept
+        : group_(aGroup)
+        , callback_(&call_finish_callback<Stored>)
+        , start_counters_(aGroup.read())
+    {
+        static_assert(alignof(Stored) <= MaxCallbackAlignment);
+        static_assert(sizeof(Stored) <= MaxCallbackSize);
+        static_assert(std::is_trivially_destructible_v<Stored>);
+        new (data_) Stored(std::forward<FinishCallback>(aCallback));
+        start_ = clock::now();
+    }
+
+    perf_timer(const perf_timer &) = delete;
+    perf_timer &operator=(const perf_timer &) = delete;
+
+    ~perf_timer()
+    {
+        delta_ = group_.read() - start_counters_;
+        callback_(data_, *this);
+    }
+
+    duration leaked() const noexcept { return clock::now() - start_; }
+
+    time_point start_tp() const noexcept { return start_; }
+
+    const perf_sample &start_counters() const noexcept
+    {
+        return start_counters_;
+    }
+
+    // Counter deltas between start and finish; valid in the finish callback.
+    const perf_sample &counters() const noexcept { return delta_; }
+
+    // Counters accumulated so far.
+    perf_sample counters_so_far() const noexcept
+    {
+        return group_.read() - start_counters_;
+    }
+
+   private:
+    const perf_counter_group &group_;
+    callback_t callback_;
+    perf_sample start_counters_;
+    perf_sample delta_;
+    time_point start_;
+    alignas(MaxCallbackAlignment) std::byte data_[MaxCallbackSize]{};
+};
+}  // namespace details
+
+using perf_timer =
+    details::perf_timer<alignof(void (*)(int &)), sizeof(void (*)(int &)),
+                        std::chrono::steady_clock>;
+}  // namespace utils
+
+#endif /* utils_perf_counters_h */
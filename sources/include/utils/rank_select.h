@@ -0,0 +1,561 @@
+#ifndef utils_rank_select_h
+#define utils_rank_select_h
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include "bitmap.h"
+#include "common.h"
+#include "ctz.h"
+#include "memory/allocator.h"
+
+namespace utils
+{
+// Static bitvector answering rank1 in constant time and select1 with a
+// sampled binary search over at most a few superblocks. Each superblock of
+// 1024 bits is stored as one header word followed by its 16 data words:
+// the header holds the number of ones before the superblock (34 bits) and
+// the cumulative counts of its first three 256-bit blocks (10 bits each),
+// so the index costs 6.25% on top of the bits and rank touches a single
+// 136-byte run of memory. Every kSelectSample-th one records its superblock
+// to bound the select search.
+class rank_select_bitvector
+{
+   public:
+    using size_type = std::size_t;
+    using allocator_type = memory::allocator<std::uint64_t>;
+
+    class builder;
+
+    static constexpr size_type kSuperblockBits = 1024;
+    static constexpr size_type kBlockBits = 256;
+    static constexpr size_type kSelectSample = 8192;
+    static constexpr size_type kMaxSize = size_type{1} << 34;
+
+    rank_select_bitvector() noexcept = default;
+
+    rank_select_bitvector(const rank_select_bitvector &) = delete;
+    rank_select_bitvector &operator=(const rank_select_bitvector &) = delete;
+
+    rank_select_bitvector(rank_select_bitvector &&aOther) noexcept
+        : alloc_(aOther.alloc_)
+        , units_(std::exchange(aOther.units_, nullptr))
+        , samples_(std::exchange(aOther.samples_, nullptr))
+        , size_(std::exchange(aOther.size_, 0))
+        , ones_(std::exchange(aOther.ones_, 0))
+        , sample_count_(std::exchange(aOther.sample_count_, 0))
+    {
+    }
+
+    rank_select_bitvector &operator=(rank_select_bitvector &&aOther) noexcept
+    {
+        if (this == &aOther)
+        {
+            return *this;
+        }
+
+        release_storage();
+        if (alloc_ == aOther.alloc_)
+        {
+            units_ = std::exchange(aOther.units_, nullptr);
+            samples_ = std::exchange(aOther.samples_, nullptr);
+        }
+        else
+        {
+            // the storage has to come from this allocator
+            const size_type units = aOther.superblock_count() * kUnitWords;
+            units_ = alloc_.allocate(units);
+            samples_ = alloc_.template allocate_object<std::uint32_t>(
+                aOther.sample_count_);
+            UTILS_ABORT_IF_REASON(
+                (units && !units_) || (aOther.sample_count_ && !samples_),
+                "failed to allocate %zu bitvector words", units);
+            copy_words(units_, aOther.units_, units);
+            copy_samples(samples_, aOther.samples_, aOther.sample_count_);
+            aOther.release_storage();
+        }
+        size_ = std::exchange(aOther.size_, 0);
+        ones_ = std::exchange(aOther.ones_, 0);
+        sample_count_ = std::exchange(aOther.sample_count_, 0);
+        return *this;
+    }
+
+    ~rank_select_bitvector() { release_storage(); }
+
+    size_type size() const noexcept { return size_; }
+    bool empty() const noexcept { return !size_; }
+    size_type count() const noexcept { return ones_; }
+
+    bool test(size_type aIndex) const noexcept
+    {
+        assert(aIndex < size_);
+        return bitmap::test(data(aIndex / kSuperblockBits),
+                            aIndex % kSuperblockBits);
+    }
+
+    bool operator[](size_type aIndex) const noexcept { return test(aIndex); }
+
+    // Number of ones in [0, aIndex).
+    size_type rank1(size_type aIndex) const noexcept
+    {
+        assert(aIndex <= size_);
+        if (aIndex == size_)
+        {
+            return ones_;
+        }
+        const size_type superblock = aIndex / kSuperblockBits;
+        const size_type offset = aIndex % kSuperblockBits;
+        const std::uint64_t header = units_[superblock * kUnitWords];
+        const std::uint64_t *words = data(superblock);
+        const size_type word = offset / bitmap::kWordBits;
+        size_type result = absolute_rank(header) +
+                           relative_rank(header, offset / kBlockBits);
+        for (size_type i = offset / kBlockBits * kBlockWords; i < word; ++i)
+        {
+            result += bitmap::details::popcount(words[i]);
+        }
+        const std::uint64_t below =
+            (std::uint64_t{1} << (offset % bitmap::kWordBits)) - 1;
+        return result + bitmap::details::popcount(words[word] & below);
+    }
+
+    // Number of zeros in [0, aIndex).
+    size_type rank0(size_type aIndex) const noexcept
+    {
+        return aIndex - rank1(aIndex);
+    }
+
+    // Position of the one of rank aRank (counting from 0), size() if there
+    // are not that many ones.
+    size_type select1(size_type aRank) const noexcept
+    {
+        if (aRank >= ones_)
+        {
+            return size_;
+        }
+        const size_type sample = aRank / kSelectSample;
+        size_type low = samples_[sample];
+        size_type high = (sample + 1 < sample_count_)
+                             ? samples_[sample + 1] + size_type{1}
+                             : superblock_count();
+        // last superblock in [low, high) that starts at or below aRank
+        while (high - low > kLinearSearch)
+        {
+            const size_type middle = low + (high - low) / 2;
+            if (absolute_rank(units_[middle * kUnitWords]) <= aRank)
+            {
+                low = middle;
+            }
+            else
+            {
+                high = middle;
+            }
+        }
+        while ((low + 1 < high) &&
+               (absolute_rank(units_[(low + 1) * kUnitWords]) <= aRank))
+        {
+            ++low;
+        }
+
+        const std::uint64_t header = units_[low * kUnitWords];
+        size_type remaining = aRank - absolute_rank(header);
+        size_type block = 0;
+        while ((block + 1 < kBlocksPerSuperblock) &&
+               (relative_rank(header, block + 1) <= remaining))
+        {
+            ++block;
+        }
+        remaining -= relative_rank(header, block);
+
+        const std::uint64_t *words = data(low);
+        for (size_type i = block * kBlockWords;; ++i)
+        {
+            const size_type ones = bitmap::details::popcount(words[i]);
+            if (remaining < ones)
+            {
+                return low * kSuperblockBits + i * bitmap::kWordBits +
+                       select_in_word(words[i], remaining);
+            }
+            remaining -= ones;
+        }
+    }
+
+    // Bytes used by the bits and the index.
+    size_type memory_usage() const noexcept
+    {
+        return superblock_count() * kUnitWords * sizeof(std::uint64_t) +
+               sample_count_ * sizeof(std::uint32_t);
+    }
+
+    allocator_type get_allocator() const noexcept { return alloc_; }
+
+   private:
+    static constexpr size_type kSuperblockWords =
+        kSuperblockBits / bitmap::kWordBits;
+    static constexpr size_type kUnitWords = kSuperblockWords + 1;
+    static constexpr size_type kBlockWords = kBlockBits / bitmap::kWordBits;
+    static constexpr size_type kBlocksPerSuperblock =
+        kSuperblockBits / kBlockBits;
+    static constexpr size_type kRelativeBits = 10;
+    static constexpr size_type kAbsoluteShift =
+        kRelativeBits * (kBlocksPerSuperblock - 1);
+    static constexpr size_type kLinearSearch = 8;
+
+    static_assert(kSuperblockBits % bitmap::kWordBits == 0);
+    static_assert((size_type{1} << kRelativeBits) > kSuperblockBits -
+                                                        kBlockBits);
+
+    static size_type absolute_rank(std::uint64_t aHeader) noexcept
+    {
+        return static_cast<size_type>(aHeader >> kAbsoluteShift);
+    }
+
+    static size_type relative_rank(std::uint64_t aHeader,
+                                   size_type aBlock) noexcept
+    {
+        if (!aBlock)
+        {
+            return 0;
+        }
+        constexpr std::uint64_t kMask = (std::uint64_t{1} << kRelativeBits) - 1;
+        return static_cast<size_type>(
+            (aHeader >> ((aBlock - 1) * kRelativeBits)) & kMask);
+    }
+
+    // Position of the one of rank aRank within aWord.
+    static size_type select_in_word(std::uint64_t aWord,
+                                    size_type aRank) noexcept
+    {
+        size_type shift = 0;
+        for (;; shift += CHAR_BIT)
+        {
+            const size_type ones = kNumBitsTable[(aWord >> shift) & 0xFF];
+            if (aRank < ones)
+            {
+                break;
+            }
+            aRank -= ones;
+        }
+        std::uint64_t byte = (aWord >> shift) & 0xFF;
+        for (; aRank; --aRank)
+        {
+            byte &= byte - 1;
+        }
+        return shift + static_cast<size_type>(ctz(byte));
+    }
+
+    rank_select_bitvector(const allocator_type &aAllocator,
+                          std::uint64_t *aUnits, std::uint32_t *aSamples,
+                          size_type aSize, size_type aOnes,
+                          size_type aSampleCount) noexcept
+        : alloc_(aAllocator)
+        , units_(aUnits)
+        , samples_(aSamples)
+        , size_(aSize)
+        , ones_(aOnes)
+        , sample_count_(aSampleCount)
+    {
+    }
+
+    static void copy_words(std::uint64_t *aTo, const std::uint64_t *aFrom,
+                           size_type aCount) noexcept
+    {
+        if (aCount)
+        {
+            memory::memcpy(static_cast<void *>(aTo),
+                           static_cast<const void *>(aFrom),
+                           aCount * sizeof(std::uint64_t));
+        }
+    }
+
+    static void copy_samples(std::uint32_t *aTo, const std::uint32_t *aFrom,
+                             size_type aCount) noexcept
+    {
+        if (aCount)
+        {
+            memory::memcpy(static_cast<void *>(aTo),
+                           static_cast<const void *>(aFrom),
+                           aCount * sizeof(std::uint32_t));
+        }
+    }
+
+    static size_type superblocks_for(size_type aBits) noexcept
+    {
+        return (aBits + kSuperblockBits - 1) / kSuperblockBits;
+    }
+
+    size_type superblock_count() const noexcept
+    {
+        return superblocks_for(size_);
+    }
+
+    const std::uint64_t *data(size_type aSuperblock) const noexcept
+    {
+        return units_ + aSuperblock * kUnitWords + 1;
+    }
+
+    void release_storage() noexcept
+    {
+        alloc_.deallocate(units_);
+        alloc_.deallocate_object(samples_);
+        units_ = nullptr;
+        samples_ = nullptr;
+    }
+
+    allocator_type alloc_{};
+    std::uint64_t *units_{};
+    std::uint32_t *samples_{};
+    size_type size_{};
+    size_type ones_{};
+    size_type sample_count_{};
+};
+
+// Appends bits one word at a time and lays out the index as it goes, so the
+// input never needs to be held in memory separately. Appends return false
+// when the storage cannot grow; the bits appended so far are kept.
+class rank_select_bitvector::builder
+{
+   public:
+    builder() noexcept = default;
+
+    explicit builder(memory::memory_resource *aResource) noexcept
+        : alloc_(aResource)
+    {
+    }
+
+    explicit builder(const allocator_type &aAllocator) noexcept
+        : alloc_(aAllocator)
+    {
+    }
+
+    builder(const builder &) = delete;
+    builder &operator=(const builder &) = delete;
+
+    ~builder() { release_storage(); }
+
+    size_type size() const noexcept { return size_; }
+
+    // Reserves storage for aBits bits in total.
+    bool reserve(size_type aBits) noexcept
+    {
+        return (aBits <= kMaxSize) &&
+               reserve_units(superblocks_for(aBits) * kUnitWords) &&
+               reserve_samples(aBits / kSelectSample + 1);
+    }
+
+    bool push_back(bool aBit) noexcept
+    {
+        return append(static_cast<std::uint64_t>(aBit), 1);
+    }
+
+    // Appends the low aCount bits of aBits, least significant first.
+    bool append(std::uint64_t aBits,
+                size_type aCount = bitmap::kWordBits) noexcept
+    {
+        assert(aCount <= bitmap::kWordBits);
+        if (!aCount)
+        {
+            return true;
+        }
+        if ((size_ + aCount > kMaxSize) || !ensure(size_ + aCount))
+        {
+            return false;
+        }
+        if (aCount < bitmap::kWordBits)
+        {
+            aBits &= (std::uint64_t{1} << aCount) - 1;
+        }
+
+        if (const size_type offset = size_ % bitmap::kWordBits)
+        {
+            // top up the last word, which never crosses a superblock
+            const size_type taken =
+                std::min(bitmap::kWordBits - offset, aCount);
+            const std::uint64_t low =
+                aBits & ((std::uint64_t{1} << taken) - 1);
+            *word_at(size_) |= low << offset;
+            add(low, taken);
+            aCount -= taken;
+            if (!aCount)
+            {
+                return true;
+            }
+            aBits >>= taken;
+        }
+
+        if (size_ % kSuperblockBits == 0)
+        {
+            open_superblock();
+        }
+        *word_at(size_) = aBits;
+        add(aBits, aCount);
+        return true;
+    }
+
+    // Finishes the index and hands the bitvector over, leaving the builder
+    // empty. Storage is trimmed to the final size when possible.
+    [[nodiscard]] rank_select_bitvector build() noexcept
+    {
+        if (size_ % kSuperblockBits)
+        {
+            close_superblock(size_ / kSuperblockBits);
+        }
+        // select1 reads the first sample even when there are no ones
+        if (!sample_count_ && reserve_samples(1))
+        {
+            samples_[sample_count_++] = 0;
+        }
+        UTILS_ABORT_IF_REASON(!sample_count_,
+                              "failed to allocate the select samples");
+        shrink_to_fit();
+        rank_select_bitvector result(alloc_, std::exchange(units_, nullptr),
+                                     std::exchange(samples_, nullptr),
+                                     std::exchange(size_, 0),
+                                     std::exchange(ones_, 0),
+                                     std::exchange(sample_count_, 0));
+        unit_capacity_ = 0;
+        sample_capacity_ = 0;
+        return result;
+    }
+
+   private:
+    std::uint64_t *word_at(size_type aIndex) noexcept
+    {
+        return units_ + aIndex / kSuperblockBits * kUnitWords + 1 +
+               aIndex % kSuperblockBits / bitmap::kWordBits;
+    }
+
+    // Makes room for aBits bits and one more select sample.
+    bool ensure(size_type aBits) noexcept
+    {
+        const size_type units = superblocks_for(aBits) * kUnitWords;
+        if ((units > unit_capacity_) &&
+            !reserve_units(std::max(units, unit_capacity_ * 2)))
+        {
+            return false;
+        }
+        return (sample_count_ < sample_capacity_) ||
+               reserve_samples(std::max<size_type>(sample_capacity_ * 2, 4));
+    }
+
+    bool reserve_units(size_type aWords) noexcept
+    {
+        if (aWords <= unit_capacity_)
+        {
+            return true;
+        }
+        std::uint64_t *units = alloc_.allocate(aWords);
+        if (!units)
+        {
+            return false;
+        }
+        copy_words(units, units_, superblocks_for(size_) * kUnitWords);
+        alloc_.deallocate(units_);
+        units_ = units;
+        unit_capacity_ = aWords;
+        return true;
+    }
+
+    bool reserve_samples(size_type aCount) noexcept
+    {
+        if (aCount <= sample_capacity_)
+        {
+            return true;
+        }
+        auto *samples = alloc_.template allocate_object<std::uint32_t>(aCount);
+        if (!samples)
+        {
+            return false;
+        }
+        copy_samples(samples, samples_, sample_count_);
+        alloc_.deallocate_object(samples_);
+        samples_ = samples;
+        sample_capacity_ = aCount;
+        return true;
+    }
+
+    // Growth doubles the capacity, which a static structure does not need
+    // to keep; the copies are skipped if the smaller blocks are unavailable.
+    void shrink_to_fit() noexcept
+    {
+        const size_type units = superblocks_for(size_) * kUnitWords;
+        if (units && (units < unit_capacity_))
+        {
+            if (std::uint64_t *fitted = alloc_.allocate(units))
+            {
+                copy_words(fitted, units_, units);
+                alloc_.deallocate(units_);
+                units_ = fitted;
+            }
+        }
+        if (sample_count_ < sample_capacity_)
+        {
+            if (auto *fitted = alloc_.template allocate_object<std::uint32_t>(
+                    sample_count_))
+            {
+                copy_samples(fitted, samples_, sample_count_);
+                alloc_.deallocate_object(samples_);
+                samples_ = fitted;
+            }
+        }
+    }
+
+    void open_superblock() noexcept
+    {
+        std::uint64_t *unit = units_ + size_ / kSuperblockBits * kUnitWords;
+        unit[0] = static_cast<std::uint64_t>(ones_) << kAbsoluteShift;
+        std::fill(unit + 1, unit + kUnitWords, std::uint64_t{});
+    }
+
+    void close_superblock(size_type aSuperblock) noexcept
+    {
+        std::uint64_t *unit = units_ + aSuperblock * kUnitWords;
+        size_type ones = 0;
+        for (size_type block = 1; block < kBlocksPerSuperblock; ++block)
+        {
+            ones += bitmap::details::popcount_words()(
+                unit + 1 + (block - 1) * kBlockWords, kBlockWords);
+            unit[0] |= static_cast<std::uint64_t>(ones)
+                       << ((block - 1) * kRelativeBits);
+        }
+    }
+
+    void add(std::uint64_t aBits, size_type aCount) noexcept
+    {
+        const size_type ones = bitmap::details::popcount(aBits);
+        // a sample is at least a word apart from the previous one
+        const size_type next =
+            (ones_ + kSelectSample - 1) / kSelectSample * kSelectSample;
+        if (next < ones_ + ones)
+        {
+            samples_[sample_count_++] =
+                static_cast<std::uint32_t>(size_ / kSuperblockBits);
+        }
+        ones_ += ones;
+        size_ += aCount;
+        if (size_ % kSuperblockBits == 0)
+        {
+            close_superblock(size_ / kSuperblockBits - 1);
+        }
+    }
+
+    void release_storage() noexcept
+    {
+        alloc_.deallocate(units_);
+        alloc_.deallocate_object(samples_);
+    }
+
+    allocator_type alloc_{};
+    std::uint64_t *units_{};
+    std::uint32_t *samples_{};
+    size_type size_{};
+    size_type ones_{};
+    size_type sample_count_{};
+    size_type unit_capacity_{};
+    size_type sample_capacity_{};
+};
+}  // namespace utils
+
+#endif /* utils_rank_select_h */
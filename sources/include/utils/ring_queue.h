@@ -0,0 +1,410 @@
+#ifndef utils_ring_queue_h
+#define utils_ring_queue_h
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "common.h"
+#include "memory/allocator.h"
+#include "padding_checker.h"
+
+namespace utils
+{
+namespace details
+{
+inline std::size_t ring_capacity(std::size_t aRequested) noexcept
+{
+    std::size_t capacity = 1;
+    while (capacity < aRequested)
+    {
+        capacity <<= 1;
+    }
+    return capacity;
+}
+}  // namespace details
+
+// Bounded wait-free queue for exactly one producer thread and one consumer
+// thread. Capacity is rounded up to a power of two.
+template <typename T>
+class spsc_queue
+{
+    static_assert(std::is_nothrow_move_constructible_v<T>);
+    static_assert(std::is_nothrow_destructible_v<T>);
+
+   public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using allocator_type = memory::allocator<T>;
+
+    static_assert(std::atomic<size_type>::is_always_lock_free);
+
+    explicit spsc_queue(size_type aCapacity,
+                        const allocator_type &aAllocator = {}) noexcept
+        : alloc_(aAllocator)
+        , mask_(details::ring_capacity(std::max(aCapacity, size_type{1})) - 1)
+    {
+        slots_ = static_cast<T *>(alloc_.allocate_bytes(
+            capacity() * sizeof(T), std::max(alignof(T), kCacheLineSize)));
+        UTILS_ABORT_IF_REASON(!slots_, "failed to allocate %zu queue slots",
+                              capacity());
+    }
+
+    spsc_queue(const spsc_queue &) = delete;
+    spsc_queue &operator=(const spsc_queue &) = delete;
+
+    ~spsc_queue()
+    {
+        const size_type tail = producer_.tail.load(std::memory_order_relaxed);
+        for (size_type i = consumer_.head.load(std::memory_order_relaxed);
+             i != tail; ++i)
+        {
+            slot(i)->~T();
+        }
+        alloc_.deallocate_bytes(slots_);
+    }
+
+    template <typename... Args>
+    bool try_emplace(Args &&...aArgs) noexcept
+    {
+        static_assert(std::is_nothrow_constructible_v<T, Args...>);
+        const size_type tail = producer_.tail.load(std::memory_order_relaxed);
+        if (!writable(tail, 1))
+        {
+            return false;
+        }
+        new (slot(tail)) T(std::forward<Args>(aArgs)...);
+        producer_.tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool try_push(const T &aValue) noexcept { return try_emplace(aValue); }
+    bool try_push(T &&aValue) noexcept
+    {
+        return try_emplace(std::move(aValue));
+    }
+
+    // Pushes up to aCount elements with a single release store and returns
+    // how many were pushed.
+    template <typename InputIt>
+    size_type try_push_bulk(InputIt aFirst, size_type aCount) noexcept
+    {
+        static_assert(std::is_nothrow_constructible_v<T, decltype(*aFirst)>);
+        const size_type tail = producer_.tail.load(std::memory_order_relaxed);
+        const size_type count = writable(tail, aCount);
+        for (size_type i = 0; i < count; ++i, ++aFirst)
+        {
+            new (slot(tail + i)) T(*aFirst);
+        }
+        if (count)
+        {
+            producer_.tail.store(tail + count, std::memory_order_release);
+        }
+        return count;
+    }
+
+    bool try_pop(T &aOut) noexcept { return try_pop_bulk(&aOut, 1) == 1; }
+
+    template <typename OutputIt>
+    size_type try_pop_bulk(OutputIt aOut, size_type aMaxCount) noexcept
+    {
+        const size_type head = consumer_.head.load(std::memory_order_relaxed);
+        const size_type count = readable(head, aMaxCount);
+        for (size_type i = 0; i < count; ++i, ++aOut)
+        {
+            T *ptr = slot(head + i);
+            *aOut = std::move(*ptr);
+            ptr->~T();
+        }
+        if (count)
+        {
+            consumer_.head.store(head + count, std::memory_order_release);
+        }
+        return count;
+    }
+
+    size_type size() const noexcept
+    {
+        const size_type head = consumer_.head.load(std::memory_order_acquire);
+        return producer_.tail.load(std::memory_order_acquire) - head;
+    }
+
+    bool empty() const noexcept { return !size(); }
+    size_type capacity() const noexcept { return mask_ + 1; }
+
+   private:
+    struct alignas(kCacheLineSize) producer_state
+    {
+        std::atomic<size_type> tail{};
+        size_type head_cache{};
+    };
+
+    struct alignas(kCacheLineSize) consumer_state
+    {
+        std::atomic<size_type> head{};
+        size_type tail_cache{};
+    };
+
+    static_assert(is_cache_line_isolated_v<producer_state>);
+    static_assert(is_cache_line_isolated_v<consumer_state>);
+
+    T *slot(size_type aIndex) const noexcept
+    {
+        return slots_ + (aIndex & mask_);
+    }
+
+    size_type writable(size_type aTail, size_type aWanted) noexcept
+    {
+        size_type count = capacity() - (aTail - producer_.head_cache);
+        if (count < aWanted)
+        {
+            producer_.head_cache =
+                consumer_.head.load(std::memory_order_acquire);
+            count = capacity() - (aTail - producer_.head_cache);
+        }
+        return std::min(count, aWanted);
+    }
+
+    size_type readable(size_type aHead, size_type aWanted) noexcept
+    {
+        size_type count = consumer_.tail_cache - aHead;
+        if (count < aWanted)
+        {
+            consumer_.tail_cache =
+                producer_.tail.load(std::memory_order_acquire);
+            count = consumer_.tail_cache - aHead;
+        }
+        return std::min(count, aWanted);
+    }
+
+    allocator_type alloc_;
+    T *slots_{};
+    size_type mask_{};
+    producer_state producer_;
+    consumer_state consumer_;
+};
+
+// Bounded lock-free queue for any number of producers and consumers, based on
+// per-slot sequence numbers. Capacity is rounded up to a power of two and is
+// at least 2: with a single slot, "free for the next lap" and "filled in this
+// lap" would be the same sequence number.
+template <typename T>
+class mpmc_queue
+{
+    static_assert(std::is_nothrow_move_constructible_v<T>);
+    static_assert(std::is_nothrow_destructible_v<T>);
+
+   public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using allocator_type = memory::allocator<T>;
+
+    static_assert(std::atomic<size_type>::is_always_lock_free);
+
+    explicit mpmc_queue(size_type aCapacity,
+                        const allocator_type &aAllocator = {}) noexcept
+        : alloc_(aAllocator)
+        , mask_(details::ring_capacity(std::max(aCapacity, size_type{2})) - 1)
+    {
+        slots_ = static_cast<slot *>(
+            alloc_.allocate_bytes(capacity() * sizeof(slot),
+                                  std::max(alignof(slot), kCacheLineSize)));
+        UTILS_ABORT_IF_REASON(!slots_, "failed to allocate %zu queue slots",
+                              capacity());
+        for (size_type i = 0; i < capacity(); ++i)
+        {
+            new (slots_ + i) slot(i);
+        }
+    }
+
+    mpmc_queue(const mpmc_queue &) = delete;
+    mpmc_queue &operator=(const mpmc_queue &) = delete;
+
+    ~mpmc_queue()
+    {
+        const size_type tail = tail_.value.load(std::memory_order_relaxed);
+        for (size_type i = head_.value.load(std::memory_order_relaxed);
+             i != tail; ++i)
+        {
+            at(i).ptr()->~T();
+        }
+        alloc_.deallocate_bytes(slots_);
+    }
+
+    template <typename... Args>
+    bool try_emplace(Args &&...aArgs) noexcept
+    {
+        static_assert(std::is_nothrow_constructible_v<T, Args...>);
+        size_type pos = tail_.value.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            slot &s = at(pos);
+            const auto diff = distance(
+                s.sequence.load(std::memory_order_acquire), pos);
+            if (!diff)
+            {
+                if (tail_.value.compare_exchange_weak(
+                        pos, pos + 1, std::memory_order_relaxed))
+                {
+                    new (s.ptr()) T(std::forward<Args>(aArgs)...);
+                    s.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = tail_.value.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool try_push(const T &aValue) noexcept { return try_emplace(aValue); }
+    bool try_push(T &&aValue) noexcept
+    {
+        return try_emplace(std::move(aValue));
+    }
+
+    // Claims up to aCount consecutive free slots with a single CAS and returns
+    // how many elements were pushed.
+    template <typename InputIt>
+    size_type try_push_bulk(InputIt aFirst, size_type aCount) noexcept
+    {
+        static_assert(std::is_nothrow_constructible_v<T, decltype(*aFirst)>);
+        size_type pos = tail_.value.load(std::memory_order_relaxed);
+        size_type count = 0;
+        while (aCount)
+        {
+            count = ready_count(pos, aCount, 0);
+            if (count)
+            {
+                if (tail_.value.compare_exchange_weak(
+                        pos, pos + count, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (distance(at(pos).sequence.load(std::memory_order_acquire),
+                              pos) < 0)
+            {
+                break;
+            }
+            else
+            {
+                pos = tail_.value.load(std::memory_order_relaxed);
+            }
+        }
+
+        for (size_type i = 0; i < count; ++i, ++aFirst)
+        {
+            slot &s = at(pos + i);
+            new (s.ptr()) T(*aFirst);
+            s.sequence.store(pos + i + 1, std::memory_order_release);
+        }
+        return count;
+    }
+
+    bool try_pop(T &aOut) noexcept { return try_pop_bulk(&aOut, 1) == 1; }
+
+    template <typename OutputIt>
+    size_type try_pop_bulk(OutputIt aOut, size_type aMaxCount) noexcept
+    {
+        size_type pos = head_.value.load(std::memory_order_relaxed);
+        size_type count = 0;
+        while (aMaxCount)
+        {
+            count = ready_count(pos, aMaxCount, 1);
+            if (count)
+            {
+                if (head_.value.compare_exchange_weak(
+                        pos, pos + count, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (distance(at(pos).sequence.load(std::memory_order_acquire),
+                              pos + 1) < 0)
+            {
+                break;
+            }
+            else
+            {
+                pos = head_.value.load(std::memory_order_relaxed);
+            }
+        }
+
+        for (size_type i = 0; i < count; ++i, ++aOut)
+        {
+            slot &s = at(pos + i);
+            *aOut = std::move(*s.ptr());
+            s.ptr()->~T();
+            s.sequence.store(pos + i + capacity(), std::memory_order_release);
+        }
+        return count;
+    }
+
+    size_type size() const noexcept
+    {
+        const size_type head = head_.value.load(std::memory_order_acquire);
+        const size_type tail = tail_.value.load(std::memory_order_acquire);
+        const auto diff = distance(tail, head);
+        return diff > 0 ? std::min(static_cast<size_type>(diff), capacity())
+                        : 0;
+    }
+
+    bool empty() const noexcept { return !size(); }
+    size_type capacity() const noexcept { return mask_ + 1; }
+
+   private:
+    struct slot
+    {
+        explicit slot(size_type aSequence) noexcept : sequence(aSequence) {}
+
+        T *ptr() noexcept { return reinterpret_cast<T *>(storage); }
+
+        std::atomic<size_type> sequence;
+        alignas(T) std::byte storage[sizeof(T)];
+    };
+
+    using index = cache_line_padded<std::atomic<size_type>>;
+    static_assert(is_cache_line_isolated_v<index>);
+
+    static difference_type distance(size_type aLhs, size_type aRhs) noexcept
+    {
+        return static_cast<difference_type>(aLhs - aRhs);
+    }
+
+    slot &at(size_type aPos) const noexcept { return slots_[aPos & mask_]; }
+
+    // Number of leading slots starting at aPos whose sequence shows they are
+    // ready: free for producers (aLag == 0) or filled for consumers (1).
+    size_type ready_count(size_type aPos, size_type aMax,
+                          size_type aLag) const noexcept
+    {
+        size_type count = 0;
+        aMax = std::min(aMax, capacity());
+        while ((count < aMax) &&
+               (at(aPos + count).sequence.load(std::memory_order_acquire) ==
+                aPos + count + aLag))
+        {
+            ++count;
+        }
+        return count;
+    }
+
+    allocator_type alloc_;
+    slot *slots_{};
+    size_type mask_{};
+    index tail_{};
+    index head_{};
+};
+}  // namespace utils
+
+#endif /* utils_ring_queue_h */
@@ -0,0 +1,1818 @@
+#ifndef utils_simd_h
+#define utils_simd_h
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+#include "common.h"
+#include "detector.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define UTILS_SIMD_SSE2 1
+#include <emmintrin.h>
+#if defined(__SSE4_1__) || defined(__AVX__)
+#define UTILS_SIMD_SSE41 1
+#include <smmintrin.h>
+#endif
+#if defined(__AVX__)
+#define UTILS_SIMD_AVX 1
+#include <immintrin.h>
+#endif
+#if defined(__AVX2__)
+#define UTILS_SIMD_AVX2 1
+#endif
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define UTILS_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace utils
+{
+template <typename T, std::size_t N>
+class simd;
+
+template <typename T, std::size_t N>
+class simd_mask;
+
+namespace details
+{
+template <std::size_t Size>
+struct simd_mask_lane;
+
+template <>
+struct simd_mask_lane<1>
+{
+    using type = std::uint8_t;
+};
+
+template <>
+struct simd_mask_lane<2>
+{
+    using type = std::uint16_t;
+};
+
+template <>
+struct simd_mask_lane<4>
+{
+    using type = std::uint32_t;
+};
+
+template <>
+struct simd_mask_lane<8>
+{
+    using type = std::uint64_t;
+};
+
+// Mask lanes are unsigned integers of the value lane size, all ones or zero.
+template <typename T>
+using simd_mask_lane_t = typename simd_mask_lane<sizeof(T)>::type;
+
+// Integer lanes wrap around as in the vector instructions, so scalar code
+// computes in an unsigned type that is not promoted to int.
+template <typename T, bool = std::is_integral_v<T>>
+struct simd_wrap
+{
+    using type = T;
+};
+
+template <typename T>
+struct simd_wrap<T, true>
+{
+    using type = std::conditional_t<(sizeof(T) < sizeof(unsigned)), unsigned,
+                                    std::make_unsigned_t<T>>;
+};
+
+template <typename T>
+using simd_wrap_t = typename simd_wrap<T>::type;
+
+// Operation tags. Their call operators are the scalar definition every
+// backend has to match.
+struct simd_plus
+{
+    template <typename T>
+    constexpr T operator()(T aLhs, T aRhs) const noexcept
+    {
+        using wrap_t = simd_wrap_t<T>;
+        return static_cast<T>(static_cast<wrap_t>(aLhs) +
+                              static_cast<wrap_t>(aRhs));
+    }
+};
+
+struct simd_minus
+{
+    template <typename T>
+    constexpr T operator()(T aLhs, T aRhs) const noexcept
+    {
+        using wrap_t = simd_wrap_t<T>;
+        return static_cast<T>(static_cast<wrap_t>(aLhs) -
+                              static_cast<wrap_t>(aRhs));
+    }
+};
+
+struct simd_multiplies
+{
+    template <typename T>
+    constexpr T operator()(T aLhs, T aRhs) const noexcept
+    {
+        using wrap_t = simd_wrap_t<T>;
+        return static_cast<T>(static_cast<wrap_t>(aLhs) *
+                              static_cast<wrap_t>(aRhs));
+    }
+};
+
+struct simd_divides
+{
+    template <typename T>
+    constexpr T operator()(T aLhs, T aRhs) const noexcept
+    {
+        return static_cast<T>(aLhs / aRhs);
+    }
+};
+
+struct simd_bit_and
+{
+    template <typename T>
+    constexpr T operator()(T aLhs, T aRhs) const noexcept
+    {
+        return static_cast<T>(aLhs & aRhs);
+    }
+};
+
+struct simd_bit_or
+{
+    template <typename T>
+    constexpr T operator()(T aLhs, T aRhs) const noexcept
+    {
+        return static_cast<T>(aLhs | aRhs);
+    }
+};
+
+struct simd_bit_xor
+{
+    template <typename T>
+    constexpr T operator()(T aLhs, T aRhs) const noexcept
+    {
+        return static_cast<T>(aLhs ^ aRhs);
+    }
+};
+
+// As minps/maxps: the second operand when the lanes are unordered.
+struct simd_min
+{
+    template <typename T>
+    constexpr T operator()(T aLhs, T aRhs) const noexcept
+    {
+        return (aLhs < aRhs) ? aLhs : aRhs;
+    }
+};
+
+struct simd_max
+{
+    template <typename T>
+    constexpr T operator()(T aLhs, T aRhs) const noexcept
+    {
+        return (aLhs > aRhs) ? aLhs : aRhs;
+    }
+};
+
+struct simd_equal
+{
+    template <typename T>
+    constexpr bool operator()(T aLhs, T aRhs) const noexcept
+    {
+        return aLhs == aRhs;
+    }
+};
+
+struct simd_not_equal
+{
+    template <typename T>
+    constexpr bool operator()(T aLhs, T aRhs) const noexcept
+    {
+        return aLhs != aRhs;
+    }
+};
+
+struct simd_less
+{
+    template <typename T>
+    constexpr bool operator()(T aLhs, T aRhs) const noexcept
+    {
+        return aLhs < aRhs;
+    }
+};
+
+struct simd_less_equal
+{
+    template <typename T>
+    constexpr bool operator()(T aLhs, T aRhs) const noexcept
+    {
+        return aLhs <= aRhs;
+    }
+};
+
+struct simd_greater
+{
+    template <typename T>
+    constexpr bool operator()(T aLhs, T aRhs) const noexcept
+    {
+        return aLhs > aRhs;
+    }
+};
+
+struct simd_greater_equal
+{
+    template <typename T>
+    constexpr bool operator()(T aLhs, T aRhs) const noexcept
+    {
+        return aLhs >= aRhs;
+    }
+};
+
+// Native implementation of N lanes of T, if any. A backend has:
+//   type, mask_type                      registers for values and masks
+//   load(const T *), store(T *, type)    aligned to N * sizeof(T)
+//   load_mask(), store_mask()            the same for mask lanes
+// and any subset of
+//   apply(Op, type, type) -> type
+//   compare(Op, type, type) -> mask_type
+//   select(mask_type, type, type) -> type
+//   bits(mask_type) -> std::uint64_t
+// Operations a backend lacks run lane by lane.
+template <typename T, std::size_t N, typename = void>
+struct simd_backend
+{
+};
+
+// Detected as void: vector register types lose their attributes as
+// template arguments.
+template <typename Backend, typename Op>
+using simd_apply_t = decltype(static_cast<void>(
+    Backend::apply(Op{}, std::declval<typename Backend::type>(),
+                   std::declval<typename Backend::type>())));
+
+template <typename Backend, typename Op>
+using simd_compare_t = decltype(static_cast<void>(
+    Backend::compare(Op{}, std::declval<typename Backend::type>(),
+                     std::declval<typename Backend::type>())));
+
+template <typename Backend>
+using simd_select_t = decltype(static_cast<void>(
+    Backend::select(std::declval<typename Backend::mask_type>(),
+                    std::declval<typename Backend::type>(),
+                    std::declval<typename Backend::type>())));
+
+template <typename Backend>
+using simd_bits_t = decltype(static_cast<void>(
+    Backend::bits(std::declval<typename Backend::mask_type>())));
+
+template <typename Op>
+struct simd_has_apply
+{
+    template <typename Backend>
+    using check = is_detected<simd_apply_t, Backend, Op>;
+};
+
+template <typename Op>
+struct simd_has_compare
+{
+    template <typename Backend>
+    using check = is_detected<simd_compare_t, Backend, Op>;
+};
+
+template <typename Backend>
+using simd_has_select = is_detected<simd_select_t, Backend>;
+
+template <typename Backend>
+using simd_has_bits = is_detected<simd_bits_t, Backend>;
+
+// The widest M <= N whose backend passes Check; wider vectors are processed
+// in chunks of M lanes. 0 if there is none.
+template <typename T, std::size_t N, template <typename> class Check>
+constexpr std::size_t simd_native_width() noexcept
+{
+    if constexpr (Check<simd_backend<T, N>>::value)
+    {
+        return N;
+    }
+    else if constexpr (N > 1)
+    {
+        return simd_native_width<T, N / 2, Check>();
+    }
+    else
+    {
+        return 0;
+    }
+}
+
+#ifdef UTILS_SIMD_SSE2
+// Four instructions of the float and double backends only differ by suffix.
+#define UTILS_SIMD_SSE_FLOAT_BACKEND(T, N, vtype, sfx)                        \
+    template <>                                                               \
+    struct simd_backend<T, N>                                                 \
+    {                                                                         \
+        using type = vtype;                                                   \
+        using mask_type = __m128i;                                            \
+        using lane_type = simd_mask_lane_t<T>;                                \
+                                                                              \
+        static type load(const T *aFrom) noexcept                             \
+        {                                                                     \
+            return _mm_load_p##sfx(aFrom);                                    \
+        }                                                                     \
+        static void store(T *aTo, type aValue) noexcept                       \
+        {                                                                     \
+            _mm_store_p##sfx(aTo, aValue);                                    \
+        }                                                                     \
+        static mask_type load_mask(const lane_type *aFrom) noexcept           \
+        {                                                                     \
+            return _mm_load_si128(reinterpret_cast<const __m128i *>(aFrom));  \
+        }                                                                     \
+        static void store_mask(lane_type *aTo, mask_type aMask) noexcept      \
+        {                                                                     \
+            _mm_store_si128(reinterpret_cast<__m128i *>(aTo), aMask);         \
+        }                                                                     \
+                                                                              \
+        static type apply(simd_plus, type aLhs, type aRhs) noexcept           \
+        {                                                                     \
+            return _mm_add_p##sfx(aLhs, aRhs);                                \
+        }                                                                     \
+        static type apply(simd_minus, type aLhs, type aRhs) noexcept          \
+        {                                                                     \
+            return _mm_sub_p##sfx(aLhs, aRhs);                                \
+        }                                                                     \
+        static type apply(simd_multiplies, type aLhs, type aRhs) noexcept     \
+        {                                                                     \
+            return _mm_mul_p##sfx(aLhs, aRhs);                                \
+        }                                                                     \
+        static type apply(simd_divides, type aLhs, type aRhs) noexcept        \
+        {                                                                     \
+            return _mm_div_p##sfx(aLhs, aRhs);                                \
+        }                                                                     \
+        static type apply(simd_min, type aLhs, type aRhs) noexcept            \
+        {                                                                     \
+            return _mm_min_p##sfx(aLhs, aRhs);                                \
+        }                                                                     \
+        static type apply(simd_max, type aLhs, type aRhs) noexcept            \
+        {                                                                     \
+            return _mm_max_p##sfx(aLhs, aRhs);                                \
+        }                                                                     \
+                                                                              \
+        static mask_type compare(simd_equal, type aLhs, type aRhs) noexcept   \
+        {                                                                     \
+            return _mm_castp##sfx##_si128(_mm_cmpeq_p##sfx(aLhs, aRhs));      \
+        }                                                                     \
+        static mask_type compare(simd_not_equal, type aLhs,                   \
+                                 type aRhs) noexcept                          \
+        {                                                                     \
+            return _mm_castp##sfx##_si128(_mm_cmpneq_p##sfx(aLhs, aRhs));     \
+        }                                                                     \
+        static mask_type compare(simd_less, type aLhs, type aRhs) noexcept    \
+        {                                                                     \
+            return _mm_castp##sfx##_si128(_mm_cmplt_p##sfx(aLhs, aRhs));      \
+        }                                                                     \
+        static mask_type compare(simd_less_equal, type aLhs,                  \
+                                 type aRhs) noexcept                          \
+        {                                                                     \
+            return _mm_castp##sfx##_si128(_mm_cmple_p##sfx(aLhs, aRhs));      \
+        }                                                                     \
+        static mask_type compare(simd_greater, type aLhs, type aRhs) noexcept \
+        {                                                                     \
+            return _mm_castp##sfx##_si128(_mm_cmpgt_p##sfx(aLhs, aRhs));      \
+        }                                                                     \
+        static mask_type compare(simd_greater_equal, type aLhs,               \
+                                 type aRhs) noexcept                          \
+        {                                                                     \
+            return _mm_castp##sfx##_si128(_mm_cmpge_p##sfx(aLhs, aRhs));      \
+        }                                                                     \
+                                                                              \
+        static type select(mask_type aMask, type aTrue, type aFalse) noexcept \
+        {                                                                     \
+            const type mask = _mm_castsi128_p##sfx(aMask);                    \
+            return _mm_or_p##sfx(_mm_and_p##sfx(mask, aTrue),                 \
+                                 _mm_andnot_p##sfx(mask, aFalse));            \
+        }                                                                     \
+        static std::uint64_t bits(mask_type aMask) noexcept                   \
+        {                                                                     \
+            return static_cast<unsigned>(                                     \
+                _mm_movemask_p##sfx(_mm_castsi128_p##sfx(aMask)));            \
+        }                                                                     \
+    };
+
+UTILS_SIMD_SSE_FLOAT_BACKEND(float, 4, __m128, s)
+UTILS_SIMD_SSE_FLOAT_BACKEND(double, 2, __m128d, d)
+#undef UTILS_SIMD_SSE_FLOAT_BACKEND
+
+template <typename T>
+struct simd_sse_integer
+{
+    using type = __m128i;
+    using mask_type = __m128i;
+    using lane_type = simd_mask_lane_t<T>;
+
+    static type load(const T *aFrom) noexcept
+    {
+        return _mm_load_si128(reinterpret_cast<const __m128i *>(aFrom));
+    }
+
+    static void store(T *aTo, type aValue) noexcept
+    {
+        _mm_store_si128(reinterpret_cast<__m128i *>(aTo), aValue);
+    }
+
+    static mask_type load_mask(const lane_type *aFrom) noexcept
+    {
+        return _mm_load_si128(reinterpret_cast<const __m128i *>(aFrom));
+    }
+
+    static void store_mask(lane_type *aTo, mask_type aMask) noexcept
+    {
+        _mm_store_si128(reinterpret_cast<__m128i *>(aTo), aMask);
+    }
+
+    static type apply(simd_plus, type aLhs, type aRhs) noexcept
+    {
+        if constexpr (sizeof(T) == 1)
+        {
+            return _mm_add_epi8(aLhs, aRhs);
+        }
+        else if constexpr (sizeof(T) == 2)
+        {
+            return _mm_add_epi16(aLhs, aRhs);
+        }
+        else if constexpr (sizeof(T) == 4)
+        {
+            return _mm_add_epi32(aLhs, aRhs);
+        }
+        else
+        {
+            return _mm_add_epi64(aLhs, aRhs);
+        }
+    }
+
+    static type apply(simd_minus, type aLhs, type aRhs) noexcept
+    {
+        if constexpr (sizeof(T) == 1)
+        {
+            return _mm_sub_epi8(aLhs, aRhs);
+        }
+        else if constexpr (sizeof(T) == 2)
+        {
+            return _mm_sub_epi16(aLhs, aRhs);
+        }
+        else if constexpr (sizeof(T) == 4)
+        {
+            return _mm_sub_epi32(aLhs, aRhs);
+        }
+        else
+        {
+            return _mm_sub_epi64(aLhs, aRhs);
+        }
+    }
+
+    template <typename U = T, std::enable_if_t<sizeof(U) == 2, int> = 0>
+    static type apply(simd_multiplies, type aLhs, type aRhs) noexcept
+    {
+        return _mm_mullo_epi16(aLhs, aRhs);
+    }
+
+    static type apply(simd_bit_and, type aLhs, type aRhs) noexcept
+    {
+        return _mm_and_si128(aLhs, aRhs);
+    }
+
+    static type apply(simd_bit_or, type aLhs, type aRhs) noexcept
+    {
+        return _mm_or_si128(aLhs, aRhs);
+    }
+
+    static type apply(simd_bit_xor, type aLhs, type aRhs) noexcept
+    {
+        return _mm_xor_si128(aLhs, aRhs);
+    }
+
+    template <typename U = T,
+              std::enable_if_t<(sizeof(U) == 1) && std::is_unsigned_v<U>,
+                               int> = 0>
+    static type apply(simd_min, type aLhs, type aRhs) noexcept
+    {
+        return _mm_min_epu8(aLhs, aRhs);
+    }
+
+    template <typename U = T,
+              std::enable_if_t<(sizeof(U) == 1) && std::is_unsigned_v<U>,
+                               int> = 0>
+    static type apply(simd_max, type aLhs, type aRhs) noexcept
+    {
+        return _mm_max_epu8(aLhs, aRhs);
+    }
+
+    template <typename U = T,
+              std::enable_if_t<(sizeof(U) == 2) && std::is_signed_v<U>,
+                               int> = 0>
+    static type apply(simd_min, type aLhs, type aRhs) noexcept
+    {
+        return _mm_min_epi16(aLhs, aRhs);
+    }
+
+    template <typename U = T,
+              std::enable_if_t<(sizeof(U) == 2) && std::is_signed_v<U>,
+                               int> = 0>
+    static type apply(simd_max, type aLhs, type aRhs) noexcept
+    {
+        return _mm_max_epi16(aLhs, aRhs);
+    }
+
+#ifdef UTILS_SIMD_SSE41
+    template <typename U = T, std::enable_if_t<sizeof(U) == 4, int> = 0>
+    static type apply(simd_multiplies, type aLhs, type aRhs) noexcept
+    {
+        return _mm_mullo_epi32(aLhs, aRhs);
+    }
+
+    template <typename U = T,
+              std::enable_if_t<(sizeof(U) == 1) && std::is_signed_v<U>,
+                               int> = 0>
+    static type apply(simd_min, type aLhs, type aRhs) noexcept
+    {
+        return _mm_min_epi8(aLhs, aRhs);
+    }
+
+    template <typename U = T,
+              std::enable_if_t<(sizeof(U) == 1) && std::is_signed_v<U>,
+                               int> = 0>
+    static type apply(simd_max, type aLhs, type aRhs) noexcept
+    {
+        return _mm_max_epi8(aLhs, aRhs);
+    }
+
+    template <typename U = T,
+              std::enable_if_t<(sizeof(U) == 2) && std::is_unsigned_v<U>,
+                               int> = 0>
+    static type apply(simd_min, type aLhs, type aRhs) noexcept
+    {
+        return _mm_min_epu16(aLhs, aRhs);
+    }
+
+    template <typename U = T,
+              std::enable_if_t<(sizeof(U) == 2) && std::is_unsigned_v<U>,
+                               int> = 0>
+    static type apply(simd_max, type aLhs, type aRhs) noexcept
+    {
+        return _mm_max_epu16(aLhs, aRhs);
+    }
+
+    template <typename U = T, std::enable_if_t<sizeof(U) == 4, int> = 0>
+    static type apply(simd_min, type aLhs, type aRhs) noexcept
+    {
+        if constexpr (std::is_signed_v<T>)
+        {
+            return _mm_min_epi32(aLhs, aRhs);
+        }
+        else
+        {
+            return _mm_min_epu32(aLhs, aRhs);
+        }
+    }
+
+    template <typename U = T, std::enable_if_t<sizeof(U) == 4, int> = 0>
+    static type apply(simd_max, type aLhs, type aRhs) noexcept
+    {
+        if constexpr (std::is_signed_v<T>)
+        {
+            return _mm_max_epi32(aLhs, aRhs);
+        }
+        else
+        {
+            return _mm_max_epu32(aLhs, aRhs);
+        }
+    }
+
+    template <typename U = T, std::enable_if_t<sizeof(U) == 8, int> = 0>
+    static mask_type compare(simd_equal, type aLhs, type aRhs) noexcept
+    {
+        return _mm_cmpeq_epi64(aLhs, aRhs);
+    }
+
+    template <typename U = T, std::enable_if_t<sizeof(U) == 8, int> = 0>
+    static mask_type compare(simd_not_equal, type aLhs, type aRhs) noexcept
+    {
+        return invert(_mm_cmpeq_epi64(aLhs, aRhs));
+    }
+#endif
+
+    template <typename U = T, std::enable_if_t<(sizeof(U) < 8), int> = 0>
+    static mask_type compare(simd_equal, type aLhs, type aRhs) noexcept
+    {
+        return equal(aLhs, aRhs);
+    }
+
+    template <typename U = T, std::enable_if_t<(sizeof(U) < 8), int> = 0>
+    static mask_type compare(simd_not_equal, type aLhs, type aRhs) noexcept
+    {
+        return invert(equal(aLhs, aRhs));
+    }
+
+    template <typename U = T, std::enable_if_t<(sizeof(U) < 8), int> = 0>
+    static mask_type compare(simd_less, type aLhs, type aRhs) noexcept
+    {
+        return greater(aRhs, aLhs);
+    }
+
+    template <typename U = T, std::enable_if_t<(sizeof(U) < 8), int> = 0>
+    static mask_type compare(simd_less_equal, type aLhs, type aRhs) noexcept
+    {
+        return invert(greater(aLhs, aRhs));
+    }
+
+    template <typename U = T, std::enable_if_t<(sizeof(U) < 8), int> = 0>
+    static mask_type compare(simd_greater, type aLhs, type aRhs) noexcept
+    {
+        return greater(aLhs, aRhs);
+    }
+
+    template <typename U = T, std::enable_if_t<(sizeof(U) < 8), int> = 0>
+    static mask_type compare(simd_greater_equal, type aLhs,
+                             type aRhs) noexcept
+    {
+        return invert(greater(aRhs, aLhs));
+    }
+
+    static type select(mask_type aMask, type aTrue, type aFalse) noexcept
+    {
+        return _mm_or_si128(_mm_and_si128(aMask, aTrue),
+                            _mm_andnot_si128(aMask, aFalse));
+    }
+
+    static std::uint64_t bits(mask_type aMask) noexcept
+    {
+        if constexpr (sizeof(T) == 1)
+        {
+            return static_cast<unsigned>(_mm_movemask_epi8(aMask));
+        }
+        else if constexpr (sizeof(T) == 2)
+        {
+            return static_cast<unsigned>(_mm_movemask_epi8(
+                _mm_packs_epi16(aMask, _mm_setzero_si128())));
+        }
+        else if constexpr (sizeof(T) == 4)
+        {
+            return static_cast<unsigned>(
+                _mm_movemask_ps(_mm_castsi128_ps(aMask)));
+        }
+        else
+        {
+            return static_cast<unsigned>(
+                _mm_movemask_pd(_mm_castsi128_pd(aMask)));
+        }
+    }
+
+   private:
+    static type invert(type aValue) noexcept
+    {
+        return _mm_xor_si128(aValue, _mm_set1_epi32(-1));
+    }
+
+    static type equal(type aLhs, type aRhs) noexcept
+    {
+        if constexpr (sizeof(T) == 1)
+        {
+            return _mm_cmpeq_epi8(aLhs, aRhs);
+        }
+        else if constexpr (sizeof(T) == 2)
+        {
+            return _mm_cmpeq_epi16(aLhs, aRhs);
+        }
+        else
+        {
+            static_assert(sizeof(T) == 4);
+            return _mm_cmpeq_epi32(aLhs, aRhs);
+        }
+    }
+
+    // Unsigned lanes compare as signed ones once their top bits are flipped.
+    static type greater(type aLhs, type aRhs) noexcept
+    {
+        if constexpr (sizeof(T) == 1)
+        {
+            const __m128i bias = _mm_set1_epi8(kBias<std::int8_t>);
+            return _mm_cmpgt_epi8(_mm_xor_si128(aLhs, bias),
+                                  _mm_xor_si128(aRhs, bias));
+        }
+        else if constexpr (sizeof(T) == 2)
+        {
+            const __m128i bias = _mm_set1_epi16(kBias<std::int16_t>);
+            return _mm_cmpgt_epi16(_mm_xor_si128(aLhs, bias),
+                                   _mm_xor_si128(aRhs, bias));
+        }
+        else
+        {
+            static_assert(sizeof(T) == 4);
+            const __m128i bias = _mm_set1_epi32(kBias<std::int32_t>);
+            return _mm_cmpgt_epi32(_mm_xor_si128(aLhs, bias),
+                                   _mm_xor_si128(aRhs, bias));
+        }
+    }
+
+    template <typename S>
+    static constexpr S kBias =
+        std::is_signed_v<T> ? S{0} : std::numeric_limits<S>::min();
+};
+
+template <typename T, std::size_t N>
+struct simd_backend<
+    T, N, std::enable_if_t<std::is_integral_v<T> && (N * sizeof(T) == 16)>>
+    : simd_sse_integer<T>
+{
+};
+#endif
+
+#ifdef UTILS_SIMD_AVX
+#define UTILS_SIMD_AVX_FLOAT_BACKEND(T, N, vtype, sfx)                        \
+    template <>                                                               \
+    struct simd_backend<T, N>                                                 \
+    {                                                                         \
+        using type = vtype;                                                   \
+        using mask_type = __m256i;                                            \
+        using lane_type = simd_mask_lane_t<T>;                                \
+                                                                              \
+        static type load(const T *aFrom) noexcept                             \
+        {                                                                     \
+            return _mm256_load_p##sfx(aFrom);                                 \
+        }                                                                     \
+        static void store(T *aTo, type aValue) noexcept                       \
+        {                                                                     \
+            _mm256_store_p##sfx(aTo, aValue);                                 \
+        }                                                                     \
+        static mask_type load_mask(const lane_type *aFrom) noexcept           \
+        {                                                                     \
+            return _mm256_load_si256(                                         \
+                reinterpret_cast<const __m256i *>(aFrom));                    \
+        }                                                                     \
+        static void store_mask(lane_type *aTo, mask_type aMask) noexcept      \
+        {                                                                     \
+            _mm256_store_si256(reinterpret_cast<__m256i *>(aTo), aMask);      \
+        }                                                                     \
+                                                                              \
+        static type apply(simd_plus, type aLhs, type aRhs) noexcept           \
+        {                                                                     \
+            return _mm256_add_p##sfx(aLhs, aRhs);                             \
+        }                                                                     \
+        static type apply(simd_minus, type aLhs, type aRhs) noexcept          \
+        {                                                                     \
+            return _mm256_sub_p##sfx(aLhs, aRhs);                             \
+        }                                                                     \
+        static type apply(simd_multiplies, type aLhs, type aRhs) noexcept     \
+        {                                                                     \
+            return _mm256_mul_p##sfx(aLhs, aRhs);                             \
+        }                                                                     \
+        static type apply(simd_divides, type aLhs, type aRhs) noexcept        \
+        {                                                                     \
+            return _mm256_div_p##sfx(aLhs, aRhs);                             \
+        }                                                                     \
+        static type apply(simd_min, type aLhs, type aRhs) noexcept            \
+        {                                                                     \
+            return _mm256_min_p##sfx(aLhs, aRhs);                             \
+        }                                                                     \
+        static type apply(simd_max, type aLhs, type aRhs) noexcept            \
+        {                                                                     \
+            return _mm256_max_p##sfx(aLhs, aRhs);                             \
+        }                                                                     \
+                                                                              \
+        static mask_type compare(simd_equal, type aLhs, type aRhs) noexcept   \
+        {                                                                     \
+            return cmp<_CMP_EQ_OQ>(aLhs, aRhs);                               \
+        }                                                                     \
+        static mask_type compare(simd_not_equal, type aLhs,                   \
+                                 type aRhs) noexcept                          \
+        {                                                                     \
+            return cmp<_CMP_NEQ_UQ>(aLhs, aRhs);                              \
+        }                                                                     \
+        static mask_type compare(simd_less, type aLhs, type aRhs) noexcept    \
+        {                                                                     \
+            return cmp<_CMP_LT_OQ>(aLhs, aRhs);                               \
+        }                                                                     \
+        static mask_type compare(simd_less_equal, type aLhs,                  \
+                                 type aRhs) noexcept                          \
+        {                                                                     \
+            return cmp<_CMP_LE_OQ>(aLhs, aRhs);                               \
+        }                                                                     \
+        static mask_type compare(simd_greater, type aLhs, type aRhs) noexcept \
+        {                                                                     \
+            return cmp<_CMP_GT_OQ>(aLhs, aRhs);                               \
+        }                                                                     \
+        static mask_type compare(simd_greater_equal, type aLhs,               \
+                                 type aRhs) noexcept                          \
+        {                                                                     \
+            return cmp<_CMP_GE_OQ>(aLhs, aRhs);                               \
+        }                                                                     \
+                                                                              \
+        static type select(mask_type aMask, type aTrue, type aFalse) noexcept \
+        {                                                                     \
+            return _mm256_blendv_p##sfx(aFalse, aTrue,                        \
+                                        _mm256_castsi256_p##sfx(aMask));      \
+        }                                                                     \
+        static std::uint64_t bits(mask_type aMask) noexcept                   \
+        {                                                                     \
+            return static_cast<unsigned>(                                     \
+                _mm256_movemask_p##sfx(_mm256_castsi256_p##sfx(aMask)));      \
+        }                                                                     \
+                                                                              \
+       private:                                                               \
+        template <int Predicate>                                              \
+        static mask_type cmp(type aLhs, type aRhs) noexcept                   \
+        {                                                                     \
+            return _mm256_castp##sfx##_si256(                                 \
+                _mm256_cmp_p##sfx(aLhs, aRhs, Predicate));                    \
+        }                                                                     \
+    };
+
+UTILS_SIMD_AVX_FLOAT_BACKEND(float, 8, __m256, s)
+UTILS_SIMD_AVX_FLOAT_BACKEND(double, 4, __m256d, d)
+#undef UTILS_SIMD_AVX_FLOAT_BACKEND
+#endif
+
+#ifdef UTILS_SIMD_AVX2
+template <typename T>
+struct simd_avx2_integer
+{
+    using type = __m256i;
+    using mask_type = __m256i;
+    using lane_type = simd_mask_lane_t<T>;
+
+    static type load(const T *aFrom) noexcept
+    {
+        return _mm256_load_si256(reinterpret_cast<const __m256i *>(aFrom));
+    }
+
+    static void store(T *aTo, type aValue) noexcept
+    {
+        _mm256_store_si256(reinterpret_cast<__m256i *>(aTo), aValue);
+    }
+
+    static mask_type load_mask(const lane_type *aFrom) noexcept
+    {
+        return _mm256_load_si256(reinterpret_cast<const __m256i *>(aFrom));
+    }
+
+    static void store_mask(lane_type *aTo, mask_type aMask) noexcept
+    {
+        _mm256_store_si256(reinterpret_cast<__m256i *>(aTo), aMask);
+    }
+
+    static type apply(simd_plus, type aLhs, type aRhs) noexcept
+    {
+        if constexpr (sizeof(T) == 1)
+        {
+            return _mm256_add_epi8(aLhs, aRhs);
+        }
+        else if constexpr (sizeof(T) == 2)
+        {
+            return _mm256_add_epi16(aLhs, aRhs);
+        }
+        else if constexpr (sizeof(T) == 4)
+        {
+            return _mm256_add_epi32(aLhs, aRhs);
+        }
+        else
+        {
+            return _mm256_add_epi64(aLhs, aRhs);
+        }
+    }
+
+    static type apply(simd_minus, type aLhs, type aRhs) noexcept
+    {
+        if constexpr (sizeof(T) == 1)
+        {
+            return _mm256_sub_epi8(aLhs, aRhs);
+        }
+        else if constexpr (sizeof(T) == 2)
+        {
+            return _mm256_sub_epi16(aLhs, aRhs);
+        }
+        else if constexpr (sizeof(T) == 4)
+        {
+            return _mm256_sub_epi32(aLhs, aRhs);
+        }
+        else
+        {
+            return _mm256_sub_epi64(aLhs, aRhs);
+        }
+    }
+
+    template <typename U = T,
+              std::enable_if_t<(sizeof(U) == 2) || (sizeof(U) == 4), int> = 0>
+    static type apply(simd_multiplies, type aLhs, type aRhs) noexcept
+    {
+        if constexpr (sizeof(T) == 2)
+        {
+            return _mm256_mullo_epi16(aLhs, aRhs);
+        }
+        else
+        {
+            return _mm256_mullo_epi32(aLhs, aRhs);
+        }
+    }
+
+    static type apply(simd_bit_and, type aLhs, type aRhs) noexcept
+    {
+        return _mm256_and_si256(aLhs, aRhs);
+    }
+
+    static type apply(simd_bit_or, type aLhs, type aRhs) noexcept
+    {
+        return _mm256_or_si256(aLhs, aRhs);
+    }
+
+    static type apply(simd_bit_xor, type aLhs, type aRhs) noexcept
+    {
+        return _mm256_xor_si256(aLhs, aRhs);
+    }
+
+    template <typename U = T, std::enable_if_t<(sizeof(U) < 8), int> = 0>
+    static type apply(simd_min, type aLhs, type aRhs) noexcept
+    {
+        constexpr bool kSigned = std::is_signed_v<T>;
+        if constexpr (sizeof(T) == 1)
+        {
+            return kSigned ? _mm256_min_epi8(aLhs, aRhs)
+                           : _mm256_min_epu8(aLhs, aRhs);
+        }
+        else if constexpr (sizeof(T) == 2)
+        {
+            return kSigned ? _mm256_min_epi16(aLhs, aRhs)
+                           : _mm256_min_epu16(aLhs, aRhs);
+        }
+        else
+        {
+            return kSigned ? _mm256_min_epi32(aLhs, aRhs)
+                           : _mm256_min_epu32(aLhs, aRhs);
+        }
+    }
+
+    template <typename U = T, std::enable_if_t<(sizeof(U) < 8), int> = 0>
+    static type apply(simd_max, type aLhs, type aRhs) noexcept
+    {
+        constexpr bool kSigned = std::is_signed_v<T>;
+        if constexpr (sizeof(T) == 1)
+        {
+            return kSigned ? _mm256_max_epi8(aLhs, aRhs)
+                           : _mm256_max_epu8(aLhs, aRhs);
+        }
+        else if constexpr (sizeof(T) == 2)
+        {
+            return kSigned ? _mm256_max_epi16(aLhs, aRhs)
+                           : _mm256_max_epu16(aLhs, aRhs);
+        }
+        else
+        {
+            return kSigned ? _mm256_max_epi32(aLhs, aRhs)
+                           : _mm256_max_epu32(aLhs, aRhs);
+        }
+    }
+
+    static mask_type compare(simd_equal, type aLhs, type aRhs) noexcept
+    {
+        return equal(aLhs, aRhs);
+    }
+
+    static mask_type compare(simd_not_equal, type aLhs, type aRhs) noexcept
+    {
+        return invert(equal(aLhs, aRhs));
+    }
+
+    static mask_type compare(simd_less, type aLhs, type aRhs) noexcept
+    {
+        return greater(aRhs, aLhs);
+    }
+
+    static mask_type compare(simd_less_equal, type aLhs, type aRhs) noexcept
+    {
+        return invert(greater(aLhs, aRhs));
+    }
+
+    static mask_type compare(simd_greater, type aLhs, type aRhs) noexcept
+    {
+        return greater(aLhs, aRhs);
+    }
+
+    static mask_type compare(simd_greater_equal, type aLhs,
+                             type aRhs) noexcept
+    {
+        return invert(greater(aRhs, aLhs));
+    }
+
+    static type select(mask_type aMask, type aTrue, type aFalse) noexcept
+    {
+        return _mm256_blendv_epi8(aFalse, aTrue, aMask);
+    }
+
+    static std::uint64_t bits(mask_type aMask) noexcept
+    {
+        if constexpr (sizeof(T) == 1)
+        {
+            return static_cast<unsigned>(_mm256_movemask_epi8(aMask));
+        }
+        else if constexpr (sizeof(T) == 2)
+        {
+            // Packing works per 128-bit half; gather both halves' bytes.
+            const __m256i packed =
+                _mm256_packs_epi16(aMask, _mm256_setzero_si256());
+            return static_cast<unsigned>(_mm256_movemask_epi8(
+                       _mm256_permute4x64_epi64(packed, 0xD8))) &
+                   0xFFFFu;
+        }
+        else if constexpr (sizeof(T) == 4)
+        {
+            return static_cast<unsigned>(
+                _mm256_movemask_ps(_mm256_castsi256_ps(aMask)));
+        }
+        else
+        {
+            return static_cast<unsigned>(
+                _mm256_movemask_pd(_mm256_castsi256_pd(aMask)));
+        }
+    }
+
+   private:
+    static type invert(type aValue) noexcept
+    {
+        return _mm256_xor_si256(aValue, _mm256_set1_epi32(-1));
+    }
+
+    static type equal(type aLhs, type aRhs) noexcept
+    {
+        if constexpr (sizeof(T) == 1)
+        {
+            return _mm256_cmpeq_epi8(aLhs, aRhs);
+        }
+        else if constexpr (sizeof(T) == 2)
+        {
+            return _mm256_cmpeq_epi16(aLhs, aRhs);
+        }
+        else if constexpr (sizeof(T) == 4)
+        {
+            return _mm256_cmpeq_epi32(aLhs, aRhs);
+        }
+        else
+        {
+            return _mm256_cmpeq_epi64(aLhs, aRhs);
+        }
+    }
+
+    static type greater(type aLhs, type aRhs) noexcept
+    {
+        if constexpr (sizeof(T) == 1)
+        {
+            const __m256i bias = _mm256_set1_epi8(kBias<std::int8_t>);
+            return _mm256_cmpgt_epi8(_mm256_xor_si256(aLhs, bias),
+                                     _mm256_xor_si256(aRhs, bias));
+        }
+        else if constexpr (sizeof(T) == 2)
+        {
+            const __m256i bias = _mm256_set1_epi16(kBias<std::int16_t>);
+            return _mm256_cmpgt_epi16(_mm256_xor_si256(aLhs, bias),
+                                      _mm256_xor_si256(aRhs, bias));
+        }
+        else if constexpr (sizeof(T) == 4)
+        {
+            const __m256i bias = _mm256_set1_epi32(kBias<std::int32_t>);
+            return _mm256_cmpgt_epi32(_mm256_xor_si256(aLhs, bias),
+                                      _mm256_xor_si256(aRhs, bias));
+        }
+        else
+        {
+            const __m256i bias = _mm256_set1_epi64x(kBias<std::int64_t>);
+            return _mm256_cmpgt_epi64(_mm256_xor_si256(aLhs, bias),
+                                      _mm256_xor_si256(aRhs, bias));
+        }
+    }
+
+    template <typename S>
+    static constexpr S kBias =
+        std::is_signed_v<T> ? S{0} : std::numeric_limits<S>::min();
+};
+
+template <typename T, std::size_t N>
+struct simd_backend<
+    T, N, std::enable_if_t<std::is_integral_v<T> && (N * sizeof(T) == 32)>>
+    : simd_avx2_integer<T>
+{
+};
+#endif
+
+#ifdef UTILS_SIMD_NEON
+// NEON min/max and bit extraction differ from the scalar definitions for NaN
+// lanes or have no single instruction; those run lane by lane.
+#define UTILS_SIMD_NEON_BACKEND(T, N, vtype, mtype, sfx, msfx)                \
+    template <>                                                               \
+    struct simd_backend<T, N>                                                 \
+    {                                                                         \
+        using type = vtype;                                                   \
+        using mask_type = mtype;                                              \
+        using lane_type = simd_mask_lane_t<T>;                                \
+                                                                              \
+        static type load(const T *aFrom) noexcept                             \
+        {                                                                     \
+            return vld1q_##sfx(aFrom);                                        \
+        }                                                                     \
+        static void store(T *aTo, type aValue) noexcept                       \
+        {                                                                     \
+            vst1q_##sfx(aTo, aValue);                                         \
+        }                                                                     \
+        static mask_type load_mask(const lane_type *aFrom) noexcept           \
+        {                                                                     \
+            return vld1q_##msfx(aFrom);                                       \
+        }                                                                     \
+        static void store_mask(lane_type *aTo, mask_type aMask) noexcept      \
+        {                                                                     \
+            vst1q_##msfx(aTo, aMask);                                         \
+        }                                                                     \
+                                                                              \
+        static type apply(simd_plus, type aLhs, type aRhs) noexcept           \
+        {                                                                     \
+            return vaddq_##sfx(aLhs, aRhs);                                   \
+        }                                                                     \
+        static type apply(simd_minus, type aLhs, type aRhs) noexcept          \
+        {                                                                     \
+            return vsubq_##sfx(aLhs, aRhs);                                   \
+        }                                                                     \
+        static type apply(simd_multiplies, type aLhs, type aRhs) noexcept     \
+        {                                                                     \
+            return vmulq_##sfx(aLhs, aRhs);                                   \
+        }                                                                     \
+                                                                              \
+        static mask_type compare(simd_equal, type aLhs, type aRhs) noexcept   \
+        {                                                                     \
+            return vceqq_##sfx(aLhs, aRhs);                                   \
+        }                                                                     \
+        static mask_type compare(simd_not_equal, type aLhs,                   \
+                                 type aRhs) noexcept                          \
+        {                                                                     \
+            return vmvnq_##msfx(vceqq_##sfx(aLhs, aRhs));                     \
+        }                                                                     \
+        static mask_type compare(simd_less, type aLhs, type aRhs) noexcept    \
+        {                                                                     \
+            return vcltq_##sfx(aLhs, aRhs);                                   \
+        }                                                                     \
+        static mask_type compare(simd_less_equal, type aLhs,                  \
+                                 type aRhs) noexcept                          \
+        {                                                                     \
+            return vcleq_##sfx(aLhs, aRhs);                                   \
+        }                                                                     \
+        static mask_type compare(simd_greater, type aLhs, type aRhs) noexcept \
+        {                                                                     \
+            return vcgtq_##sfx(aLhs, aRhs);                                   \
+        }                                                                     \
+        static mask_type compare(simd_greater_equal, type aLhs,               \
+                                 type aRhs) noexcept                          \
+        {                                                                     \
+            return vcgeq_##sfx(aLhs, aRhs);                                   \
+        }                                                                     \
+                                                                              \
+        static type select(mask_type aMask, type aTrue, type aFalse) noexcept \
+        {                                                                     \
+            return vbslq_##sfx(aMask, aTrue, aFalse);                         \
+        }                                                                     \
+    };
+
+UTILS_SIMD_NEON_BACKEND(float, 4, float32x4_t, uint32x4_t, f32, u32)
+UTILS_SIMD_NEON_BACKEND(std::int8_t, 16, int8x16_t, uint8x16_t, s8, u8)
+UTILS_SIMD_NEON_BACKEND(std::uint8_t, 16, uint8x16_t, uint8x16_t, u8, u8)
+UTILS_SIMD_NEON_BACKEND(std::int16_t, 8, int16x8_t, uint16x8_t, s16, u16)
+UTILS_SIMD_NEON_BACKEND(std::uint16_t, 8, uint16x8_t, uint16x8_t, u16, u16)
+UTILS_SIMD_NEON_BACKEND(std::int32_t, 4, int32x4_t, uint32x4_t, s32, u32)
+UTILS_SIMD_NEON_BACKEND(std::uint32_t, 4, uint32x4_t, uint32x4_t, u32, u32)
+#undef UTILS_SIMD_NEON_BACKEND
+#endif
+
+template <typename Op, typename T, std::size_t N>
+constexpr simd<T, N> simd_apply(Op aOp, const simd<T, N> &aLhs,
+                                const simd<T, N> &aRhs) noexcept
+{
+    constexpr std::size_t kWidth =
+        simd_native_width<T, N, simd_has_apply<Op>::template check>();
+    simd<T, N> result;
+    if constexpr (kWidth > 0)
+    {
+        if (!__builtin_is_constant_evaluated())
+        {
+            using backend = simd_backend<T, kWidth>;
+            for (std::size_t i = 0; i < N; i += kWidth)
+            {
+                backend::store(
+                    result.data() + i,
+                    backend::apply(aOp, backend::load(aLhs.data() + i),
+                                   backend::load(aRhs.data() + i)));
+            }
+            return result;
+        }
+    }
+    for (std::size_t i = 0; i < N; ++i)
+    {
+        result.data()[i] = aOp(aLhs[i], aRhs[i]);
+    }
+    return result;
+}
+
+template <typename Op, typename T, std::size_t N>
+constexpr simd_mask<T, N> simd_compare(Op aOp, const simd<T, N> &aLhs,
+                                       const simd<T, N> &aRhs) noexcept
+{
+    using lane_type = simd_mask_lane_t<T>;
+    constexpr std::size_t kWidth =
+        simd_native_width<T, N, simd_has_compare<Op>::template check>();
+    simd<lane_type, N> lanes;
+    if constexpr (kWidth > 0)
+    {
+        if (!__builtin_is_constant_evaluated())
+        {
+            using backend = simd_backend<T, kWidth>;
+            for (std::size_t i = 0; i < N; i += kWidth)
+            {
+                backend::store_mask(
+                    lanes.data() + i,
+                    backend::compare(aOp, backend::load(aLhs.data() + i),
+                                     backend::load(aRhs.data() + i)));
+            }
+            return simd_mask<T, N>(lanes);
+        }
+    }
+    for (std::size_t i = 0; i < N; ++i)
+    {
+        lanes.data()[i] = aOp(aLhs[i], aRhs[i])
+                              ? std::numeric_limits<lane_type>::max()
+                              : lane_type{};
+    }
+    return simd_mask<T, N>(lanes);
+}
+}  // namespace details
+
+// Lane-wise comparisons of two simd<T, N>. Lanes are stored as unsigned
+// integers of sizeof(T) that are all ones or zero, as the vector compare
+// instructions produce them.
+template <typename T, std::size_t N>
+class simd_mask
+{
+   public:
+    using lane_type = details::simd_mask_lane_t<T>;
+    static constexpr std::size_t kSize = N;
+
+    constexpr simd_mask() noexcept = default;
+
+    constexpr explicit simd_mask(bool aValue) noexcept
+        : lanes_(aValue ? kTrue : lane_type{})
+    {
+    }
+
+    // Every lane of aLanes must be all ones or zero.
+    constexpr explicit simd_mask(const simd<lane_type, N> &aLanes) noexcept
+        : lanes_(aLanes)
+    {
+    }
+
+    constexpr bool operator[](std::size_t aIndex) const noexcept
+    {
+        return lanes_[aIndex];
+    }
+
+    constexpr void set(std::size_t aIndex, bool aValue) noexcept
+    {
+        lanes_.set(aIndex, aValue ? kTrue : lane_type{});
+    }
+
+    constexpr const simd<lane_type, N> &lanes() const noexcept
+    {
+        return lanes_;
+    }
+
+    // Bit i is set when lane i is.
+    constexpr std::uint64_t bits() const noexcept
+    {
+        static_assert(N <= 64);
+        constexpr std::size_t kWidth =
+            details::simd_native_width<T, N, details::simd_has_bits>();
+        std::uint64_t result{};
+        if constexpr (kWidth > 0)
+        {
+            if (!__builtin_is_constant_evaluated())
+            {
+                using backend = details::simd_backend<T, kWidth>;
+                for (std::size_t i = 0; i < N; i += kWidth)
+                {
+                    result |= backend::bits(backend::load_mask(
+                                  lanes_.data() + i))
+                              << i;
+                }
+                return result;
+            }
+        }
+        for (std::size_t i = 0; i < N; ++i)
+        {
+            result |= std::uint64_t{lanes_[i] != 0} << i;
+        }
+        return result;
+    }
+
+    constexpr bool all() const noexcept
+    {
+        return bits() == (~std::uint64_t{} >> (64 - N));
+    }
+
+    constexpr bool any() const noexcept { return bits() != 0; }
+
+    constexpr bool none() const noexcept { return bits() == 0; }
+
+    constexpr std::size_t count() const noexcept
+    {
+        std::size_t result = 0;
+        for (std::uint64_t b = bits(); b; b &= b - 1)
+        {
+            ++result;
+        }
+        return result;
+    }
+
+    // Index of the first set lane, N if there is none.
+    constexpr std::size_t find_first() const noexcept
+    {
+        std::uint64_t b = bits();
+        if (!b)
+        {
+            return N;
+        }
+        std::size_t result = 0;
+        for (; !(b & 1); b >>= 1)
+        {
+            ++result;
+        }
+        return result;
+    }
+
+    friend constexpr simd_mask operator&(const simd_mask &aLhs,
+                                         const simd_mask &aRhs) noexcept
+    {
+        return simd_mask(aLhs.lanes_ & aRhs.lanes_);
+    }
+
+    friend constexpr simd_mask operator|(const simd_mask &aLhs,
+                                         const simd_mask &aRhs) noexcept
+    {
+        return simd_mask(aLhs.lanes_ | aRhs.lanes_);
+    }
+
+    friend constexpr simd_mask operator^(const simd_mask &aLhs,
+                                         const simd_mask &aRhs) noexcept
+    {
+        return simd_mask(aLhs.lanes_ ^ aRhs.lanes_);
+    }
+
+    friend constexpr simd_mask operator!(const simd_mask &aMask) noexcept
+    {
+        return simd_mask(~aMask.lanes_);
+    }
+
+    constexpr simd_mask &operator&=(const simd_mask &aRhs) noexcept
+    {
+        return *this = *this & aRhs;
+    }
+
+    constexpr simd_mask &operator|=(const simd_mask &aRhs) noexcept
+    {
+        return *this = *this | aRhs;
+    }
+
+    constexpr simd_mask &operator^=(const simd_mask &aRhs) noexcept
+    {
+        return *this = *this ^ aRhs;
+    }
+
+   private:
+    static constexpr lane_type kTrue = std::numeric_limits<lane_type>::max();
+
+    simd<lane_type, N> lanes_;
+};
+
+// N lanes of an arithmetic T, stored aligned to N * sizeof(T) (at most 64).
+// Operations use SSE2/SSE4.1/AVX/AVX2 or NEON registers when the translation
+// unit is compiled for them and a backend exists for T and N, in chunks when
+// N is wider than the register, and run lane by lane otherwise. Constant
+// evaluation always takes the lane by lane path, so every operation is
+// constexpr. Integer arithmetic wraps around.
+template <typename T, std::size_t N>
+class simd
+{
+    static_assert(std::is_arithmetic_v<T> && !std::is_same_v<T, bool>);
+    static_assert(sizeof(T) <= 8);
+    static_assert((N > 0) && ((N & (N - 1)) == 0), "N must be a power of 2");
+
+   public:
+    using value_type = T;
+    using mask_type = simd_mask<T, N>;
+    static constexpr std::size_t kSize = N;
+    static constexpr std::size_t kAlignment =
+        std::min<std::size_t>(N * sizeof(T), 64);
+
+    constexpr simd() noexcept = default;
+
+    constexpr simd(T aValue) noexcept
+    {
+        for (std::size_t i = 0; i < N; ++i)
+        {
+            lanes_[i] = aValue;
+        }
+    }
+
+    template <typename... Ts,
+              typename = std::enable_if_t<(sizeof...(Ts) + 2 == N) &&
+                                          std::conjunction_v<
+                                              std::is_convertible<Ts, T>...>>>
+    constexpr simd(T aFirst, T aSecond, Ts... aRest) noexcept
+        : lanes_{aFirst, aSecond, static_cast<T>(aRest)...}
+    {
+    }
+
+    static constexpr simd load(const T *aFrom) noexcept
+    {
+        assert(aFrom);
+        simd result;
+        if (__builtin_is_constant_evaluated())
+        {
+            for (std::size_t i = 0; i < N; ++i)
+            {
+                result.lanes_[i] = aFrom[i];
+            }
+        }
+        else
+        {
+            std::memcpy(result.lanes_, aFrom, sizeof(result.lanes_));
+        }
+        return result;
+    }
+
+    // aFrom must be aligned to kAlignment.
+    static constexpr simd load_aligned(const T *aFrom) noexcept
+    {
+        UTILS_ENABLE_IN_RUNTIME_CONTEXT(
+            assert(is_aligned(aFrom, kAlignment) && "misaligned load"));
+        return load(aFrom);
+    }
+
+    constexpr void store(T *aTo) const noexcept
+    {
+        assert(aTo);
+        if (__builtin_is_constant_evaluated())
+        {
+            for (std::size_t i = 0; i < N; ++i)
+            {
+                aTo[i] = lanes_[i];
+            }
+        }
+        else
+        {
+            std::memcpy(aTo, lanes_, sizeof(lanes_));
+        }
+    }
+
+    // aTo must be aligned to kAlignment.
+    constexpr void store_aligned(T *aTo) const noexcept
+    {
+        UTILS_ENABLE_IN_RUNTIME_CONTEXT(
+            assert(is_aligned(aTo, kAlignment) && "misaligned store"));
+        store(aTo);
+    }
+
+    constexpr T operator[](std::size_t aIndex) const noexcept
+    {
+        assert(aIndex < N);
+        return lanes_[aIndex];
+    }
+
+    constexpr void set(std::size_t aIndex, T aValue) noexcept
+    {
+        assert(aIndex < N);
+        lanes_[aIndex] = aValue;
+    }
+
+    constexpr const T *data() const noexcept { return lanes_; }
+
+    constexpr T *data() noexcept { return lanes_; }
+
+    constexpr simd<T, N / 2> low() const noexcept
+    {
+        static_assert(N > 1);
+        simd<T, N / 2> result;
+        for (std::size_t i = 0; i < N / 2; ++i)
+        {
+            result.set(i, lanes_[i]);
+        }
+        return result;
+    }
+
+    constexpr simd<T, N / 2> high() const noexcept
+    {
+        static_assert(N > 1);
+        simd<T, N / 2> result;
+        for (std::size_t i = 0; i < N / 2; ++i)
+        {
+            result.set(i, lanes_[N / 2 + i]);
+        }
+        return result;
+    }
+
+    friend constexpr simd operator+(const simd &aLhs,
+                                    const simd &aRhs) noexcept
+    {
+        return details::simd_apply(details::simd_plus{}, aLhs, aRhs);
+    }
+
+    friend constexpr simd operator-(const simd &aLhs,
+                                    const simd &aRhs) noexcept
+    {
+        return details::simd_apply(details::simd_minus{}, aLhs, aRhs);
+    }
+
+    friend constexpr simd operator*(const simd &aLhs,
+                                    const simd &aRhs) noexcept
+    {
+        return details::simd_apply(details::simd_multiplies{}, aLhs, aRhs);
+    }
+
+    friend constexpr simd operator/(const simd &aLhs,
+                                    const simd &aRhs) noexcept
+    {
+        return details::simd_apply(details::simd_divides{}, aLhs, aRhs);
+    }
+
+    friend constexpr simd operator&(const simd &aLhs,
+                                    const simd &aRhs) noexcept
+    {
+        static_assert(std::is_integral_v<T>);
+        return details::simd_apply(details::simd_bit_and{}, aLhs, aRhs);
+    }
+
+    friend constexpr simd operator|(const simd &aLhs,
+                                    const simd &aRhs) noexcept
+    {
+        static_assert(std::is_integral_v<T>);
+        return details::simd_apply(details::simd_bit_or{}, aLhs, aRhs);
+    }
+
+    friend constexpr simd operator^(const simd &aLhs,
+                                    const simd &aRhs) noexcept
+    {
+        static_assert(std::is_integral_v<T>);
+        return details::simd_apply(details::simd_bit_xor{}, aLhs, aRhs);
+    }
+
+    friend constexpr simd operator~(const simd &aValue) noexcept
+    {
+        return aValue ^ simd(static_cast<T>(~T{}));
+    }
+
+    friend constexpr simd operator-(const simd &aValue) noexcept
+    {
+        if constexpr (std::is_floating_point_v<T>)
+        {
+            // Not 0 - x, which keeps the sign of zeros.
+            return aValue * simd(T{-1});
+        }
+        else
+        {
+            return simd(T{}) - aValue;
+        }
+    }
+
+    friend constexpr simd operator<<(const simd &aValue, int aCount) noexcept
+    {
+        static_assert(std::is_integral_v<T>);
+        assert((aCount >= 0) && (aCount < int{sizeof(T) * CHAR_BIT}));
+        using wrap_t = details::simd_wrap_t<T>;
+        simd result;
+        for (std::size_t i = 0; i < N; ++i)
+        {
+            result.lanes_[i] =
+                static_cast<T>(static_cast<wrap_t>(aValue.lanes_[i]) << aCount);
+        }
+        return result;
+    }
+
+    // Arithmetic for signed lanes, logical for unsigned ones.
+    friend constexpr simd operator>>(const simd &aValue, int aCount) noexcept
+    {
+        static_assert(std::is_integral_v<T>);
+        assert((aCount >= 0) && (aCount < int{sizeof(T) * CHAR_BIT}));
+        simd result;
+        for (std::size_t i = 0; i < N; ++i)
+        {
+            result.lanes_[i] = static_cast<T>(aValue.lanes_[i] >> aCount);
+        }
+        return result;
+    }
+
+    constexpr simd &operator+=(const simd &aRhs) noexcept
+    {
+        return *this = *this + aRhs;
+    }
+
+    constexpr simd &operator-=(const simd &aRhs) noexcept
+    {
+        return *this = *this - aRhs;
+    }
+
+    constexpr simd &operator*=(const simd &aRhs) noexcept
+    {
+        return *this = *this * aRhs;
+    }
+
+    constexpr simd &operator/=(const simd &aRhs) noexcept
+    {
+        return *this = *this / aRhs;
+    }
+
+    constexpr simd &operator&=(const simd &aRhs) noexcept
+    {
+        return *this = *this & aRhs;
+    }
+
+    constexpr simd &operator|=(const simd &aRhs) noexcept
+    {
+        return *this = *this | aRhs;
+    }
+
+    constexpr simd &operator^=(const simd &aRhs) noexcept
+    {
+        return *this = *this ^ aRhs;
+    }
+
+    constexpr simd &operator<<=(int aCount) noexcept
+    {
+        return *this = *this << aCount;
+    }
+
+    constexpr simd &operator>>=(int aCount) noexcept
+    {
+        return *this = *this >> aCount;
+    }
+
+    friend constexpr mask_type operator==(const simd &aLhs,
+                                          const simd &aRhs) noexcept
+    {
+        return details::simd_compare(details::simd_equal{}, aLhs, aRhs);
+    }
+
+    friend constexpr mask_type operator!=(const simd &aLhs,
+                                          const simd &aRhs) noexcept
+    {
+        return details::simd_compare(details::simd_not_equal{}, aLhs, aRhs);
+    }
+
+    friend constexpr mask_type operator<(const simd &aLhs,
+                                         const simd &aRhs) noexcept
+    {
+        return details::simd_compare(details::simd_less{}, aLhs, aRhs);
+    }
+
+    friend constexpr mask_type operator<=(const simd &aLhs,
+                                          const simd &aRhs) noexcept
+    {
+        return details::simd_compare(details::simd_less_equal{}, aLhs, aRhs);
+    }
+
+    friend constexpr mask_type operator>(const simd &aLhs,
+                                         const simd &aRhs) noexcept
+    {
+        return details::simd_compare(details::simd_greater{}, aLhs, aRhs);
+    }
+
+    friend constexpr mask_type operator>=(const simd &aLhs,
+                                          const simd &aRhs) noexcept
+    {
+        return details::simd_compare(details::simd_greater_equal{}, aLhs,
+                                     aRhs);
+    }
+
+   private:
+    alignas(kAlignment) T lanes_[N]{};
+};
+
+template <typename T, std::size_t N>
+constexpr simd<T, N> min(const simd<T, N> &aLhs,
+                         const simd<T, N> &aRhs) noexcept
+{
+    return details::simd_apply(details::simd_min{}, aLhs, aRhs);
+}
+
+template <typename T, std::size_t N>
+constexpr simd<T, N> max(const simd<T, N> &aLhs,
+                         const simd<T, N> &aRhs) noexcept
+{
+    return details::simd_apply(details::simd_max{}, aLhs, aRhs);
+}
+
+// Lane i of aTrue where aMask is set, of aFalse elsewhere.
+template <typename T, std::size_t N>
+constexpr simd<T, N> select(const simd_mask<T, N> &aMask,
+                            const simd<T, N> &aTrue,
+                            const simd<T, N> &aFalse) noexcept
+{
+    constexpr std::size_t kWidth =
+        details::simd_native_width<T, N, details::simd_has_select>();
+    simd<T, N> result;
+    if constexpr (kWidth > 0)
+    {
+        if (!__builtin_is_constant_evaluated())
+        {
+            using backend = details::simd_backend<T, kWidth>;
+            for (std::size_t i = 0; i < N; i += kWidth)
+            {
+                backend::store(
+                    result.data() + i,
+                    backend::select(
+                        backend::load_mask(aMask.lanes().data() + i),
+                        backend::load(aTrue.data() + i),
+                        backend::load(aFalse.data() + i)));
+            }
+            return result;
+        }
+    }
+    for (std::size_t i = 0; i < N; ++i)
+    {
+        result.set(i, aMask[i] ? aTrue[i] : aFalse[i]);
+    }
+    return result;
+}
+
+// Reductions combine the two halves until one lane is left, so sums of
+// floating point lanes are computed pairwise.
+template <typename T, std::size_t N>
+constexpr T reduce_add(const simd<T, N> &aValue) noexcept
+{
+    if constexpr (N == 1)
+    {
+        return aValue[0];
+    }
+    else
+    {
+        return reduce_add(aValue.low() + aValue.high());
+    }
+}
+
+template <typename T, std::size_t N>
+constexpr T reduce_min(const simd<T, N> &aValue) noexcept
+{
+    if constexpr (N == 1)
+    {
+        return aValue[0];
+    }
+    else
+    {
+        return reduce_min(min(aValue.low(), aValue.high()));
+    }
+}
+
+template <typename T, std::size_t N>
+constexpr T reduce_max(const simd<T, N> &aValue) noexcept
+{
+    if constexpr (N == 1)
+    {
+        return aValue[0];
+    }
+    else
+    {
+        return reduce_max(max(aValue.low(), aValue.high()));
+    }
+}
+
+// Lane i of the result is lane Indices[i] of aValue; the result may be
+// narrower or wider than aValue.
+template <std::size_t... Indices, typename T, std::size_t N>
+constexpr simd<T, sizeof...(Indices)> shuffle(const simd<T, N> &aValue) noexcept
+{
+    static_assert(((Indices < N) && ...), "shuffle index out of range");
+    return simd<T, sizeof...(Indices)>(aValue[Indices]...);
+}
+
+namespace details
+{
+template <typename T, std::size_t N, std::size_t... Indices>
+constexpr simd<T, N> simd_reverse(const simd<T, N> &aValue,
+                                  std::index_sequence<Indices...>) noexcept
+{
+    return shuffle<(N - 1 - Indices)...>(aValue);
+}
+}  // namespace details
+
+template <typename T, std::size_t N>
+constexpr simd<T, N> reverse(const simd<T, N> &aValue) noexcept
+{
+    return details::simd_reverse(aValue, std::make_index_sequence<N>{});
+}
+}  // namespace utils
+
+#endif /* utils_simd_h */
@@ -0,0 +1,409 @@
+#ifndef utils_slot_map_h
+#define utils_slot_map_h
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "common.h"
+#include "memory/allocator.h"
+#include "memory/relocate.h"
+
+namespace utils
+{
+template <std::size_t IndexBits, std::size_t GenerationBits>
+class slot_handle
+{
+    static_assert(IndexBits > 0);
+    static_assert(GenerationBits > 0);
+    static_assert(IndexBits + GenerationBits <= 64);
+
+   public:
+    static constexpr std::size_t kIndexBits = IndexBits;
+    static constexpr std::size_t kGenerationBits = GenerationBits;
+
+    using value_type = uint_from_nbits_t<IndexBits + GenerationBits>;
+    using index_type = uint_from_nbits_t<IndexBits>;
+    using generation_type = uint_from_nbits_t<GenerationBits>;
+
+    static constexpr value_type kIndexMask =
+        static_cast<value_type>((std::uint64_t{1} << IndexBits) - 1);
+    static constexpr value_type kGenerationMask =
+        static_cast<value_type>((std::uint64_t{1} << GenerationBits) - 1);
+
+    constexpr slot_handle() noexcept = default;
+
+    constexpr slot_handle(index_type aIndex,
+                          generation_type aGeneration) noexcept
+        : value_(static_cast<value_type>(
+              (static_cast<value_type>(aGeneration & kGenerationMask)
+               << IndexBits) |
+              (static_cast<value_type>(aIndex) & kIndexMask)))
+    {
+    }
+
+    static constexpr slot_handle from_value(value_type aValue) noexcept
+    {
+        slot_handle h;
+        h.value_ = aValue;
+        return h;
+    }
+
+    constexpr index_type index() const noexcept
+    {
+        return static_cast<index_type>(value_ & kIndexMask);
+    }
+
+    constexpr generation_type generation() const noexcept
+    {
+        return static_cast<generation_type>((value_ >> IndexBits) &
+                                            kGenerationMask);
+    }
+
+    constexpr value_type value() const noexcept { return value_; }
+
+    constexpr explicit operator bool() const noexcept
+    {
+        return generation() != 0;
+    }
+
+    friend constexpr bool operator==(slot_handle aLhs,
+                                     slot_handle aRhs) noexcept
+    {
+        return aLhs.value_ == aRhs.value_;
+    }
+
+    friend constexpr bool operator!=(slot_handle aLhs,
+                                     slot_handle aRhs) noexcept
+    {
+        return !(aLhs == aRhs);
+    }
+
+   private:
+    value_type value_{};
+};
+
+template <typename T, std::size_t IndexBits = 20,
+          std::size_t GenerationBits = 32 - IndexBits>
+class slot_map
+{
+    static_assert(std::is_nothrow_move_constructible_v<T>,
+                  "slot_map relocates values on erase and growth");
+    static_assert(std::is_nothrow_destructible_v<T>);
+
+   public:
+    using handle = slot_handle<IndexBits, GenerationBits>;
+    using value_type = T;
+    using size_type = std::size_t;
+    using index_type = typename handle::index_type;
+    using generation_type = typename handle::generation_type;
+    using allocator_type = memory::allocator<T>;
+    using iterator = T *;
+    using const_iterator = const T *;
+
+    static constexpr size_type kMaxSize = handle::kIndexMask;
+
+    slot_map() noexcept = default;
+
+    explicit slot_map(memory::memory_resource *aResource) noexcept
+        : alloc_(aResource)
+    {
+    }
+
+    explicit slot_map(const allocator_type &aAllocator) noexcept
+        : alloc_(aAllocator)
+    {
+    }
+
+    slot_map(const slot_map &) = delete;
+    slot_map &operator=(const slot_map &) = delete;
+
+    slot_map(slot_map &&aOther) noexcept
+        : alloc_(aOther.alloc_)
+        , values_(std::exchange(aOther.values_, nullptr))
+        , dense_to_slot_(std::exchange(aOther.dense_to_slot_, nullptr))
+        , slots_(std::exchange(aOther.slots_, nullptr))
+        , size_(std::exchange(aOther.size_, 0))
+        , capacity_(std::exchange(aOther.capacity_, 0))
+        , slot_count_(std::exchange(aOther.slot_count_, 0))
+        , free_head_(std::exchange(aOther.free_head_, kNoSlot))
+    {
+    }
+
+    slot_map &operator=(slot_map &&aOther) noexcept
+    {
+        if (this == &aOther)
+        {
+            return *this;
+        }
+
+        clear();
+        if (alloc_ == aOther.alloc_)
+        {
+            release_storage();
+            values_ = std::exchange(aOther.values_, nullptr);
+            dense_to_slot_ = std::exchange(aOther.dense_to_slot_, nullptr);
+            slots_ = std::exchange(aOther.slots_, nullptr);
+            size_ = std::exchange(aOther.size_, 0);
+            capacity_ = std::exchange(aOther.capacity_, 0);
+            slot_count_ = std::exchange(aOther.slot_count_, 0);
+            free_head_ = std::exchange(aOther.free_head_, kNoSlot);
+        }
+        else
+        {
+            // handles from aOther must stay valid, so the slot table is
+            // rebuilt with the same indices and generations
+            UTILS_ABORT_IF_REASON(!reserve(aOther.slot_count_),
+                                  "failed to allocate %zu slots",
+                                  aOther.slot_count_);
+            for (size_type i = 0; i < aOther.slot_count_; ++i)
+            {
+                slots_[i] = aOther.slots_[i];
+            }
+            for (size_type i = 0; i < aOther.size_; ++i)
+            {
+                alloc_.construct(values_ + i, std::move(aOther.values_[i]));
+                dense_to_slot_[i] = aOther.dense_to_slot_[i];
+            }
+            size_ = aOther.size_;
+            slot_count_ = aOther.slot_count_;
+            free_head_ = aOther.free_head_;
+            aOther.clear();
+        }
+        return *this;
+    }
+
+    ~slot_map()
+    {
+        clear();
+        release_storage();
+    }
+
+    template <typename... Args>
+    [[nodiscard]] handle emplace(Args &&...aArgs) noexcept
+    {
+        static_assert(memory::is_nothrow_uses_allocator_constructible_v<
+                      T, allocator_type, Args...>);
+        if (size_ == capacity_ && !grow())
+        {
+            return handle{};
+        }
+
+        index_type slot_index;
+        if (free_head_ != kNoSlot)
+        {
+            slot_index = free_head_;
+            free_head_ = slots_[slot_index].index;
+        }
+        else
+        {
+            slot_index = static_cast<index_type>(slot_count_++);
+            slots_[slot_index].generation = 1;
+        }
+
+        alloc_.construct(values_ + size_, std::forward<Args>(aArgs)...);
+        dense_to_slot_[size_] = slot_index;
+        slot &s = slots_[slot_index];
+        s.index = static_cast<index_type>(size_);
+        ++size_;
+        return handle{slot_index, s.generation};
+    }
+
+    [[nodiscard]] handle insert(const T &aValue) noexcept
+    {
+        return emplace(aValue);
+    }
+
+    [[nodiscard]] handle insert(T &&aValue) noexcept
+    {
+        return emplace(std::move(aValue));
+    }
+
+    bool erase(handle aHandle) noexcept
+    {
+        if (!contains(aHandle))
+        {
+            return false;
+        }
+
+        const index_type slot_index = aHandle.index();
+        slot &s = slots_[slot_index];
+        const index_type dense_index = s.index;
+        const size_type last = size_ - 1;
+        values_[dense_index].~T();
+        if (dense_index != last)
+        {
+            memory::relocate(values_ + last, values_ + dense_index);
+            dense_to_slot_[dense_index] = dense_to_slot_[last];
+            slots_[dense_to_slot_[dense_index]].index = dense_index;
+        }
+        --size_;
+
+        s.generation = next_generation(s.generation);
+        s.index = free_head_;
+        free_head_ = slot_index;
+        return true;
+    }
+
+    bool contains(handle aHandle) const noexcept
+    {
+        const index_type slot_index = aHandle.index();
+        return aHandle && (slot_index < slot_count_) &&
+               (slots_[slot_index].generation == aHandle.generation());
+    }
+
+    T *find(handle aHandle) noexcept
+    {
+        return contains(aHandle) ? values_ + slots_[aHandle.index()].index
+                                 : nullptr;
+    }
+
+    const T *find(handle aHandle) const noexcept
+    {
+        return contains(aHandle) ? values_ + slots_[aHandle.index()].index
+                                 : nullptr;
+    }
+
+    T &operator[](handle aHandle) noexcept
+    {
+        assert(contains(aHandle));
+        return values_[slots_[aHandle.index()].index];
+    }
+
+    const T &operator[](handle aHandle) const noexcept
+    {
+        assert(contains(aHandle));
+        return values_[slots_[aHandle.index()].index];
+    }
+
+    handle handle_at(size_type aDenseIndex) const noexcept
+    {
+        assert(aDenseIndex < size_);
+        const index_type slot_index = dense_to_slot_[aDenseIndex];
+        return handle{slot_index, slots_[slot_index].generation};
+    }
+
+    bool reserve(size_type aCapacity) noexcept
+    {
+        if (aCapacity <= capacity_)
+        {
+            return true;
+        }
+        if (aCapacity > kMaxSize)
+        {
+            return false;
+        }
+
+        T *values = alloc_.template allocate_object<T>(aCapacity);
+        index_type *dense_to_slot =
+            alloc_.template allocate_object<index_type>(aCapacity);
+        slot *slots = alloc_.template allocate_object<slot>(aCapacity);
+        if (!values || !dense_to_slot || !slots)
+        {
+            alloc_.deallocate_object(values);
+            alloc_.deallocate_object(dense_to_slot);
+            alloc_.deallocate_object(slots);
+            return false;
+        }
+
+        if (size_)
+        {
+            memory::uninitialized_relocate_n(values_, size_, values);
+            memory::memcpy(static_cast<void *>(dense_to_slot),
+                           static_cast<const void *>(dense_to_slot_),
+                           size_ * sizeof(index_type));
+        }
+        if (slot_count_)
+        {
+            memory::memcpy(static_cast<void *>(slots),
+                           static_cast<const void *>(slots_),
+                           slot_count_ * sizeof(slot));
+        }
+
+        release_storage();
+        values_ = values;
+        dense_to_slot_ = dense_to_slot;
+        slots_ = slots;
+        capacity_ = aCapacity;
+        return true;
+    }
+
+    void clear() noexcept
+    {
+        while (size_)
+        {
+            erase(handle_at(size_ - 1));
+        }
+    }
+
+    iterator begin() noexcept { return values_; }
+    iterator end() noexcept { return values_ + size_; }
+    const_iterator begin() const noexcept { return values_; }
+    const_iterator end() const noexcept { return values_ + size_; }
+    const_iterator cbegin() const noexcept { return values_; }
+    const_iterator cend() const noexcept { return values_ + size_; }
+
+    T *data() noexcept { return values_; }
+    const T *data() const noexcept { return values_; }
+
+    size_type size() const noexcept { return size_; }
+    size_type capacity() const noexcept { return capacity_; }
+    bool empty() const noexcept { return !size_; }
+    static constexpr size_type max_size() noexcept { return kMaxSize; }
+
+    allocator_type get_allocator() const noexcept { return alloc_; }
+
+   private:
+    static constexpr index_type kNoSlot =
+        static_cast<index_type>(handle::kIndexMask);
+    static constexpr generation_type kGenerationMask =
+        static_cast<generation_type>(handle::kGenerationMask);
+
+    struct slot
+    {
+        index_type index;
+        generation_type generation;
+    };
+
+    static constexpr generation_type next_generation(
+        generation_type aGeneration) noexcept
+    {
+        const auto next = static_cast<generation_type>(
+            static_cast<generation_type>(aGeneration + 1) & kGenerationMask);
+        return next ? next : generation_type{1};
+    }
+
+    bool grow() noexcept
+    {
+        const size_type new_capacity =
+            capacity_ ? std::min(capacity_ * 2, kMaxSize) : size_type{8};
+        return (new_capacity > capacity_) && reserve(new_capacity);
+    }
+
+    void release_storage() noexcept
+    {
+        alloc_.deallocate_object(values_);
+        alloc_.deallocate_object(dense_to_slot_);
+        alloc_.deallocate_object(slots_);
+        values_ = nullptr;
+        dense_to_slot_ = nullptr;
+        slots_ = nullptr;
+        capacity_ = 0;
+    }
+
+    allocator_type alloc_{};
+    T *values_{};
+    index_type *dense_to_slot_{};
+    slot *slots_{};
+    size_type size_{};
+    size_type capacity_{};
+    size_type slot_count_{};
+    index_type free_head_{kNoSlot};
+};
+}  // namespace utils
+
+#endif /* utils_slot_map_h */
@@ -0,0 +1,372 @@
+#ifndef utils_small_vector_h
+#define utils_small_vector_h
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "common.h"
+#include "memory/allocator.h"
+#include "memory/relocate.h"
+
+namespace utils
+{
+template <typename T, std::size_t N>
+class small_vector
+{
+    static_assert(N > 0);
+    static_assert(std::is_nothrow_move_constructible_v<T>);
+    static_assert(std::is_nothrow_destructible_v<T>);
+
+   public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = T &;
+    using const_reference = const T &;
+    using pointer = T *;
+    using const_pointer = const T *;
+    using iterator = T *;
+    using const_iterator = const T *;
+    using allocator_type = memory::allocator<T>;
+
+    static constexpr size_type kInlineCapacity = N;
+
+    small_vector() noexcept = default;
+
+    explicit small_vector(memory::memory_resource *aResource) noexcept
+        : alloc_(aResource)
+    {
+    }
+
+    explicit small_vector(const allocator_type &aAllocator) noexcept
+        : alloc_(aAllocator)
+    {
+    }
+
+    small_vector(std::initializer_list<T> aList,
+                 const allocator_type &aAllocator = {}) noexcept
+        : alloc_(aAllocator)
+    {
+        append_copies(aList.begin(), aList.end());
+    }
+
+    small_vector(const small_vector &aOther) noexcept
+        : small_vector(aOther, aOther.alloc_)
+    {
+    }
+
+    small_vector(const small_vector &aOther,
+                 const allocator_type &aAllocator) noexcept
+        : alloc_(aAllocator)
+    {
+        append_copies(aOther.begin(), aOther.end());
+    }
+
+    small_vector(small_vector &&aOther) noexcept : alloc_(aOther.alloc_)
+    {
+        if (aOther.is_inline())
+        {
+            memory::uninitialized_relocate_n(aOther.data_, aOther.size_,
+                                             data_);
+            size_ = std::exchange(aOther.size_, 0);
+        }
+        else
+        {
+            data_ = std::exchange(aOther.data_, aOther.inline_data());
+            size_ = std::exchange(aOther.size_, 0);
+            capacity_ = std::exchange(aOther.capacity_, N);
+        }
+    }
+
+    small_vector(small_vector &&aOther,
+                 const allocator_type &aAllocator) noexcept
+        : alloc_(aAllocator)
+    {
+        if (!aOther.is_inline() && (alloc_ == aOther.alloc_))
+        {
+            data_ = std::exchange(aOther.data_, aOther.inline_data());
+            size_ = std::exchange(aOther.size_, 0);
+            capacity_ = std::exchange(aOther.capacity_, N);
+        }
+        else
+        {
+            reserve_or_abort(aOther.size_);
+            for (auto &v: aOther)
+            {
+                alloc_.construct(data_ + size_, std::move(v));
+                ++size_;
+            }
+            aOther.clear();
+        }
+    }
+
+    small_vector &operator=(const small_vector &aOther) noexcept
+    {
+        if (this != &aOther)
+        {
+            clear();
+            append_copies(aOther.begin(), aOther.end());
+        }
+        return *this;
+    }
+
+    small_vector &operator=(small_vector &&aOther) noexcept
+    {
+        if (this == &aOther)
+        {
+            return *this;
+        }
+
+        clear();
+        if (alloc_ != aOther.alloc_)
+        {
+            // The elements are rebuilt so that they pick up our allocator.
+            reserve_or_abort(aOther.size_);
+            for (auto &v: aOther)
+            {
+                alloc_.construct(data_ + size_, std::move(v));
+                ++size_;
+            }
+            aOther.clear();
+        }
+        else if (!aOther.is_inline())
+        {
+            release_storage();
+            data_ = std::exchange(aOther.data_, aOther.inline_data());
+            size_ = std::exchange(aOther.size_, 0);
+            capacity_ = std::exchange(aOther.capacity_, N);
+        }
+        else
+        {
+            memory::uninitialized_relocate_n(aOther.data_, aOther.size_,
+                                             data_);
+            size_ = std::exchange(aOther.size_, 0);
+        }
+        return *this;
+    }
+
+    ~small_vector()
+    {
+        clear();
+        release_storage();
+    }
+
+    template <typename... Args>
+    T &emplace_back(Args &&...aArgs) noexcept
+    {
+        T *ptr = try_emplace_back(std::forward<Args>(aArgs)...);
+        UTILS_ABORT_IF_REASON(!ptr, "failed to grow small_vector to %zu",
+                              size_ + 1);
+        return *ptr;
+    }
+
+    template <typename... Args>
+    T *try_emplace_back(Args &&...aArgs) noexcept
+    {
+        static_assert(memory::is_nothrow_uses_allocator_constructible_v<
+                      T, allocator_type, Args...>);
+        if (size_ == capacity_)
+        {
+            return grow_and_emplace_back(std::forward<Args>(aArgs)...);
+        }
+        T *ptr = data_ + size_;
+        alloc_.construct(ptr, std::forward<Args>(aArgs)...);
+        ++size_;
+        return ptr;
+    }
+
+    T &push_back(const T &aValue) noexcept { return emplace_back(aValue); }
+
+    T &push_back(T &&aValue) noexcept
+    {
+        return emplace_back(std::move(aValue));
+    }
+
+    void pop_back() noexcept
+    {
+        assert(size_);
+        data_[--size_].~T();
+    }
+
+    iterator erase(const_iterator aPos) noexcept
+    {
+        return erase(aPos, aPos + 1);
+    }
+
+    iterator erase(const_iterator aFirst, const_iterator aLast) noexcept
+    {
+        assert(begin() <= aFirst && aFirst <= aLast && aLast <= end());
+        const auto first = static_cast<size_type>(aFirst - begin());
+        const auto last = static_cast<size_type>(aLast - begin());
+        if (first != last)
+        {
+            std::move(data_ + last, data_ + size_, data_ + first);
+            const size_type new_size = size_ - (last - first);
+            while (size_ > new_size)
+            {
+                pop_back();
+            }
+        }
+        return begin() + first;
+    }
+
+    void resize(size_type aCount) noexcept
+    {
+        reserve_or_abort(aCount);
+        while (size_ > aCount)
+        {
+            pop_back();
+        }
+        while (size_ < aCount)
+        {
+            alloc_.construct(data_ + size_);
+            ++size_;
+        }
+    }
+
+    bool reserve(size_type aCapacity) noexcept
+    {
+        if (aCapacity <= capacity_)
+        {
+            return true;
+        }
+
+        const auto [data, count] = alloc_.allocate_at_least(aCapacity);
+        if (!data)
+        {
+            return false;
+        }
+
+        adopt_storage(data, count);
+        return true;
+    }
+
+    void clear() noexcept
+    {
+        while (size_)
+        {
+            pop_back();
+        }
+    }
+
+    T &operator[](size_type aIndex) noexcept
+    {
+        assert(aIndex < size_);
+        return data_[aIndex];
+    }
+
+    const T &operator[](size_type aIndex) const noexcept
+    {
+        assert(aIndex < size_);
+        return data_[aIndex];
+    }
+
+    T &front() noexcept { return (*this)[0]; }
+    const T &front() const noexcept { return (*this)[0]; }
+    T &back() noexcept { return (*this)[size_ - 1]; }
+    const T &back() const noexcept { return (*this)[size_ - 1]; }
+
+    T *data() noexcept { return data_; }
+    const T *data() const noexcept { return data_; }
+
+    iterator begin() noexcept { return data_; }
+    iterator end() noexcept { return data_ + size_; }
+    const_iterator begin() const noexcept { return data_; }
+    const_iterator end() const noexcept { return data_ + size_; }
+    const_iterator cbegin() const noexcept { return begin(); }
+    const_iterator cend() const noexcept { return end(); }
+
+    size_type size() const noexcept { return size_; }
+    size_type capacity() const noexcept { return capacity_; }
+    bool empty() const noexcept { return !size_; }
+    bool is_inline() const noexcept { return data_ == inline_data(); }
+
+    allocator_type get_allocator() const noexcept { return alloc_; }
+
+    friend bool operator==(const small_vector &aLhs,
+                           const small_vector &aRhs) noexcept
+    {
+        return std::equal(aLhs.begin(), aLhs.end(), aRhs.begin(), aRhs.end());
+    }
+
+    friend bool operator!=(const small_vector &aLhs,
+                           const small_vector &aRhs) noexcept
+    {
+        return !(aLhs == aRhs);
+    }
+
+   private:
+    T *inline_data() noexcept { return reinterpret_cast<T *>(inline_); }
+
+    const T *inline_data() const noexcept
+    {
+        return reinterpret_cast<const T *>(inline_);
+    }
+
+    void append_copies(const T *aFirst, const T *aLast) noexcept
+    {
+        static_assert(memory::is_nothrow_uses_allocator_constructible_v<
+                      T, allocator_type, const T &>);
+        reserve_or_abort(size_ + static_cast<size_type>(aLast - aFirst));
+        for (; aFirst != aLast; ++aFirst)
+        {
+            alloc_.construct(data_ + size_, *aFirst);
+            ++size_;
+        }
+    }
+
+    // The new element is built before the old ones are relocated: aArgs may
+    // refer into the current storage, as in v.push_back(v[0]).
+    template <typename... Args>
+    T *grow_and_emplace_back(Args &&...aArgs) noexcept
+    {
+        const auto [data, count] = alloc_.allocate_at_least(capacity_ * 2);
+        if (!data)
+        {
+            return nullptr;
+        }
+
+        T *ptr = data + size_;
+        alloc_.construct(ptr, std::forward<Args>(aArgs)...);
+        adopt_storage(data, count);
+        ++size_;
+        return ptr;
+    }
+
+    void adopt_storage(T *aData, size_type aCapacity) noexcept
+    {
+        memory::uninitialized_relocate_n(data_, size_, aData);
+        release_storage();
+        data_ = aData;
+        capacity_ = aCapacity;
+    }
+
+    void reserve_or_abort(size_type aCapacity) noexcept
+    {
+        UTILS_ABORT_IF_REASON(!reserve(aCapacity),
+                              "failed to grow small_vector to %zu", aCapacity);
+    }
+
+    void release_storage() noexcept
+    {
+        if (!is_inline())
+        {
+            alloc_.deallocate(data_);
+            data_ = inline_data();
+            capacity_ = N;
+        }
+    }
+
+    allocator_type alloc_{};
+    T *data_{inline_data()};
+    size_type size_{};
+    size_type capacity_{N};
+    alignas(T) std::byte inline_[sizeof(T) * N];
+};
+}  // namespace utils
+
+#endif /* utils_small_vector_h */
@@ -0,0 +1,325 @@
+#ifndef utils_static_vector_h
+#define utils_static_vector_h
+
+#include <cstddef>
+#include <initializer_list>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "common.h"
+
+namespace utils
+{
+namespace details
+{
+template <typename T>
+struct is_constexpr_storable
+    : std::conjunction<std::is_trivially_copyable<T>,
+                       std::is_trivially_default_constructible<T>>
+{
+};
+
+template <typename T, std::size_t N,
+          bool IsConstexprStorable = is_constexpr_storable<T>::value>
+class static_vector_storage
+{
+   protected:
+    using size_type = uint_from_nbits_t<bits_count(N)>;
+
+    constexpr T *ptr() noexcept { return data_; }
+    constexpr const T *ptr() const noexcept { return data_; }
+
+    template <typename... Args>
+    constexpr T &construct_at(std::size_t aIndex, Args &&...aArgs) noexcept
+    {
+        data_[aIndex] = T(std::forward<Args>(aArgs)...);
+        return data_[aIndex];
+    }
+
+    constexpr void destroy_at(std::size_t) noexcept {}
+
+    constexpr void move_within(std::size_t aDst, std::size_t aSrc) noexcept
+    {
+        data_[aDst] = data_[aSrc];
+    }
+
+    T data_[N]{};
+    size_type size_{};
+};
+
+template <typename T, std::size_t N>
+class static_vector_storage<T, N, false>
+{
+   protected:
+    using size_type = uint_from_nbits_t<bits_count(N)>;
+
+    static_vector_storage() noexcept = default;
+
+    static_vector_storage(const static_vector_storage &aOther) noexcept(
+        std::is_nothrow_copy_constructible_v<T>)
+    {
+        for (; size_ < aOther.size_; ++size_)
+        {
+            new (ptr() + size_) T(aOther.ptr()[size_]);
+        }
+    }
+
+    static_vector_storage(static_vector_storage &&aOther) noexcept
+    {
+        for (; size_ < aOther.size_; ++size_)
+        {
+            new (ptr() + size_) T(std::move(aOther.ptr()[size_]));
+        }
+    }
+
+    static_vector_storage &operator=(
+        const static_vector_storage &aOther) noexcept(
+        std::is_nothrow_copy_constructible_v<T>)
+    {
+        if (this != &aOther)
+        {
+            clear();
+            for (; size_ < aOther.size_; ++size_)
+            {
+                new (ptr() + size_) T(aOther.ptr()[size_]);
+            }
+        }
+        return *this;
+    }
+
+    static_vector_storage &operator=(static_vector_storage &&aOther) noexcept
+    {
+        if (this != &aOther)
+        {
+            clear();
+            for (; size_ < aOther.size_; ++size_)
+            {
+                new (ptr() + size_) T(std::move(aOther.ptr()[size_]));
+            }
+        }
+        return *this;
+    }
+
+    ~static_vector_storage() { clear(); }
+
+    T *ptr() noexcept { return reinterpret_cast<T *>(data_); }
+    const T *ptr() const noexcept { return reinterpret_cast<const T *>(data_); }
+
+    template <typename... Args>
+    T &construct_at(std::size_t aIndex, Args &&...aArgs) noexcept
+    {
+        return *new (ptr() + aIndex) T(std::forward<Args>(aArgs)...);
+    }
+
+    void destroy_at(std::size_t aIndex) noexcept { ptr()[aIndex].~T(); }
+
+    void move_within(std::size_t aDst, std::size_t aSrc) noexcept
+    {
+        ptr()[aDst] = std::move(ptr()[aSrc]);
+    }
+
+    void clear() noexcept
+    {
+        for (; size_; --size_)
+        {
+            destroy_at(size_ - 1u);
+        }
+    }
+
+    alignas(T) std::byte data_[sizeof(T) * N];
+    size_type size_{};
+};
+}  // namespace details
+
+template <typename T, std::size_t N>
+class static_vector : private details::static_vector_storage<T, N>
+{
+    static_assert(N > 0);
+    static_assert(std::is_nothrow_move_constructible_v<T>);
+    static_assert(std::is_nothrow_destructible_v<T>);
+
+    using storage = details::static_vector_storage<T, N>;
+    using storage::ptr;
+    using storage::size_;
+
+   public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = T &;
+    using const_reference = const T &;
+    using pointer = T *;
+    using const_pointer = const T *;
+    using iterator = T *;
+    using const_iterator = const T *;
+
+    constexpr static_vector() noexcept = default;
+
+    constexpr static_vector(std::initializer_list<T> aList) noexcept(
+        std::is_nothrow_copy_constructible_v<T>)
+    {
+        UTILS_ABORT_IF_REASON(
+            aList.size() > N,
+            "initializer_list size(%zu) exceeds capacity(%zu)", aList.size(),
+            N);
+        for (const auto &v: aList)
+        {
+            this->construct_at(size_++, v);
+        }
+    }
+
+    constexpr explicit static_vector(size_type aCount) noexcept
+    {
+        resize(aCount);
+    }
+
+    template <typename... Args>
+    constexpr T &emplace_back(Args &&...aArgs) noexcept
+    {
+        static_assert(std::is_nothrow_constructible_v<T, Args...>);
+        UTILS_ABORT_IF_REASON(full(), "static_vector capacity(%zu) exceeded",
+                              N);
+        T &ref = this->construct_at(size_, std::forward<Args>(aArgs)...);
+        ++size_;
+        return ref;
+    }
+
+    template <typename... Args>
+    constexpr T *try_emplace_back(Args &&...aArgs) noexcept
+    {
+        static_assert(std::is_nothrow_constructible_v<T, Args...>);
+        if (full())
+        {
+            return nullptr;
+        }
+        T &ref = this->construct_at(size_, std::forward<Args>(aArgs)...);
+        ++size_;
+        return &ref;
+    }
+
+    constexpr T &push_back(const T &aValue) noexcept
+    {
+        return emplace_back(aValue);
+    }
+
+    constexpr T &push_back(T &&aValue) noexcept
+    {
+        return emplace_back(std::move(aValue));
+    }
+
+    constexpr void pop_back() noexcept
+    {
+        assert(size_);
+        --size_;
+        this->destroy_at(size_);
+    }
+
+    constexpr iterator erase(const_iterator aPos) noexcept
+    {
+        return erase(aPos, aPos + 1);
+    }
+
+    constexpr iterator erase(const_iterator aFirst,
+                             const_iterator aLast) noexcept
+    {
+        assert(begin() <= aFirst && aFirst <= aLast && aLast <= end());
+        const auto first = static_cast<size_type>(aFirst - begin());
+        const auto last = static_cast<size_type>(aLast - begin());
+        if (first != last)
+        {
+            size_type dst = first;
+            for (size_type src = last; src < size(); ++src, ++dst)
+            {
+                this->move_within(dst, src);
+            }
+            while (size() > dst)
+            {
+                pop_back();
+            }
+        }
+        return begin() + first;
+    }
+
+    constexpr void resize(size_type aCount) noexcept
+    {
+        UTILS_ABORT_IF_REASON(aCount > N,
+                              "requested size(%zu) exceeds capacity(%zu)",
+                              aCount, N);
+        while (size() > aCount)
+        {
+            pop_back();
+        }
+        while (size() < aCount)
+        {
+            emplace_back();
+        }
+    }
+
+    constexpr void clear() noexcept
+    {
+        while (size_)
+        {
+            pop_back();
+        }
+    }
+
+    constexpr T &operator[](size_type aIndex) noexcept
+    {
+        assert(aIndex < size());
+        return ptr()[aIndex];
+    }
+
+    constexpr const T &operator[](size_type aIndex) const noexcept
+    {
+        assert(aIndex < size());
+        return ptr()[aIndex];
+    }
+
+    constexpr T &front() noexcept { return (*this)[0]; }
+    constexpr const T &front() const noexcept { return (*this)[0]; }
+    constexpr T &back() noexcept { return (*this)[size() - 1]; }
+    constexpr const T &back() const noexcept { return (*this)[size() - 1]; }
+
+    constexpr T *data() noexcept { return ptr(); }
+    constexpr const T *data() const noexcept { return ptr(); }
+
+    constexpr iterator begin() noexcept { return ptr(); }
+    constexpr iterator end() noexcept { return ptr() + size(); }
+    constexpr const_iterator begin() const noexcept { return ptr(); }
+    constexpr const_iterator end() const noexcept { return ptr() + size(); }
+    constexpr const_iterator cbegin() const noexcept { return begin(); }
+    constexpr const_iterator cend() const noexcept { return end(); }
+
+    constexpr size_type size() const noexcept { return size_; }
+    constexpr bool empty() const noexcept { return !size_; }
+    constexpr bool full() const noexcept { return size_ == N; }
+    static constexpr size_type capacity() noexcept { return N; }
+    static constexpr size_type max_size() noexcept { return N; }
+
+    friend constexpr bool operator==(const static_vector &aLhs,
+                                     const static_vector &aRhs) noexcept
+    {
+        if (aLhs.size() != aRhs.size())
+        {
+            return false;
+        }
+        for (size_type i = 0; i < aLhs.size(); ++i)
+        {
+            if (!(aLhs[i] == aRhs[i]))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    friend constexpr bool operator!=(const static_vector &aLhs,
+                                     const static_vector &aRhs) noexcept
+    {
+        return !(aLhs == aRhs);
+    }
+};
+}  // namespace utils
+
+#endif /* utils_static_vector_h */
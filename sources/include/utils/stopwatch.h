@@ -0,0 +1,218 @@
+#ifndef utils_stopwatch_h
+#define utils_stopwatch_h
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+#include "timer.h"
+
+namespace utils
+{
+namespace details
+{
+// Accumulates the spans between resume() and pause() calls. Every span is a
+// lap; the stopwatch keeps their count, sum, minimum, maximum and the last
+// one, so nothing is stored per lap. It starts paused. The finish callback,
+// if any, is stored inline exactly as in details::timer and is invoked with
+// the stopwatch on destruction, after a running lap has been closed.
+template <std::size_t MaxCallbackAlignment, std::size_t MaxCallbackSize,
+          typename Clock>
+class stopwatch
+{
+   private:
+    using impl = timer_impl<Clock, stopwatch>;
+
+    // Unlike details::timer, callables are checked against the stopwatch
+    // rather than a duration, so generic lambdas need no return type.
+    template <typename Callable>
+    using storable_t = std::conditional_t<
+        std::is_same_v<Callable, typename impl::callback_ref_t>,
+        typename impl::callback_ptr_t,
+        std::enable_if_t<
+            std::is_invocable_r_v<void, Callable, const stopwatch &>,
+            std::remove_cv_t<std::remove_reference_t<Callable>>>>;
+
+   public:
+    static constexpr auto kMaxCallbackAlignment = MaxCallbackAlignment;
+    static constexpr auto kMaxCallbackSize = MaxCallbackSize;
+    using clock = typename impl::clock;
+    using duration = typename impl::duration;
+    using time_point = typename impl::time_point;
+
+    stopwatch() noexcept = default;
+
+    template <typename FinishCallback,
+              typename = std::enable_if_t<not std::is_same_v<
+                  stopwatch,
+                  std::remove_cv_t<std::remove_reference_t<FinishCallback>>>>>
+    stopwatch(FinishCallback &&aCallback) noexcept
+        : callback_{&impl::template call_finish_callback<
+              storable_t<FinishCallback>>}
+    {
+        using stored_callback_t = storable_t<FinishCallback>;
+        using callback_ref_t = typename impl::callback_ref_t;
+        static_assert(alignof(stored_callback_t) <= MaxCallbackAlignment);
+        static_assert(sizeof(stored_callback_t) <= MaxCallbackSize);
+        if constexpr (std::is_same_v<FinishCallback, callback_ref_t>)
+        {
+            new (&impl::template callback<stored_callback_t>(data_))
+                stored_callback_t(aCallback);
+        }
+        else
+        {
+            new (&impl::template callback<stored_callback_t>(data_))
+                stored_callback_t(std::forward<FinishCallback>(aCallback));
+        }
+    }
+
+    stopwatch(const stopwatch &) = delete;
+    stopwatch &operator=(const stopwatch &) = delete;
+
+    stopwatch(stopwatch &&aOther) noexcept
+        : resumed_(aOther.resumed_)
+        , total_(aOther.total_)
+        , min_(aOther.min_)
+        , max_(aOther.max_)
+        , last_(aOther.last_)
+        , laps_(aOther.laps_)
+        , running_(aOther.running_)
+        , callback_(std::exchange(aOther.callback_, nullptr))
+    {
+        impl::template copy<MaxCallbackSize>(data_, aOther.data_);
+    }
+
+    stopwatch &operator=(stopwatch &&aOther) noexcept
+    {
+        resumed_ = aOther.resumed_;
+        total_ = aOther.total_;
+        min_ = aOther.min_;
+        max_ = aOther.max_;
+        last_ = aOther.last_;
+        laps_ = aOther.laps_;
+        running_ = aOther.running_;
+        callback_ = std::exchange(aOther.callback_, nullptr);
+        impl::template copy<MaxCallbackSize>(data_, aOther.data_);
+        return *this;
+    }
+
+    ~stopwatch()
+    {
+        if (callback_)
+        {
+            pause();
+            std::invoke(callback_, data_, *this);
+        }
+    }
+
+    // Starts a lap; does nothing if one is running.
+    void resume() noexcept
+    {
+        if (!running_)
+        {
+            running_ = true;
+            resumed_ = clock::now();
+        }
+    }
+
+    // Ends the running lap and returns its length; zero if none was running.
+    duration pause() noexcept
+    {
+        if (!running_)
+        {
+            return duration::zero();
+        }
+        running_ = false;
+        return add_lap(clock::now() - resumed_);
+    }
+
+    // Ends the running lap and starts the next one from the same instant.
+    duration lap() noexcept
+    {
+        const time_point now = clock::now();
+        duration span = duration::zero();
+        if (running_)
+        {
+            span = add_lap(now - resumed_);
+        }
+        running_ = true;
+        resumed_ = now;
+        return span;
+    }
+
+    // Drops all laps and stops the stopwatch.
+    void reset() noexcept
+    {
+        total_ = duration::zero();
+        min_ = duration::max();
+        max_ = duration::zero();
+        last_ = duration::zero();
+        laps_ = 0;
+        running_ = false;
+    }
+
+    bool running() const noexcept { return running_; }
+
+    std::size_t laps() const noexcept { return laps_; }
+
+    // Sum of the completed laps plus the running one so far.
+    duration elapsed() const noexcept
+    {
+        return running_ ? total_ + (clock::now() - resumed_) : total_;
+    }
+
+    // Sum of the completed laps.
+    duration total() const noexcept { return total_; }
+
+    duration min_lap() const noexcept
+    {
+        return laps_ ? min_ : duration::zero();
+    }
+
+    duration max_lap() const noexcept { return max_; }
+
+    duration last_lap() const noexcept { return last_; }
+
+    duration mean_lap() const noexcept
+    {
+        return laps_ ? total_ / static_cast<typename duration::rep>(laps_)
+                     : duration::zero();
+    }
+
+   private:
+    duration add_lap(duration aSpan) noexcept
+    {
+        total_ += aSpan;
+        last_ = aSpan;
+        if (aSpan < min_)
+        {
+            min_ = aSpan;
+        }
+        if (aSpan > max_)
+        {
+            max_ = aSpan;
+        }
+        ++laps_;
+        return aSpan;
+    }
+
+    time_point resumed_{};
+    duration total_{duration::zero()};
+    duration min_{duration::max()};
+    duration max_{duration::zero()};
+    duration last_{duration::zero()};
+    std::size_t laps_{};
+    bool running_{};
+    typename impl::callback_t callback_{};
+    alignas(MaxCallbackAlignment) std::byte data_[MaxCallbackSize]{};
+};
+}  // namespace details
+
+using stopwatch =
+    details::stopwatch<alignof(void (*)(int &)), sizeof(void (*)(int &)),
+                       std::chrono::steady_clock>;
+}  // namespace utils
+
+#endif /* utils_stopwatch_h */
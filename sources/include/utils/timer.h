@@ -2,6 +2,7 @@
 #define utils_timer_h
 
 #include <chrono>
+#include <functional>
 #include <type_traits>
 #include <utility>
 
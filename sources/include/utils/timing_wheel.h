@@ -0,0 +1,409 @@
+#ifndef utils_timing_wheel_h
+#define utils_timing_wheel_h
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "common.h"
+#include "memory/allocator.h"
+
+namespace utils
+{
+namespace details
+{
+// Hierarchical timing wheel: Levels wheels of 2^SlotBits slots each, level l
+// covering deadlines up to 2^(SlotBits * (l + 1)) ticks ahead. Insert and
+// cancel are O(1); advancing visits each elapsed tick once and moves a timer
+// down at most Levels - 1 times before it fires. Deadlines further away than
+// the top level can represent wait in its last slot and are re-filed when it
+// is reached.
+//
+// Callbacks take no arguments and are stored inline in the timer node, as in
+// details::timer. Nodes come from the allocator's memory_resource and are
+// kept on a free list once released, so a warmed-up (or reserve()d) wheel
+// does not allocate.
+template <std::size_t MaxCallbackAlignment, std::size_t MaxCallbackSize,
+          typename Clock, std::size_t SlotBits = 8, std::size_t Levels = 4>
+class timing_wheel
+{
+    static_assert((SlotBits > 0) && (Levels > 0) && (SlotBits * Levels < 64));
+
+    struct link
+    {
+        link *prev;
+        link *next;
+    };
+
+    // Invokes the callback when aInvoke is set, then destroys it.
+    using finish_t = void (*)(std::byte *, bool aInvoke) noexcept;
+
+    struct node : link
+    {
+        std::uint64_t deadline{};
+        std::uint64_t generation{};
+        finish_t finish{};
+        std::uint32_t level{};
+        alignas(MaxCallbackAlignment) std::byte data[MaxCallbackSize];
+    };
+
+    template <typename Callable>
+    static void finish_callback(std::byte *aData, bool aInvoke) noexcept
+    {
+        auto &callback = *std::launder(reinterpret_cast<Callable *>(aData));
+        if (aInvoke)
+        {
+            callback();
+        }
+        callback.~Callable();
+    }
+
+   public:
+    using clock = Clock;
+    using duration = typename clock::duration;
+    using time_point = typename clock::time_point;
+    using allocator_type = memory::allocator<std::byte>;
+
+    static constexpr std::size_t kSlotBits = SlotBits;
+    static constexpr std::size_t kLevels = Levels;
+    static constexpr std::size_t kSlotCount = std::size_t{1} << SlotBits;
+    static constexpr std::uint64_t kMaxTicks = std::uint64_t{1}
+                                               << (SlotBits * Levels);
+
+    // Identifies a scheduled timer; stays safe to cancel() after the timer
+    // fired or was cancelled.
+    class handle
+    {
+       public:
+        handle() noexcept = default;
+
+        explicit operator bool() const noexcept { return node_; }
+
+       private:
+        friend class timing_wheel;
+
+        handle(node *aNode, std::uint64_t aGeneration) noexcept
+            : node_(aNode), generation_(aGeneration)
+        {
+        }
+
+        node *node_{};
+        std::uint64_t generation_{};
+    };
+
+    timing_wheel(duration aTick, time_point aStart = clock::now(),
+                 const allocator_type &aAllocator = {}) noexcept
+        : alloc_(aAllocator), start_(aStart), tick_(aTick)
+    {
+        UTILS_ABORT_IF_REASON(aTick <= duration::zero(),
+                              "timing wheel tick must be positive");
+        for (auto &slot: slots_)
+        {
+            slot.prev = slot.next = &slot;
+        }
+    }
+
+    timing_wheel(const timing_wheel &) = delete;
+    timing_wheel &operator=(const timing_wheel &) = delete;
+
+    // Pending callbacks are destroyed without being invoked.
+    ~timing_wheel()
+    {
+        for (auto &slot: slots_)
+        {
+            while (slot.next != &slot)
+            {
+                node *n = static_cast<node *>(slot.next);
+                unlink(n);
+                n->finish(n->data, false);
+                alloc_.deallocate_object(n);
+            }
+        }
+        while (free_)
+        {
+            alloc_.deallocate_object(std::exchange(free_, next_free(free_)));
+        }
+    }
+
+    // Schedules aCallback to run from the first advance() that reaches
+    // aDeadline, never earlier. Returns an empty handle if no node could be
+    // allocated.
+    template <typename Callback>
+    handle schedule_at(time_point aDeadline, Callback &&aCallback) noexcept
+    {
+        using stored_t = std::remove_cv_t<std::remove_reference_t<Callback>>;
+        static_assert(std::is_nothrow_invocable_r_v<void, stored_t &>);
+        static_assert(alignof(stored_t) <= MaxCallbackAlignment);
+        static_assert(sizeof(stored_t) <= MaxCallbackSize);
+        static_assert(std::is_nothrow_constructible_v<stored_t, Callback &&>);
+
+        node *n = acquire();
+        if (!n)
+        {
+            return {};
+        }
+        new (n->data) stored_t(std::forward<Callback>(aCallback));
+        n->finish = &finish_callback<stored_t>;
+        // Rounded up so that a timer never fires before its deadline, and
+        // never in the tick that is already being processed.
+        n->deadline = std::max(ticks_until(aDeadline), now_ + 1);
+        file(n);
+        ++size_;
+        return handle(n, n->generation);
+    }
+
+    template <typename Callback>
+    handle schedule_after(duration aDelay, Callback &&aCallback) noexcept
+    {
+        return schedule_at(now() + aDelay, std::forward<Callback>(aCallback));
+    }
+
+    // Removes a pending timer without running it. Returns false if it
+    // already fired or was cancelled.
+    bool cancel(handle &aHandle) noexcept
+    {
+        node *n = std::exchange(aHandle.node_, nullptr);
+        if (!n || (n->generation != aHandle.generation_) || !n->finish)
+        {
+            return false;
+        }
+        unlink(n);
+        --size_;
+        n->finish(n->data, false);
+        release(n);
+        return true;
+    }
+
+    // Runs every timer whose deadline is at or before aNow and returns how
+    // many ran. Callbacks may schedule and cancel timers.
+    std::size_t advance(time_point aNow = clock::now()) noexcept
+    {
+        if (aNow < start_)
+        {
+            return 0;
+        }
+        const auto target = static_cast<std::uint64_t>((aNow - start_) / tick_);
+        std::size_t fired = 0;
+        while (now_ < target)
+        {
+            if (!size_)
+            {
+                now_ = target;
+                break;
+            }
+            if (!level_sizes_[0])
+            {
+                // Nothing can fire before the next level 0 rotation.
+                now_ = std::min(target, now_ | kSlotMask);
+                if (now_ == target)
+                {
+                    break;
+                }
+            }
+            ++now_;
+            cascade();
+            fired += expire(slots_[now_ & kSlotMask]);
+        }
+        return fired;
+    }
+
+    // Pre-allocates nodes so that scheduling up to aCount timers does not
+    // touch the memory_resource. Returns false if an allocation failed.
+    bool reserve(std::size_t aCount) noexcept
+    {
+        for (std::size_t i = free_count_ + size_; i < aCount; ++i)
+        {
+            node *n = alloc_.allocate_object<node>();
+            if (!n)
+            {
+                return false;
+            }
+            new (n) node();
+            release(n);
+        }
+        return true;
+    }
+
+    std::size_t size() const noexcept { return size_; }
+
+    bool empty() const noexcept { return !size_; }
+
+    duration tick() const noexcept { return tick_; }
+
+    // Time covered by the processed ticks.
+    time_point now() const noexcept
+    {
+        return start_ + tick_ * static_cast<typename duration::rep>(now_);
+    }
+
+   private:
+    static constexpr std::uint64_t kSlotMask = kSlotCount - 1;
+    // Level of nodes moved out of their slot while being cascaded or fired.
+    static constexpr std::uint32_t kDetached = Levels;
+
+    std::uint64_t ticks_until(time_point aDeadline) const noexcept
+    {
+        if (aDeadline <= start_)
+        {
+            return 0;
+        }
+        const duration span = aDeadline - start_;
+        const auto ticks = static_cast<std::uint64_t>(span / tick_);
+        return ticks + ((span % tick_) != duration::zero());
+    }
+
+    void file(node *aNode) noexcept
+    {
+        const std::uint64_t delta =
+            std::min(aNode->deadline - now_, kMaxTicks - 1);
+        const std::uint64_t deadline = now_ + delta;
+        std::uint32_t level = 0;
+        while ((delta >> (SlotBits * (level + 1))) != 0)
+        {
+            ++level;
+        }
+        const std::size_t slot =
+            (deadline >> (SlotBits * level)) & kSlotMask;
+        link &head = slots_[(level << SlotBits) + slot];
+        aNode->prev = head.prev;
+        aNode->next = &head;
+        head.prev->next = aNode;
+        head.prev = aNode;
+        aNode->level = level;
+        ++level_sizes_[level];
+    }
+
+    void unlink(node *aNode) noexcept
+    {
+        aNode->prev->next = aNode->next;
+        aNode->next->prev = aNode->prev;
+        if (aNode->level != kDetached)
+        {
+            --level_sizes_[aNode->level];
+        }
+    }
+
+    // At a multiple of 2^(SlotBits * l) the current slot of level l holds
+    // timers due within the next 2^(SlotBits * l) ticks; re-file them, top
+    // level first so that they can keep moving down in this same tick.
+    void cascade() noexcept
+    {
+        std::size_t top = 0;
+        while ((top + 1 < Levels) &&
+               ((now_ & ((std::uint64_t{1} << (SlotBits * (top + 1))) - 1)) ==
+                0))
+        {
+            ++top;
+        }
+        for (std::size_t level = top; level > 0; --level)
+        {
+            link &head = slots_[(level << SlotBits) +
+                                ((now_ >> (SlotBits * level)) & kSlotMask)];
+            link pending;
+            take(head, pending);
+            while (pending.next != &pending)
+            {
+                node *n = static_cast<node *>(pending.next);
+                pending.next = n->next;
+                pending.next->prev = &pending;
+                file(n);
+            }
+        }
+    }
+
+    std::size_t expire(link &aSlot) noexcept
+    {
+        // Detached first, so callbacks may schedule into this same slot.
+        link pending;
+        take(aSlot, pending);
+        std::size_t fired = 0;
+        while (pending.next != &pending)
+        {
+            node *n = static_cast<node *>(pending.next);
+            pending.next = n->next;
+            pending.next->prev = &pending;
+            --size_;
+            const finish_t finish = std::exchange(n->finish, nullptr);
+            finish(n->data, true);
+            release(n);
+            ++fired;
+        }
+        return fired;
+    }
+
+    // Moves the nodes of aFrom to the empty list aTo.
+    void take(link &aFrom, link &aTo) noexcept
+    {
+        if (aFrom.next == &aFrom)
+        {
+            aTo.prev = aTo.next = &aTo;
+            return;
+        }
+        std::size_t count = 0;
+        const std::uint32_t level = static_cast<node *>(aFrom.next)->level;
+        for (link *l = aFrom.next; l != &aFrom; l = l->next)
+        {
+            static_cast<node *>(l)->level = kDetached;
+            ++count;
+        }
+        level_sizes_[level] -= count;
+        aTo.next = aFrom.next;
+        aTo.prev = aFrom.prev;
+        aTo.next->prev = &aTo;
+        aTo.prev->next = &aTo;
+        aFrom.prev = aFrom.next = &aFrom;
+    }
+
+    node *acquire() noexcept
+    {
+        if (free_)
+        {
+            --free_count_;
+            return std::exchange(free_, next_free(free_));
+        }
+        node *n = alloc_.allocate_object<node>();
+        if (n)
+        {
+            new (n) node();
+        }
+        return n;
+    }
+
+    void release(node *aNode) noexcept
+    {
+        ++aNode->generation;
+        aNode->finish = nullptr;
+        aNode->next = free_;
+        free_ = aNode;
+        ++free_count_;
+    }
+
+    static node *next_free(node *aNode) noexcept
+    {
+        return static_cast<node *>(aNode->next);
+    }
+
+    allocator_type alloc_;
+    time_point start_;
+    duration tick_;
+    std::uint64_t now_{};
+    std::size_t size_{};
+    std::size_t free_count_{};
+    node *free_{};
+    std::array<std::size_t, Levels> level_sizes_{};
+    std::array<link, (Levels << SlotBits)> slots_;
+};
+}  // namespace details
+
+// Timing wheel with pointer-sized callbacks over steady_clock.
+using timing_wheel =
+    details::timing_wheel<alignof(void *), 2 * sizeof(void *),
+                          std::chrono::steady_clock>;
+}  // namespace utils
+
+#endif /* utils_timing_wheel_h */
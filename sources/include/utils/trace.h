@@ -0,0 +1,411 @@
+#ifndef utils_trace_h
+#define utils_trace_h
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include "clocks.h"
+#include "memory/allocator.h"
+#include "ring_queue.h"
+#include "timer.h"
+
+namespace utils
+{
+// One completed zone. name must point to a string with static storage
+// duration; times are nanoseconds of the collector's clock.
+struct trace_event
+{
+    const char *name;
+    std::int64_t start_ns;
+    std::int64_t duration_ns;
+    std::uint32_t thread_id;
+    std::uint32_t depth;
+};
+
+template <typename Clock>
+class basic_trace_zone;
+
+// Collects zones recorded by any number of threads. Each thread records into
+// its own wait-free spsc_queue; drain() (or the background writer started by
+// start()) is the single consumer of all of them and turns the events into a
+// Chrome trace-event JSON file that chrome://tracing and Perfetto open.
+template <typename Clock>
+class basic_trace_collector
+{
+   public:
+    using clock = Clock;
+    using allocator_type = memory::allocator<std::byte>;
+
+    static constexpr std::size_t kDefaultCapacity = std::size_t{1} << 14;
+
+    class thread_buffer
+    {
+       public:
+        thread_buffer(std::uint32_t aId, std::size_t aCapacity,
+                      const allocator_type &aAllocator) noexcept
+            : events_(aCapacity, aAllocator)
+            , owner_(std::this_thread::get_id())
+            , id_(aId)
+        {
+        }
+
+        std::uint32_t id() const noexcept { return id_; }
+
+       private:
+        friend class basic_trace_collector;
+        friend class basic_trace_zone<Clock>;
+
+        spsc_queue<trace_event> events_;
+        thread_buffer *next_{};
+        std::thread::id owner_;
+        std::atomic<std::size_t> dropped_{};
+        std::uint32_t id_{};
+        std::uint32_t depth_{};
+    };
+
+    explicit basic_trace_collector(
+        std::size_t aPerThreadCapacity = kDefaultCapacity,
+        const allocator_type &aAllocator = {}) noexcept
+        : alloc_(aAllocator)
+        , capacity_(aPerThreadCapacity)
+        , generation_(next_generation())
+    {
+    }
+
+    basic_trace_collector(const basic_trace_collector &) = delete;
+    basic_trace_collector &operator=(const basic_trace_collector &) = delete;
+
+    // Every recording thread must be done with the collector by now.
+    ~basic_trace_collector()
+    {
+        stop();
+        thread_buffer *b = buffers_.load(std::memory_order_acquire);
+        while (b)
+        {
+            alloc_.delete_object(std::exchange(b, b->next_));
+        }
+    }
+
+    // The calling thread's buffer, registered on first use.
+    thread_buffer &local_buffer() noexcept
+    {
+        struct cache
+        {
+            std::uint64_t generation{};
+            thread_buffer *buffer{};
+        };
+        thread_local cache local;
+        if (local.generation != generation_)
+        {
+            local.buffer = find_or_register();
+            local.generation = generation_;
+        }
+        return *local.buffer;
+    }
+
+    // Pops every buffered event, passes each to aSink and returns how many
+    // there were. Concurrent calls are serialized.
+    template <typename Sink>
+    std::size_t drain(Sink &&aSink) noexcept
+    {
+        std::lock_guard lock(drain_mutex_);
+        return drain_locked(aSink);
+    }
+
+    // Writes the currently buffered events as a complete JSON document.
+    bool write_json(std::FILE *aFile) noexcept
+    {
+        std::lock_guard lock(drain_mutex_);
+        bool first = true;
+        bool ok = std::fputs("{\"traceEvents\":[", aFile) >= 0;
+        drain_locked([&](const trace_event &aEvent) noexcept
+                     { ok &= write_event(aFile, aEvent, first); });
+        return (std::fputs("\n]}\n", aFile) >= 0) && ok;
+    }
+
+    // Streams events to aPath from a background thread every aInterval until
+    // stop() is called.
+    bool start(const char *aPath,
+               std::chrono::milliseconds aInterval =
+                   std::chrono::milliseconds(100)) noexcept
+    {
+        std::lock_guard lock(drain_mutex_);
+        if (file_)
+        {
+            return false;
+        }
+        file_ = std::fopen(aPath, "w");
+        if (!file_ || (std::fputs("{\"traceEvents\":[", file_) < 0))
+        {
+            close_file();
+            return false;
+        }
+        first_ = true;
+        stopping_ = false;
+        writer_ = std::thread(
+            [this, aInterval]() noexcept
+            {
+                std::unique_lock guard(drain_mutex_);
+                while (!stopping_)
+                {
+                    wake_.wait_for(guard, aInterval);
+                    flush_to_file();
+                }
+            });
+        return true;
+    }
+
+    // Flushes whatever is left, terminates the JSON document and closes the
+    // file. Returns false if any write failed.
+    bool stop() noexcept
+    {
+        {
+            std::lock_guard lock(drain_mutex_);
+            if (!file_)
+            {
+                return true;
+            }
+            stopping_ = true;
+        }
+        wake_.notify_all();
+        writer_.join();
+
+        std::lock_guard lock(drain_mutex_);
+        flush_to_file();
+        write_ok_ &= std::fputs("\n]}\n", file_) >= 0;
+        return close_file();
+    }
+
+    // Events lost because a thread's buffer was full.
+    std::size_t dropped() const noexcept
+    {
+        std::size_t count = 0;
+        for (const thread_buffer *b = buffers_.load(std::memory_order_acquire);
+             b; b = b->next_)
+        {
+            count += b->dropped_.load(std::memory_order_relaxed);
+        }
+        return count;
+    }
+
+   private:
+    friend class basic_trace_zone<Clock>;
+
+    static std::uint64_t next_generation() noexcept
+    {
+        static std::atomic<std::uint64_t> generation{};
+        return generation.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+
+    thread_buffer *find_or_register() noexcept
+    {
+        const auto self = std::this_thread::get_id();
+        thread_buffer *head = buffers_.load(std::memory_order_acquire);
+        for (thread_buffer *b = head; b; b = b->next_)
+        {
+            // A thread id is only reused after its thread has exited.
+            if (b->owner_ == self)
+            {
+                return b;
+            }
+        }
+
+        thread_buffer *b = alloc_.new_object<thread_buffer>(
+            next_id_.fetch_add(1, std::memory_order_relaxed), capacity_,
+            alloc_);
+        UTILS_ABORT_IF_REASON(!b, "failed to allocate a trace buffer");
+        do
+        {
+            b->next_ = head;
+        } while (!buffers_.compare_exchange_weak(head, b,
+                                                 std::memory_order_release,
+                                                 std::memory_order_acquire));
+        return b;
+    }
+
+    static void record(thread_buffer &aBuffer, const char *aName,
+                       typename Clock::time_point aStart,
+                       typename Clock::duration aDuration) noexcept
+    {
+        using std::chrono::duration_cast;
+        using std::chrono::nanoseconds;
+        const trace_event event{
+            aName,
+            duration_cast<nanoseconds>(aStart.time_since_epoch()).count(),
+            duration_cast<nanoseconds>(aDuration).count(), aBuffer.id_,
+            aBuffer.depth_};
+        if (!aBuffer.events_.try_push(event))
+        {
+            aBuffer.dropped_.store(
+                aBuffer.dropped_.load(std::memory_order_relaxed) + 1,
+                std::memory_order_relaxed);
+        }
+    }
+
+    template <typename Sink>
+    std::size_t drain_locked(Sink &&aSink) noexcept
+    {
+        std::array<trace_event, 256> batch;
+        std::size_t total = 0;
+        for (thread_buffer *b = buffers_.load(std::memory_order_acquire); b;
+             b = b->next_)
+        {
+            std::size_t count = 0;
+            while ((count = b->events_.try_pop_bulk(batch.begin(),
+                                                    batch.size())) != 0)
+            {
+                for (std::size_t i = 0; i < count; ++i)
+                {
+                    aSink(batch[i]);
+                }
+                total += count;
+            }
+        }
+        return total;
+    }
+
+    void flush_to_file() noexcept
+    {
+        drain_locked([this](const trace_event &aEvent) noexcept
+                     { write_ok_ &= write_event(file_, aEvent, first_); });
+        write_ok_ &= std::fflush(file_) == 0;
+    }
+
+    bool close_file() noexcept
+    {
+        bool ok = write_ok_;
+        if (file_)
+        {
+            ok &= std::fclose(file_) == 0;
+        }
+        file_ = nullptr;
+        write_ok_ = true;
+        return ok;
+    }
+
+    static bool write_event(std::FILE *aFile, const trace_event &aEvent,
+                            bool &aFirst) noexcept
+    {
+        bool ok = std::fputs(aFirst ? "\n{\"name\":\"" : ",\n{\"name\":\"",
+                             aFile) >= 0;
+        aFirst = false;
+        for (const char *c = aEvent.name; *c; ++c)
+        {
+            if ((*c == '"') || (*c == '\\'))
+            {
+                ok &= std::fputc('\\', aFile) != EOF;
+            }
+            if (static_cast<unsigned char>(*c) < 0x20)
+            {
+                ok &= std::fprintf(aFile, "\\u%04x", *c) > 0;
+                continue;
+            }
+            ok &= std::fputc(*c, aFile) != EOF;
+        }
+        // Timestamps are in microseconds.
+        ok &= std::fprintf(aFile,
+                           "\",\"cat\":\"zone\",\"ph\":\"X\","
+                           "\"ts\":%lld.%03lld,\"dur\":%lld.%03lld,"
+                           "\"pid\":1,\"tid\":%u,\"args\":{\"depth\":%u}}",
+                           static_cast<long long>(aEvent.start_ns / 1000),
+                           static_cast<long long>(aEvent.start_ns % 1000),
+                           static_cast<long long>(aEvent.duration_ns / 1000),
+                           static_cast<long long>(aEvent.duration_ns % 1000),
+                           aEvent.thread_id, aEvent.depth) > 0;
+        return ok;
+    }
+
+    allocator_type alloc_;
+    std::size_t capacity_{};
+    std::uint64_t generation_{};
+    std::atomic<thread_buffer *> buffers_{};
+    std::atomic<std::uint32_t> next_id_{1};
+
+    std::mutex drain_mutex_;
+    std::condition_variable wake_;
+    std::thread writer_;
+    std::FILE *file_{};
+    bool first_{true};
+    bool stopping_{};
+    bool write_ok_{true};
+};
+
+// RAII zone: measured with a utils::timer over Clock and recorded into the
+// calling thread's buffer when it ends, together with its nesting depth.
+template <typename Clock>
+class basic_trace_zone
+{
+    using collector = basic_trace_collector<Clock>;
+    using thread_buffer = typename collector::thread_buffer;
+
+    struct finish
+    {
+        thread_buffer *buffer;
+        const char *name;
+
+        template <typename Timer>
+        void operator()(const Timer &aTimer) const noexcept
+        {
+            --buffer->depth_;
+            collector::record(*buffer, name, aTimer.start_tp(),
+                              aTimer.leaked());
+        }
+    };
+
+    using timer_type = details::timer<alignof(finish), sizeof(finish), Clock>;
+
+   public:
+    basic_trace_zone(collector &aCollector, const char *aName) noexcept
+        : timer_(finish{enter(aCollector), aName})
+    {
+    }
+
+    basic_trace_zone(const basic_trace_zone &) = delete;
+    basic_trace_zone &operator=(const basic_trace_zone &) = delete;
+
+   private:
+    static thread_buffer *enter(collector &aCollector) noexcept
+    {
+        thread_buffer &buffer = aCollector.local_buffer();
+        ++buffer.depth_;
+        return &buffer;
+    }
+
+    timer_type timer_;
+};
+
+using trace_collector = basic_trace_collector<tsc_clock>;
+using trace_zone = basic_trace_zone<tsc_clock>;
+
+inline trace_collector &default_trace_collector() noexcept
+{
+    static trace_collector collector;
+    return collector;
+}
+}  // namespace utils
+
+#ifndef UTILS_TRACE_ZONE
+#define UTILS_TRACE_ZONE_CONCAT_HELPER(a, b) a##b
+#define UTILS_TRACE_ZONE_CONCAT(a, b) UTILS_TRACE_ZONE_CONCAT_HELPER(a, b)
+// Name must be a string literal. Without UTILS_ENABLE_TRACING the zone, and
+// its name, compile to nothing.
+#if defined(UTILS_ENABLE_TRACING)
+#define UTILS_TRACE_ZONE(name)                                        \
+    ::utils::trace_zone UTILS_TRACE_ZONE_CONCAT(utils_trace_zone_,    \
+                                                __LINE__)(            \
+        ::utils::default_trace_collector(), "" name "")
+#else
+#define UTILS_TRACE_ZONE(name) static_cast<void>(0)
+#endif
+#else
+#error "UTILS_TRACE_ZONE already defined somewhere"
+#endif
+
+#endif /* utils_trace_h */
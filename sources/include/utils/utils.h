@@ -1,19 +1,41 @@
 #ifndef utils_h
 #define utils_h
 
+#include "benchmark.h"
+#include "bitmap.h"
+#include "clocks.h"
 #include "clz.h"
 #include "common.h"
+#include "cpu_features.h"
 #include "ctz.h"
 #include "detector.h"
 #include "fast_pimpl.h"
+#include "flat_hash_map.h"
 #include "function_traits.h"
+#include "inplace_function.h"
+#include "latency_histogram.h"
 #include "memory/allocator.h"
+#include "memory/epoch_domain.h"
+#include "memory/mapped_arena_resource.h"
 #include "memory/memory.h"
 #include "memory/monotonic_buffer_resource.h"
+#include "memory/offset_ptr.h"
+#include "memory/relocate.h"
+#include "memory/shared_memory_resource.h"
 #include "memory/simple_resource.h"
 #include "padding_checker.h"
+#include "perf_counters.h"
+#include "rank_select.h"
 #include "rel_ops_checker.h"
+#include "ring_queue.h"
+#include "simd.h"
+#include "slot_map.h"
+#include "small_vector.h"
+#include "static_vector.h"
+#include "stopwatch.h"
 #include "timer.h"
+#include "timing_wheel.h"
+#include "trace.h"
 #include "type_list.h"
 #include "value_list.h"
 
@@ -1,14 +1,156 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 #include <utils/memory/allocator.h>
+#include <utils/memory/monotonic_buffer_resource.h>
+
+#include <utility>
 
 namespace
 {
 using namespace utils::memory;
-}
+
+struct tracked
+{
+    tracked() noexcept = default;
+    tracked(const tracked &) noexcept { ++copies; }
+    tracked(tracked &&) noexcept { ++moves; }
+
+    inline static int copies = 0;
+    inline static int moves = 0;
+};
+
+struct leading_alloc
+{
+    using allocator_type = allocator<int>;
+
+    leading_alloc(std::allocator_arg_t, const allocator_type &aAlloc,
+                  int aValue) noexcept
+        : resource(aAlloc.resource()), value(aValue)
+    {
+    }
+
+    memory_resource *resource;
+    int value;
+};
+
+struct trailing_alloc
+{
+    using allocator_type = allocator<int>;
+
+    explicit trailing_alloc(const allocator_type &aAlloc) noexcept
+        : resource(aAlloc.resource())
+    {
+    }
+
+    trailing_alloc(int aValue, const allocator_type &aAlloc) noexcept
+        : resource(aAlloc.resource()), value(aValue)
+    {
+    }
+
+    memory_resource *resource;
+    int value{};
+};
+
+struct throwing_alloc
+{
+    using allocator_type = allocator<int>;
+
+    throwing_alloc(int) noexcept {}
+    throwing_alloc(std::allocator_arg_t, const allocator_type &, int) {}
+};
+}  // namespace
 
 TEST(Allocator, DefaultConstructor)
 {
     allocator<int> myallocator;
     ASSERT_EQ(myallocator.resource(), get_default_resource());
 }
+
+TEST(Allocator, AllocateAtLeast)
+{
+    allocator<std::uint32_t> a;
+    const auto result = a.allocate_at_least(3);
+    ASSERT_NE(result.ptr, nullptr);
+    ASSERT_GE(result.count, 3);
+    a.deallocate(result.ptr);
+
+    allocator<std::uint32_t> null(null_memory_resource());
+    const auto none = null.allocate_at_least(3);
+    ASSERT_EQ(none.ptr, nullptr);
+    ASSERT_EQ(none.count, 0);
+}
+
+TEST(Allocator, NewObjectForwardsArguments)
+{
+    allocator<tracked> a;
+    tracked source;
+    tracked::copies = tracked::moves = 0;
+
+    tracked *copied = a.new_object<tracked>(source);
+    ASSERT_EQ(tracked::copies, 1);
+    ASSERT_EQ(tracked::moves, 0);
+
+    tracked *moved = a.new_object<tracked>(std::move(source));
+    ASSERT_EQ(tracked::copies, 1);
+    ASSERT_EQ(tracked::moves, 1);
+
+    a.delete_object(copied);
+    a.delete_object(moved);
+}
+
+TEST(Allocator, UsesAllocatorConstruction)
+{
+    alignas(std::max_align_t) std::byte buffer[256]{};
+    monotonic_buffer_resource arena(buffer, null_memory_resource());
+    allocator<std::byte> a(&arena);
+
+    auto *leading = a.new_object<leading_alloc>(5);
+    ASSERT_EQ(leading->resource, &arena);
+    ASSERT_EQ(leading->value, 5);
+
+    auto *trailing = a.new_object<trailing_alloc>(7);
+    ASSERT_EQ(trailing->resource, &arena);
+    ASSERT_EQ(trailing->value, 7);
+
+    using pair_t = std::pair<trailing_alloc, int>;
+    auto *pair = a.new_object<pair_t>(3, 4);
+    ASSERT_EQ(pair->first.resource, &arena);
+    ASSERT_EQ(pair->first.value, 3);
+    ASSERT_EQ(pair->second, 4);
+
+    auto *piecewise = a.new_object<pair_t>(
+        std::piecewise_construct, std::forward_as_tuple(), std::make_tuple(9));
+    ASSERT_EQ(piecewise->first.resource, &arena);
+    ASSERT_EQ(piecewise->second, 9);
+}
+
+TEST(Allocator, NothrowUsesAllocatorConstruction)
+{
+    using alloc = allocator<std::byte>;
+    static_assert(is_nothrow_uses_allocator_constructible_v<int, alloc, int>);
+    static_assert(
+        is_nothrow_uses_allocator_constructible_v<leading_alloc, alloc, int>);
+    static_assert(
+        is_nothrow_uses_allocator_constructible_v<trailing_alloc, alloc>);
+    // The allocator-extended constructor is the one that runs.
+    static_assert(std::is_nothrow_constructible_v<throwing_alloc, int>);
+    static_assert(
+        !is_nothrow_uses_allocator_constructible_v<throwing_alloc, alloc, int>);
+
+    static_assert(is_nothrow_uses_allocator_constructible_v<
+                  std::pair<trailing_alloc, int>, alloc, int, int>);
+    static_assert(!is_nothrow_uses_allocator_constructible_v<
+                  std::pair<int, throwing_alloc>, alloc, int, int>);
+    static_assert(!is_nothrow_uses_allocator_constructible_v<
+                  std::pair<throwing_alloc, int>, alloc,
+                  std::piecewise_construct_t, std::tuple<int>,
+                  std::tuple<int>>);
+}
+
+TEST(Allocator, Rebind)
+{
+    allocator<int> a(null_memory_resource());
+    allocator<double> b(a);
+    ASSERT_EQ(b.resource(), null_memory_resource());
+    ASSERT_TRUE(a == b);
+}
@@ -0,0 +1,209 @@
+#include <gtest/gtest.h>
+#include <utils/benchmark.h>
+#include <utils/cartesian_product.h>
+#include <utils/common.h>
+
+#include <cstdio>
+#include <numeric>
+#include <string>
+#include <vector>
+
+namespace
+{
+namespace bench = utils::bench;
+
+bench::settings quick_settings()
+{
+    bench::settings s;
+    s.warmup = std::chrono::milliseconds(1);
+    s.min_sample_time = std::chrono::microseconds(20);
+    s.samples = 15;
+    return s;
+}
+
+std::string read_all(std::FILE *aFile)
+{
+    std::rewind(aFile);
+    std::string text;
+    for (int c = std::fgetc(aFile); c != EOF; c = std::fgetc(aFile))
+    {
+        text.push_back(static_cast<char>(c));
+    }
+    return text;
+}
+
+enum class eLayout
+{
+    kSoa = 2,
+    kAos = 5
+};
+}  // namespace
+
+TEST(Benchmark, Percentile)
+{
+    const std::vector<double> sorted{1, 2, 3, 4, 5};
+    ASSERT_DOUBLE_EQ(bench::percentile(sorted, 0), 1);
+    ASSERT_DOUBLE_EQ(bench::percentile(sorted, 50), 3);
+    ASSERT_DOUBLE_EQ(bench::percentile(sorted, 100), 5);
+    ASSERT_DOUBLE_EQ(bench::percentile(sorted, 62.5), 3.5);
+    ASSERT_DOUBLE_EQ(bench::percentile({}, 50), 0);
+}
+
+TEST(Benchmark, SummarizeRejectsOutliers)
+{
+    std::vector<double> samples{10, 11, 9, 10, 12, 8, 10, 1000, 11, 9};
+    const auto s = bench::summarize(samples, 3.5);
+    ASSERT_EQ(s.outliers, 1);
+    ASSERT_EQ(s.count, 9);
+    ASSERT_EQ(samples.size(), 9);
+    ASSERT_DOUBLE_EQ(s.min, 8);
+    ASSERT_DOUBLE_EQ(s.max, 12);
+    ASSERT_DOUBLE_EQ(s.median, 10);
+    ASSERT_DOUBLE_EQ(s.mad, 1);
+    ASSERT_DOUBLE_EQ(s.mean, 90.0 / 9);
+    ASSERT_GE(s.p99, s.p90);
+    ASSERT_GE(s.p90, s.median);
+
+    // Identical samples have no spread and nothing is rejected.
+    std::vector<double> flat(5, 3.0);
+    const auto f = bench::summarize(flat, 3.5);
+    ASSERT_EQ(f.outliers, 0);
+    ASSERT_DOUBLE_EQ(f.mad, 0);
+    ASSERT_DOUBLE_EQ(f.median, 3);
+}
+
+TEST(Benchmark, Run)
+{
+    bench::runner runner(quick_settings());
+    ASSERT_GE(runner.timer_overhead(), 0.0);
+
+    std::vector<int> data(256);
+    std::iota(data.begin(), data.end(), 0);
+    const auto &r = runner.run("sum",
+                               [&]
+                               {
+                                   int sum = 0;
+                                   for (const int v: data)
+                                   {
+                                       sum += v;
+                                   }
+                                   bench::do_not_optimize(sum);
+                               });
+    ASSERT_EQ(r.name, "sum");
+    ASSERT_GT(r.iterations, 1);
+    ASSERT_EQ(r.stats.count + r.stats.outliers, 15);
+    ASSERT_GT(r.stats.median, 0.0);
+    ASSERT_LE(r.stats.min, r.stats.median);
+    ASSERT_LE(r.stats.median, r.stats.max);
+    ASSERT_EQ(runner.results().size(), 1);
+
+    int x = 0;
+    runner.run("increment",
+               [&x]
+               {
+                   ++x;
+                   bench::clobber();
+               });
+    ASSERT_GT(x, 0);
+    ASSERT_EQ(runner.results().size(), 2);
+    runner.clear();
+    ASSERT_TRUE(runner.results().empty());
+}
+
+TEST(Benchmark, SweepValues)
+{
+    bench::runner runner(quick_settings());
+    bench::sweep<utils::values_in_range_t<1, 3>>(
+        runner, "fill",
+        [](auto aTag)
+        {
+            using params = typename decltype(aTag)::type;
+            constexpr int kSize = params::template at<0> * 8;
+            return []
+            {
+                int buffer[kSize];
+                for (int i = 0; i < kSize; ++i)
+                {
+                    buffer[i] = i;
+                }
+                bench::do_not_optimize(buffer);
+            };
+        });
+    const auto &results = runner.results();
+    ASSERT_EQ(results.size(), 3);
+    ASSERT_EQ(results[0].name, "fill/1");
+    ASSERT_EQ(results[1].name, "fill/2");
+    ASSERT_EQ(results[2].name, "fill/3");
+}
+
+TEST(Benchmark, SweepMatrix)
+{
+    using matrix = utils::cartesian_product_t<
+        utils::value_list<eLayout::kSoa, eLayout::kAos>,
+        utils::values_in_range_t<8, 16, 8>>;
+    bench::runner runner(quick_settings());
+    std::vector<int> seen;
+    bench::sweep<matrix>(runner, "layout",
+                         [&seen](auto aTag)
+                         {
+                             using params = typename decltype(aTag)::type;
+                             seen.push_back(
+                                 static_cast<int>(params::template at<0>) *
+                                 params::template at<1>);
+                             return [] { bench::clobber(); };
+                         });
+    ASSERT_EQ(seen, (std::vector<int>{16, 32, 40, 80}));
+    const auto &results = runner.results();
+    ASSERT_EQ(results.size(), 4);
+    ASSERT_EQ(results[0].name, "layout/2/8");
+    ASSERT_EQ(results[3].name, "layout/5/16");
+
+    runner.clear();
+    bench::sweep<utils::type_list<int, double>>(
+        runner, "types",
+        [](auto aTag)
+        {
+            using T = typename decltype(aTag)::type;
+            return []
+            {
+                T value{};
+                bench::do_not_optimize(value);
+            };
+        });
+    ASSERT_EQ(runner.results()[0].name, "types/0");
+    ASSERT_EQ(runner.results()[1].name, "types/1");
+}
+
+TEST(Benchmark, Reports)
+{
+    std::vector<bench::result> results(2);
+    results[0].name = "plain";
+    results[0].iterations = 64;
+    results[0].stats.count = 10;
+    results[0].stats.median = 1.5;
+    results[1].name = "with,comma \"quoted\"";
+
+    std::FILE *csv = std::tmpfile();
+    ASSERT_NE(csv, nullptr);
+    ASSERT_TRUE(bench::write_csv(csv, results));
+    const std::string csvText = read_all(csv);
+    std::fclose(csv);
+    ASSERT_EQ(csvText.rfind("name,iterations,samples,outliers,median_ns", 0),
+              0);
+    ASSERT_NE(csvText.find("\nplain,64,10,0,1.5,"), std::string::npos);
+    ASSERT_NE(csvText.find("\n\"with,comma \"\"quoted\"\"\",0,"),
+              std::string::npos);
+
+    std::FILE *json = std::tmpfile();
+    ASSERT_NE(json, nullptr);
+    ASSERT_TRUE(bench::write_json(json, results));
+    const std::string jsonText = read_all(json);
+    std::fclose(json);
+    ASSERT_EQ(jsonText.rfind("{\"benchmarks\":[\n{\"name\":\"plain\"", 0), 0);
+    ASSERT_NE(jsonText.find("\"iterations\":64,\"samples\":10"),
+              std::string::npos);
+    ASSERT_NE(jsonText.find("\"median_ns\":1.5"), std::string::npos);
+    ASSERT_NE(jsonText.find("\"with,comma \\\"quoted\\\"\""),
+              std::string::npos);
+    ASSERT_EQ(jsonText.substr(jsonText.size() - 4), "\n]}\n");
+}
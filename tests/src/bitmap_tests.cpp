@@ -0,0 +1,227 @@
+#include <gtest/gtest.h>
+#include <utils/bitmap.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace
+{
+namespace bm = utils::bitmap;
+
+struct reference
+{
+    std::vector<bool> bits;
+
+    std::size_t find_next(bool aValue, std::size_t aFrom) const
+    {
+        for (std::size_t i = aFrom; i < bits.size(); ++i)
+        {
+            if (bits[i] == aValue)
+            {
+                return i;
+            }
+        }
+        return bits.size();
+    }
+
+    std::size_t find_clear_run(std::size_t aCount, std::size_t aFrom) const
+    {
+        if (aCount == 0)
+        {
+            return std::min(aFrom, bits.size());
+        }
+        std::size_t run = 0;
+        for (std::size_t i = aFrom; i < bits.size(); ++i)
+        {
+            run = bits[i] ? 0 : run + 1;
+            if (run == aCount)
+            {
+                return i + 1 - aCount;
+            }
+        }
+        return bits.size();
+    }
+
+    std::size_t count(std::size_t aFirst, std::size_t aLast) const
+    {
+        std::size_t result = 0;
+        for (std::size_t i = aFirst; i < aLast; ++i)
+        {
+            result += bits[i];
+        }
+        return result;
+    }
+};
+
+// Sparse or dense regions make whole blocks skippable.
+void fill_random(std::vector<std::uint64_t> &aWords, reference &aRef,
+                 std::size_t aSize, std::mt19937_64 &aRng)
+{
+    aRef.bits.assign(aSize, false);
+    aWords.assign(bm::word_count(aSize), 0);
+    std::size_t i = 0;
+    while (i < aSize)
+    {
+        const std::size_t length = std::min<std::size_t>(aSize - i,
+                                                         aRng() % 2000 + 1);
+        const unsigned density = static_cast<unsigned>(aRng() % 5);
+        for (std::size_t j = i; j < i + length; ++j)
+        {
+            bool value = false;
+            switch (density)
+            {
+                case 0:
+                    break;
+                case 1:
+                    value = aRng() % 500 == 0;
+                    break;
+                case 2:
+                    value = aRng() % 2;
+                    break;
+                case 3:
+                    value = aRng() % 500 != 0;
+                    break;
+                default:
+                    value = true;
+            }
+            aRef.bits[j] = value;
+            if (value)
+            {
+                bm::set(aWords.data(), j);
+            }
+        }
+        i += length;
+    }
+    // Bits past the end must be ignored.
+    if (aSize % bm::kWordBits)
+    {
+        aWords.back() ^= ~std::uint64_t{} << (aSize % bm::kWordBits);
+    }
+}
+}  // namespace
+
+TEST(Bitmap, SingleBits)
+{
+    std::uint64_t words[2]{};
+    bm::set(words, 0);
+    bm::set(words, 64);
+    bm::set(words, 127);
+    ASSERT_EQ(words[0], 1u);
+    ASSERT_EQ(words[1], 0x8000000000000001ull);
+    ASSERT_TRUE(bm::test(words, 127));
+    bm::reset(words, 127);
+    ASSERT_FALSE(bm::test(words, 127));
+    ASSERT_EQ(bm::find_first_set(words, 128), 0);
+    ASSERT_EQ(bm::find_next_set(words, 128, 1), 64);
+    ASSERT_EQ(bm::find_next_set(words, 64, 1), 64);
+    ASSERT_EQ(bm::find_first_clear(words, 128), 1);
+    ASSERT_EQ(bm::find_next_set(words, 128, 128), 128);
+    ASSERT_EQ(bm::find_clear_run(words, 128, 63), 1);
+    ASSERT_EQ(bm::find_clear_run(words, 128, 64), 128);
+    ASSERT_EQ(bm::find_clear_run(words, 128, 63, 2), 65);
+    ASSERT_EQ(bm::count_set(words, 0, 128), 2);
+    static_assert(bm::word_count(0) == 0);
+    static_assert(bm::word_count(65) == 2);
+}
+
+TEST(Bitmap, MatchesReference)
+{
+    std::mt19937_64 rng(42);
+    std::vector<std::uint64_t> words;
+    reference ref;
+    for (const std::size_t size:
+         {std::size_t{1}, std::size_t{63}, std::size_t{64}, std::size_t{65},
+          std::size_t{511}, std::size_t{512}, std::size_t{4097},
+          std::size_t{100000}})
+    {
+        for (int round = 0; round < 4; ++round)
+        {
+            fill_random(words, ref, size, rng);
+            const std::uint64_t *w = words.data();
+            for (std::size_t from = 0; from <= size;
+                 from += 1 + rng() % (size / 64 + 1))
+            {
+                ASSERT_EQ(bm::find_next_set(w, size, from),
+                          ref.find_next(true, from))
+                    << size << " " << from;
+                ASSERT_EQ(bm::find_next_clear(w, size, from),
+                          ref.find_next(false, from))
+                    << size << " " << from;
+                const std::size_t count = rng() % 300;
+                ASSERT_EQ(bm::find_clear_run(w, size, count, from),
+                          ref.find_clear_run(count, from))
+                    << size << " " << from << " " << count;
+                const std::size_t last = from + rng() % (size - from + 1);
+                ASSERT_EQ(bm::count_set(w, from, last), ref.count(from, last))
+                    << size << " " << from << " " << last;
+            }
+            ASSERT_EQ(bm::find_first_set(w, size), ref.find_next(true, 0));
+            ASSERT_EQ(bm::find_first_clear(w, size), ref.find_next(false, 0));
+        }
+    }
+}
+
+TEST(Bitmap, Ranges)
+{
+    std::mt19937_64 rng(7);
+    constexpr std::size_t kSize = 3000;
+    std::vector<std::uint64_t> words(bm::word_count(kSize));
+    std::vector<bool> ref(kSize);
+    for (int round = 0; round < 2000; ++round)
+    {
+        std::size_t first = rng() % (kSize + 1);
+        std::size_t last = rng() % (kSize + 1);
+        if (first > last)
+        {
+            std::swap(first, last);
+        }
+        const bool value = rng() % 2;
+        if (value)
+        {
+            bm::set_range(words.data(), first, last);
+        }
+        else
+        {
+            bm::clear_range(words.data(), first, last);
+        }
+        for (std::size_t i = first; i < last; ++i)
+        {
+            ref[i] = value;
+        }
+        if (round % 100 == 0)
+        {
+            for (std::size_t i = 0; i < kSize; ++i)
+            {
+                ASSERT_EQ(bm::test(words.data(), i), ref[i]) << i;
+            }
+        }
+    }
+    bm::set_range(words.data(), 0, kSize);
+    ASSERT_EQ(bm::count_set(words.data(), 0, kSize), kSize);
+    ASSERT_EQ(bm::find_first_clear(words.data(), kSize), kSize);
+    bm::clear_range(words.data(), 1000, 1200);
+    ASSERT_EQ(bm::find_first_clear(words.data(), kSize), 1000);
+    ASSERT_EQ(bm::find_clear_run(words.data(), kSize, 200), 1000);
+    ASSERT_EQ(bm::find_clear_run(words.data(), kSize, 201), kSize);
+    ASSERT_EQ(bm::count_set(words.data(), 0, kSize), kSize - 200);
+}
+
+TEST(Bitmap, Large)
+{
+    // A mostly full occupancy map: the scans skip whole blocks.
+    constexpr std::size_t kSize = std::size_t{1} << 24;
+    std::vector<std::uint64_t> words(bm::word_count(kSize));
+    bm::set_range(words.data(), 0, kSize);
+    bm::reset(words.data(), kSize - 5);
+    bm::clear_range(words.data(), kSize / 2, kSize / 2 + 100);
+    ASSERT_EQ(bm::find_first_clear(words.data(), kSize), kSize / 2);
+    ASSERT_EQ(bm::find_next_clear(words.data(), kSize, kSize / 2 + 100),
+              kSize - 5);
+    ASSERT_EQ(bm::find_clear_run(words.data(), kSize, 100), kSize / 2);
+    ASSERT_EQ(bm::count_set(words.data(), 0, kSize), kSize - 101);
+    std::printf("popcount kernel: %s\n",
+                bm::details::popcount_words().name().data());
+}
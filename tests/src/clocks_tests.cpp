@@ -0,0 +1,133 @@
+#include <gtest/gtest.h>
+#include <utils/clocks.h>
+
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+namespace
+{
+using namespace std::chrono_literals;
+
+template <typename Clock>
+void check_clock_requirements()
+{
+    static_assert(Clock::is_steady);
+    static_assert(std::is_same_v<typename Clock::duration,
+                                 std::chrono::nanoseconds>);
+    static_assert(std::is_same_v<typename Clock::time_point,
+                                 std::chrono::time_point<Clock>>);
+    static_assert(noexcept(Clock::now()));
+}
+
+template <typename Clock>
+double ns_per_call(std::size_t aCalls) noexcept
+{
+    const auto start = std::chrono::steady_clock::now();
+    typename Clock::duration::rep sink = 0;
+    for (std::size_t i = 0; i < aCalls; ++i)
+    {
+        sink += Clock::now().time_since_epoch().count();
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    [[maybe_unused]] volatile auto keep = sink;
+    return static_cast<double>(
+               std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed)
+                   .count()) /
+           static_cast<double>(aCalls);
+}
+}  // namespace
+
+TEST(Clocks, Requirements)
+{
+    check_clock_requirements<utils::tsc_clock>();
+    check_clock_requirements<utils::tscp_clock>();
+    check_clock_requirements<utils::coarse_steady_clock>();
+}
+
+TEST(Clocks, TscIsMonotonic)
+{
+    auto prev = utils::tsc_clock::now();
+    for (int i = 0; i < 100000; ++i)
+    {
+        const auto next = utils::tsc_clock::now();
+        ASSERT_LE(prev, next);
+        prev = next;
+    }
+}
+
+TEST(Clocks, TscTracksSteadyClock)
+{
+    // Calibration must not land inside the measured interval.
+    ASSERT_EQ(utils::calibrate_tsc_clock(), utils::tscp_clock::uses_tsc());
+    const auto steady_start = std::chrono::steady_clock::now();
+    const auto tsc_start = utils::tscp_clock::now();
+    std::this_thread::sleep_for(50ms);
+    const auto tsc_elapsed = utils::tscp_clock::now() - tsc_start;
+    const auto steady_elapsed = std::chrono::steady_clock::now() - steady_start;
+
+    const auto diff = std::chrono::abs(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(steady_elapsed) -
+        tsc_elapsed);
+    ASSERT_LT(diff, 2ms);
+
+    // Shares steady_clock's epoch.
+    const auto offset = std::chrono::abs(
+        utils::tsc_clock::now().time_since_epoch() -
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()));
+    ASSERT_LT(offset, 2ms);
+
+    if (utils::tsc_clock::uses_tsc())
+    {
+        ASSERT_GT(utils::tsc_clock::frequency_hz(), 1e8);
+    }
+    else
+    {
+        ASSERT_EQ(utils::tsc_clock::frequency_hz(), 0.0);
+    }
+}
+
+TEST(Clocks, Coarse)
+{
+    const auto resolution = utils::coarse_steady_clock::resolution();
+    ASSERT_GT(resolution.count(), 0);
+
+    const auto start = utils::coarse_steady_clock::now();
+    std::this_thread::sleep_for(20ms);
+    const auto elapsed = utils::coarse_steady_clock::now() - start;
+    ASSERT_GE(elapsed + resolution, 20ms);
+}
+
+TEST(Clocks, Timers)
+{
+    std::chrono::nanoseconds measured{};
+    {
+        utils::tsc_timer t(
+            [&measured](const utils::tsc_timer &aTimer) noexcept
+            { measured = aTimer.leaked_nano_sec(); });
+        std::this_thread::sleep_for(5ms);
+    }
+    ASSERT_GE(measured, 5ms);
+
+    utils::coarse_timer t([](const utils::coarse_timer &) noexcept {});
+    ASSERT_GE(t.leaked().count(), 0);
+}
+
+// Not a correctness check: reports what one now() costs with each clock.
+TEST(Clocks, PerCallCost)
+{
+    constexpr std::size_t kCalls = 1 << 20;
+    const double steady = ns_per_call<std::chrono::steady_clock>(kCalls);
+    const double tsc = ns_per_call<utils::tsc_clock>(kCalls);
+    const double tscp = ns_per_call<utils::tscp_clock>(kCalls);
+    const double coarse = ns_per_call<utils::coarse_steady_clock>(kCalls);
+    std::printf(
+        "ns per now(): steady_clock %.2f, tsc_clock %.2f, tscp_clock %.2f, "
+        "coarse_steady_clock %.2f\n",
+        steady, tsc, tscp, coarse);
+    RecordProperty("steady_clock_ns", std::to_string(steady));
+    RecordProperty("tsc_clock_ns", std::to_string(tsc));
+    RecordProperty("tscp_clock_ns", std::to_string(tscp));
+    RecordProperty("coarse_steady_clock_ns", std::to_string(coarse));
+}
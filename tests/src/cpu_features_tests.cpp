@@ -0,0 +1,174 @@
+#include <gtest/gtest.h>
+#include <utils/cpu_features.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+using utils::cpu_feature;
+using utils::cpu_features;
+
+std::size_t popcount_portable(const std::uint64_t *aWords,
+                              std::size_t aCount) noexcept
+{
+    std::size_t result = 0;
+    for (std::size_t i = 0; i < aCount; ++i)
+    {
+        for (std::uint64_t w = aWords[i]; w; w &= w - 1)
+        {
+            ++result;
+        }
+    }
+    return result;
+}
+
+#ifdef UTILS_CPU_X86
+UTILS_TARGET("popcnt")
+std::size_t popcount_popcnt(const std::uint64_t *aWords,
+                            std::size_t aCount) noexcept
+{
+    std::size_t result = 0;
+    for (std::size_t i = 0; i < aCount; ++i)
+    {
+        result += static_cast<std::size_t>(__builtin_popcountll(aWords[i]));
+    }
+    return result;
+}
+#endif
+
+using popcount_fn = std::size_t(const std::uint64_t *, std::size_t) noexcept;
+
+const utils::dispatched<popcount_fn> popcount{
+#ifdef UTILS_CPU_X86
+    {&popcount_popcnt, {cpu_feature::kPopcnt}, "popcnt"},
+#endif
+    {&popcount_portable, {}, "portable"}};
+}  // namespace
+
+TEST(CpuFeatures, Set)
+{
+    constexpr cpu_features avx2{cpu_feature::kAvx, cpu_feature::kAvx2};
+    static_assert(avx2.has(cpu_feature::kAvx2));
+    static_assert(not avx2.has(cpu_feature::kSse2));
+    static_assert(avx2.has_all({cpu_feature::kAvx}));
+    static_assert(avx2.has_all({}));
+    static_assert(not avx2.has_all({cpu_feature::kAvx, cpu_feature::kBmi2}));
+    static_assert((avx2 | cpu_features{cpu_feature::kBmi2})
+                      .has_all({cpu_feature::kAvx2, cpu_feature::kBmi2}));
+    static_assert((avx2 & cpu_features{cpu_feature::kAvx}) ==
+                  cpu_features{cpu_feature::kAvx});
+    static_assert(cpu_features{}.empty());
+    static_assert(utils::cpu_feature_name(cpu_feature::kSse41) == "sse4.1");
+    static_assert(utils::cpu_feature_name(cpu_feature::kAvx512vl) ==
+                  "avx512vl");
+
+    cpu_features f;
+    f.set(cpu_feature::kBmi1).set(cpu_feature::kLzcnt);
+    f.reset(cpu_feature::kBmi1);
+    ASSERT_EQ(f, cpu_features{cpu_feature::kLzcnt});
+}
+
+TEST(CpuFeatures, Host)
+{
+    const cpu_features &host = utils::host_cpu_features();
+    ASSERT_EQ(&host, &utils::host_cpu_features());
+    ASSERT_EQ(host, cpu_features::detect());
+    std::printf("cpu features:");
+    for (std::size_t i = 0; i < utils::kCpuFeatureCount; ++i)
+    {
+        const auto feature = static_cast<cpu_feature>(i);
+        if (host.has(feature))
+        {
+            std::printf(" %s", utils::cpu_feature_name(feature).data());
+        }
+    }
+    std::printf("\n");
+
+#if defined(__x86_64__) || defined(_M_X64)
+    ASSERT_TRUE(host.has(cpu_feature::kSse2));
+#endif
+    // Wider extensions imply the state their predecessors need.
+    if (host.has(cpu_feature::kAvx2))
+    {
+        ASSERT_TRUE(host.has(cpu_feature::kAvx));
+    }
+    if (host.has(cpu_feature::kAvx512f))
+    {
+        ASSERT_TRUE(host.has(cpu_feature::kAvx2));
+    }
+
+#if defined(UTILS_CPU_X86) && defined(__GNUC__)
+    __builtin_cpu_init();
+    ASSERT_EQ(host.has(cpu_feature::kSse42),
+              static_cast<bool>(__builtin_cpu_supports("sse4.2")));
+    ASSERT_EQ(host.has(cpu_feature::kPopcnt),
+              static_cast<bool>(__builtin_cpu_supports("popcnt")));
+    ASSERT_EQ(host.has(cpu_feature::kAvx2),
+              static_cast<bool>(__builtin_cpu_supports("avx2")));
+    ASSERT_EQ(host.has(cpu_feature::kBmi2),
+              static_cast<bool>(__builtin_cpu_supports("bmi2")));
+    ASSERT_EQ(host.has(cpu_feature::kAvx512f),
+              static_cast<bool>(__builtin_cpu_supports("avx512f")));
+#endif
+#ifndef UTILS_CPU_X86
+    ASSERT_TRUE(host.empty());
+#endif
+}
+
+TEST(CpuFeatures, SelectKernel)
+{
+    using fn = int() noexcept;
+    auto best = []() noexcept { return 3; };
+    auto middle = []() noexcept { return 2; };
+    auto baseline = []() noexcept { return 1; };
+    const std::initializer_list<utils::kernel_variant<fn>> variants = {
+        {+best, {cpu_feature::kAvx512f, cpu_feature::kAvx512bw}, "avx512"},
+        {+middle, {cpu_feature::kAvx2, cpu_feature::kBmi2}, "avx2"},
+        {+baseline, {}, "baseline"}};
+
+    const cpu_features avx512{cpu_feature::kAvx2, cpu_feature::kBmi2,
+                              cpu_feature::kAvx512f, cpu_feature::kAvx512bw};
+    ASSERT_EQ(utils::select_kernel(variants, avx512).name, "avx512");
+    const cpu_features noBmi2{cpu_feature::kAvx2, cpu_feature::kAvx512f};
+    ASSERT_EQ(utils::select_kernel(variants, noBmi2).name, "baseline");
+    ASSERT_EQ(utils::select_kernel(variants, noBmi2 | cpu_features{
+                                                          cpu_feature::kBmi2})
+                  .name,
+              "avx2");
+
+    const utils::dispatched<fn> kernel(variants, {cpu_feature::kAvx2,
+                                                  cpu_feature::kBmi2});
+    ASSERT_EQ(kernel.name(), "avx2");
+    ASSERT_EQ(kernel(), 2);
+    ASSERT_EQ(kernel.get(), +middle);
+    static_assert(noexcept(kernel()));
+
+    ASSERT_EQ(utils::select_kernel<fn>({{+best, {cpu_feature::kAvx512f}, ""}},
+                                       cpu_features{})
+                  .function,
+              nullptr);
+}
+
+TEST(CpuFeatures, Dispatch)
+{
+    std::vector<std::uint64_t> words(1000);
+    std::uint64_t x = 0x9E3779B97F4A7C15ull;
+    for (auto &w: words)
+    {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        w = x;
+    }
+    std::printf("popcount kernel: %s\n", popcount.name().data());
+#ifdef UTILS_CPU_X86
+    ASSERT_EQ(popcount.name(),
+              utils::host_cpu_features().has(cpu_feature::kPopcnt)
+                  ? "popcnt"
+                  : "portable");
+#endif
+    ASSERT_EQ(popcount(words.data(), words.size()),
+              popcount_portable(words.data(), words.size()));
+}
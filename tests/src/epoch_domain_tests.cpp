@@ -0,0 +1,158 @@
+#include <gtest/gtest.h>
+#include <utils/memory/epoch_domain.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace
+{
+using utils::memory::epoch_domain;
+
+struct node
+{
+    explicit node(int aValue) noexcept : value(aValue) { ++alive; }
+    ~node()
+    {
+        value = -1;
+        --alive;
+    }
+
+    int value;
+    inline static std::atomic<int> alive = 0;
+};
+
+node *make_node(int aValue) noexcept
+{
+    auto *r = utils::memory::get_default_resource();
+    return new (r->allocate<node>()) node(aValue);
+}
+}  // namespace
+
+TEST(EpochDomain, Attach)
+{
+    epoch_domain domain(2);
+    auto a = domain.attach();
+    auto b = domain.attach();
+    ASSERT_TRUE(a);
+    ASSERT_TRUE(b);
+    ASSERT_FALSE(domain.attach());
+
+    b.detach();
+    ASSERT_FALSE(b);
+    auto c = domain.attach();
+    ASSERT_TRUE(c);
+}
+
+TEST(EpochDomain, PinnedReaderBlocksReclamation)
+{
+    auto *r = utils::memory::get_default_resource();
+    epoch_domain domain;
+    auto reader = domain.attach();
+    auto writer = domain.attach();
+
+    {
+        auto g = reader.pin();
+        writer.retire(make_node(1), r);
+        ASSERT_EQ(writer.pending(), 1);
+        for (int i = 0; i < 4; ++i)
+        {
+            ASSERT_EQ(writer.collect(), 0);
+        }
+        ASSERT_EQ(node::alive, 1);
+    }
+
+    writer.collect();
+    writer.collect();
+    ASSERT_EQ(writer.pending(), 0);
+    ASSERT_EQ(node::alive, 0);
+}
+
+TEST(EpochDomain, NestedPins)
+{
+    epoch_domain domain;
+    auto reader = domain.attach();
+    auto outer = reader.pin();
+    {
+        auto inner = reader.pin();
+    }
+    const auto epoch = domain.epoch();
+    domain.try_advance();
+    ASSERT_FALSE(domain.try_advance());
+    ASSERT_EQ(domain.epoch(), epoch + 1);
+    outer.release();
+    ASSERT_TRUE(domain.try_advance());
+}
+
+TEST(EpochDomain, BatchesRetiredBlocks)
+{
+    auto *r = utils::memory::get_default_resource();
+    epoch_domain domain;
+    auto writer = domain.attach();
+    for (std::size_t i = 0; i < 3 * epoch_domain::kCollectThreshold; ++i)
+    {
+        writer.retire(make_node(static_cast<int>(i)), r);
+    }
+    ASSERT_LT(writer.pending(), 2 * epoch_domain::kCollectThreshold);
+    ASSERT_EQ(node::alive, static_cast<int>(writer.pending()));
+
+    void *raw = r->allocate(32);
+    writer.retire_bytes(raw, r);
+}
+
+TEST(EpochDomain, DestructorFreesPending)
+{
+    auto *r = utils::memory::get_default_resource();
+    {
+        epoch_domain domain;
+        auto writer = domain.attach();
+        auto g = writer.pin();
+        writer.retire(make_node(3), r);
+        writer.retire(make_node(4), r);
+        ASSERT_EQ(node::alive, 2);
+    }
+    ASSERT_EQ(node::alive, 0);
+}
+
+TEST(EpochDomain, ConcurrentReaders)
+{
+    auto *r = utils::memory::get_default_resource();
+    epoch_domain domain;
+    std::atomic<node *> shared{make_node(0)};
+    std::atomic<bool> done{false};
+    std::atomic<bool> failed{false};
+
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 3; ++t)
+    {
+        readers.emplace_back(
+            [&]
+            {
+                auto self = domain.attach();
+                while (!done.load())
+                {
+                    auto g = self.pin();
+                    const node *n = shared.load(std::memory_order_acquire);
+                    if (n->value < 0)
+                    {
+                        failed = true;
+                    }
+                }
+            });
+    }
+
+    auto writer = domain.attach();
+    for (int i = 1; i <= 20000; ++i)
+    {
+        node *old = shared.exchange(make_node(i), std::memory_order_acq_rel);
+        writer.retire(old, r);
+    }
+    done = true;
+    for (auto &t: readers)
+    {
+        t.join();
+    }
+    writer.retire(shared.load(), r);
+
+    ASSERT_FALSE(failed.load());
+}
@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 #include <utils/fast_pimpl.h>
+#include <utils/memory/monotonic_buffer_resource.h>
 
 struct my_type
 {
@@ -13,3 +14,103 @@ TEST(FastPimpl, DefaultConstructor)
     utils::fast_pimpl<my_type, sizeof(my_type), alignof(my_type)> k;
 }
 //  TODO: right unit tests
+
+namespace
+{
+struct small_type
+{
+    small_type() noexcept = default;
+    small_type(char aC, int aI) noexcept : c(aC), i(aI) {}
+    char c{};
+    int i{};
+};
+
+struct big_type
+{
+    big_type() noexcept = default;
+    big_type(int aValue) noexcept : values{aValue} {}
+    int values[64]{};
+};
+
+template <typename T>
+using flex_pimpl = utils::flex_pimpl<T, 32, 8>;
+}  // namespace
+
+TEST(FlexPimpl, InlineWhenFits)
+{
+    static_assert(flex_pimpl<small_type>::is_inline());
+    static_assert(not flex_pimpl<big_type>::is_inline());
+    static_assert(utils::is_pimpl_inline_v<my_type, 32, 8>);
+    static_assert(not utils::is_pimpl_inline_v<big_type, 32, 8>);
+    static_assert(sizeof(flex_pimpl<small_type>) == 32);
+    static_assert(sizeof(flex_pimpl<big_type>) == 32);
+}
+
+TEST(FlexPimpl, InlineValue)
+{
+    flex_pimpl<small_type> p(utils::forwarding_constructor{}, 'a', 2);
+    ASSERT_TRUE(p.has_value());
+    ASSERT_EQ(p->c, 'a');
+    ASSERT_EQ(p->i, 2);
+    ASSERT_GE(static_cast<void *>(&p.get()), static_cast<void *>(&p));
+    ASSERT_LT(static_cast<void *>(&p.get()), static_cast<void *>(&p + 1));
+
+    flex_pimpl<small_type> copy(p);
+    ASSERT_EQ(copy->i, 2);
+}
+
+TEST(FlexPimpl, SpillsToResource)
+{
+    alignas(std::max_align_t) std::byte buffer[1024]{};
+    utils::memory::monotonic_buffer_resource resource(
+        buffer, utils::memory::null_memory_resource());
+
+    flex_pimpl<big_type> p(&resource, utils::forwarding_constructor{}, 7);
+    ASSERT_TRUE(p.has_value());
+    ASSERT_EQ(p.resource(), &resource);
+    ASSERT_EQ(p->values[0], 7);
+    ASSERT_EQ(static_cast<void *>(&p.get()), static_cast<void *>(buffer));
+
+    flex_pimpl<big_type> copy(p);
+    ASSERT_EQ(copy.resource(), &resource);
+    ASSERT_EQ(copy->values[0], 7);
+    ASSERT_NE(&copy.get(), &p.get());
+}
+
+TEST(FlexPimpl, SpilledMoveStealsPointer)
+{
+    flex_pimpl<big_type> p(utils::forwarding_constructor{}, 3);
+    big_type *ptr = &p.get();
+
+    flex_pimpl<big_type> moved(std::move(p));
+    ASSERT_FALSE(p.has_value());
+    ASSERT_EQ(&moved.get(), ptr);
+
+    flex_pimpl<big_type> other(utils::forwarding_constructor{}, 4);
+    other = std::move(moved);
+    ASSERT_EQ(&other.get(), ptr);
+    ASSERT_EQ(other->values[0], 3);
+}
+
+TEST(FlexPimpl, AssignsIntoMovedFrom)
+{
+    flex_pimpl<big_type> p(utils::forwarding_constructor{}, 3);
+    flex_pimpl<big_type> moved(std::move(p));
+    ASSERT_FALSE(p.has_value());
+
+    p = moved;
+    ASSERT_TRUE(p.has_value());
+    ASSERT_EQ(p->values[0], 3);
+    ASSERT_NE(&p.get(), &moved.get());
+
+    flex_pimpl<big_type> again(std::move(moved));
+    big_type value{};
+    value.values[0] = 5;
+    moved = value;
+    ASSERT_EQ(moved->values[0], 5);
+
+    flex_pimpl<big_type> last(std::move(again));
+    again = std::move(value);
+    ASSERT_EQ(again->values[0], 5);
+    ASSERT_EQ(again.resource(), utils::memory::get_default_resource());
+}
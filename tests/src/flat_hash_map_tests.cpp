@@ -0,0 +1,227 @@
+#include <gtest/gtest.h>
+#include <utils/flat_hash_map.h>
+#include <utils/memory/monotonic_buffer_resource.h>
+#include <utils/small_vector.h>
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+struct string_hash
+{
+    using is_transparent = void;
+    std::size_t operator()(std::string_view aValue) const noexcept
+    {
+        return std::hash<std::string_view>{}(aValue);
+    }
+};
+
+struct string_eq
+{
+    using is_transparent = void;
+    bool operator()(std::string_view aLhs,
+                    std::string_view aRhs) const noexcept
+    {
+        return aLhs == aRhs;
+    }
+};
+}  // namespace
+
+TEST(FlatHashMap, Empty)
+{
+    utils::flat_hash_map<int, int> map;
+    ASSERT_TRUE(map.empty());
+    ASSERT_EQ(map.capacity(), 0);
+    ASSERT_EQ(map.begin(), map.end());
+    ASSERT_EQ(map.find(1), map.end());
+    ASSERT_FALSE(map.contains(1));
+    ASSERT_EQ(map.erase(1), 0);
+}
+
+TEST(FlatHashMap, InsertFindErase)
+{
+    utils::flat_hash_map<int, int> map;
+    for (int i = 0; i < 1000; ++i)
+    {
+        const auto [it, inserted] = map.insert({i, i * 2});
+        ASSERT_TRUE(inserted);
+        ASSERT_EQ(it->second, i * 2);
+    }
+    ASSERT_EQ(map.size(), 1000);
+    ASSERT_FALSE(map.insert({5, 0}).second);
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        const auto it = map.find(i);
+        ASSERT_NE(it, map.end());
+        ASSERT_EQ(it->second, i * 2);
+    }
+    for (int i = 0; i < 1000; i += 2)
+    {
+        ASSERT_EQ(map.erase(i), 1);
+    }
+    ASSERT_EQ(map.size(), 500);
+    for (int i = 0; i < 1000; ++i)
+    {
+        ASSERT_EQ(map.contains(i), i % 2 == 1);
+    }
+
+    long sum = 0;
+    for (const auto &[k, v]: map)
+    {
+        ASSERT_EQ(v, k * 2);
+        sum += k;
+    }
+    ASSERT_EQ(sum, 250000);
+}
+
+TEST(FlatHashMap, MatchesUnorderedMapUnderChurn)
+{
+    utils::flat_hash_map<unsigned, unsigned> map;
+    std::unordered_map<unsigned, unsigned> reference;
+    unsigned state = 12345;
+    for (int i = 0; i < 20000; ++i)
+    {
+        state = state * 1103515245u + 12345u;
+        const unsigned key = (state >> 8) % 512;
+        if (state & 1)
+        {
+            map[key] = state;
+            reference[key] = state;
+        }
+        else
+        {
+            ASSERT_EQ(map.erase(key), reference.erase(key));
+        }
+        ASSERT_EQ(map.size(), reference.size());
+    }
+    for (const auto &[k, v]: reference)
+    {
+        ASSERT_EQ(map[k], v);
+    }
+    ASSERT_LE(map.capacity(), 2048);
+}
+
+TEST(FlatHashMap, HeterogeneousLookup)
+{
+    utils::flat_hash_map<std::string, int, string_hash, string_eq> map;
+    map.try_emplace("one", 1);
+    map.try_emplace("two", 2);
+    const std::string_view key = "two";
+    ASSERT_EQ(map.find(key)->second, 2);
+    ASSERT_TRUE(map.contains(std::string_view("one")));
+    ASSERT_EQ(map.erase(std::string_view("one")), 1);
+    ASSERT_FALSE(map.contains(std::string_view("one")));
+}
+
+TEST(FlatHashMap, ReserveAndRehash)
+{
+    utils::flat_hash_map<int, int> map;
+    ASSERT_TRUE(map.reserve(100));
+    const auto capacity = map.capacity();
+    ASSERT_GE(capacity * 7 / 8, 100);
+    for (int i = 0; i < 100; ++i)
+    {
+        map[i] = i;
+    }
+    ASSERT_EQ(map.capacity(), capacity);
+    ASSERT_TRUE(map.rehash(1000));
+    ASSERT_GT(map.capacity(), capacity);
+    ASSERT_EQ(map[42], 42);
+}
+
+TEST(FlatHashMap, AllocatesThroughResource)
+{
+    alignas(std::max_align_t) std::byte buffer[2048]{};
+    utils::memory::monotonic_buffer_resource resource(
+        buffer, utils::memory::null_memory_resource());
+    utils::flat_hash_map<int, int> map(&resource);
+    ASSERT_TRUE(map.reserve(10));
+    map[1] = 1;
+    ASSERT_EQ(static_cast<void *>(&*map.begin()) >= static_cast<void *>(buffer),
+              true);
+    ASSERT_FALSE(map.reserve(10000));
+    ASSERT_EQ(map[1], 1);
+}
+
+TEST(FlatHashMap, NonTrivialValues)
+{
+    utils::flat_hash_map<int, std::unique_ptr<int>> map;
+    for (int i = 0; i < 100; ++i)
+    {
+        map.try_emplace(i, new int(i));
+    }
+    auto copyless = std::move(map);
+    ASSERT_TRUE(map.empty());
+    ASSERT_EQ(*copyless.find(50)->second, 50);
+}
+
+TEST(FlatHashMap, MovesKeysOnRehash)
+{
+    // Move-only keys can only get through a rehash by being moved.
+    utils::flat_hash_map<std::unique_ptr<int>, int> map;
+    std::vector<const int *> keys;
+    for (int i = 0; i < 100; ++i)
+    {
+        auto key = std::make_unique<int>(i);
+        keys.push_back(key.get());
+        ASSERT_TRUE(map.try_emplace(std::move(key), i).second);
+    }
+    ASSERT_EQ(map.size(), 100);
+    for (const auto &[key, value]: map)
+    {
+        ASSERT_EQ(*key, value);
+        ASSERT_EQ(key.get(), keys[static_cast<std::size_t>(value)]);
+    }
+
+    utils::flat_hash_map<std::string, int> strings;
+    for (int i = 0; i < 100; ++i)
+    {
+        strings.try_emplace(std::string(40, 'a') + std::to_string(i), i);
+    }
+    ASSERT_EQ(strings.find(std::string(40, 'a') + "42")->second, 42);
+}
+
+TEST(FlatHashSet, Basic)
+{
+    utils::flat_hash_set<std::string> set;
+    ASSERT_TRUE(set.insert("a").second);
+    ASSERT_FALSE(set.insert("a").second);
+    ASSERT_TRUE(set.insert("b").second);
+    ASSERT_EQ(set.size(), 2);
+    auto copy = set;
+    ASSERT_TRUE(copy.contains("b"));
+    copy.erase(copy.find("b"));
+    ASSERT_FALSE(copy.contains("b"));
+    ASSERT_TRUE(set.contains("b"));
+}
+
+TEST(FlatHashMap, NestedContainersShareResource)
+{
+    alignas(std::max_align_t) std::byte buffer[4096]{};
+    utils::memory::monotonic_buffer_resource resource(
+        buffer, utils::memory::null_memory_resource());
+    using values = utils::small_vector<int, 1>;
+    utils::flat_hash_map<int, values> map(&resource);
+
+    for (int i = 0; i < 8; ++i)
+    {
+        auto &v = map[i];
+        v.push_back(i);
+        v.push_back(i + 1);
+    }
+    for (const auto &[key, v]: map)
+    {
+        ASSERT_EQ(v.get_allocator().resource(), &resource);
+        ASSERT_EQ(v[1], key + 1);
+    }
+
+    const std::pair<const int, values> entry{42, values{1, 2, 3}};
+    auto [it, inserted] = map.insert(entry);
+    ASSERT_TRUE(inserted);
+    ASSERT_EQ(it->second.get_allocator().resource(), &resource);
+}
@@ -0,0 +1,184 @@
+#include <gtest/gtest.h>
+#include <utils/inplace_function.h>
+
+#include <array>
+#include <memory>
+#include <string>
+
+namespace
+{
+int twice(int aValue) noexcept { return 2 * aValue; }
+
+struct counted
+{
+    static inline int alive = 0;
+    int value;
+
+    explicit counted(int aValue) noexcept : value(aValue) { ++alive; }
+    counted(const counted &aOther) noexcept : value(aOther.value) { ++alive; }
+    counted(counted &&aOther) noexcept : value(aOther.value) { ++alive; }
+    ~counted() { --alive; }
+
+    int operator()(int aValue) const noexcept { return value + aValue; }
+};
+
+struct mutating
+{
+    int calls = 0;
+    int operator()() noexcept { return ++calls; }
+};
+
+template <typename Function, typename Callable, typename = void>
+struct is_assignable_from : std::false_type
+{
+};
+
+template <typename Function, typename Callable>
+struct is_assignable_from<
+    Function, Callable,
+    std::void_t<decltype(std::declval<Function &>() =
+                             std::declval<Callable>())>> : std::true_type
+{
+};
+}  // namespace
+
+TEST(InplaceFunction, Traits)
+{
+    using function = utils::inplace_function<int(int) noexcept>;
+    static_assert(sizeof(function) <= 4 * sizeof(void *) + 16);
+    static_assert(std::is_nothrow_move_constructible_v<function>);
+    static_assert(std::is_nothrow_invocable_r_v<int, const function &, int>);
+    static_assert(
+        not std::is_nothrow_invocable_v<const utils::inplace_function<void()>>);
+
+    // The signature is checked, noexcept included.
+    auto throwing = [](int aValue) { return aValue; };
+    static_assert(not std::is_constructible_v<function, decltype(throwing)>);
+    static_assert(std::is_constructible_v<utils::inplace_function<int(int)>,
+                                          decltype(throwing)>);
+    static_assert(not std::is_constructible_v<function, std::string>);
+    static_assert(std::is_constructible_v<function, decltype(&twice)>);
+
+    // const signatures require a const call operator.
+    static_assert(
+        not std::is_constructible_v<utils::inplace_function<int() const>,
+                                    mutating>);
+    static_assert(
+        std::is_constructible_v<utils::inplace_function<int()>, mutating>);
+    static_assert(not is_assignable_from<function, void (*)()>::value);
+}
+
+TEST(InplaceFunction, Call)
+{
+    utils::inplace_function<int(int) noexcept> f;
+    ASSERT_FALSE(f);
+    ASSERT_TRUE(f == nullptr);
+
+    f = twice;
+    ASSERT_TRUE(f);
+    ASSERT_EQ(f(21), 42);
+
+    int offset = 5;
+    f = [&offset](int aValue) noexcept { return aValue + offset; };
+    offset = 6;
+    ASSERT_EQ(f(1), 7);
+
+    int (*null)(int) noexcept = nullptr;
+    f = null;
+    ASSERT_FALSE(f);
+
+    utils::inplace_function<int()> m = mutating{};
+    ASSERT_EQ(m(), 1);
+    ASSERT_EQ(m(), 2);
+    const auto copy = m;
+    ASSERT_EQ(copy(), 3);
+    ASSERT_EQ(m(), 3);
+
+    utils::inplace_function<std::string(const std::string &, std::size_t)>
+        repeat = [](const std::string &aText, std::size_t aTimes)
+    {
+        std::string result;
+        for (std::size_t i = 0; i < aTimes; ++i)
+        {
+            result += aText;
+        }
+        return result;
+    };
+    ASSERT_EQ(repeat("ab", 3), "ababab");
+}
+
+TEST(InplaceFunction, Lifetime)
+{
+    using function = utils::inplace_function<int(int) const noexcept>;
+    {
+        function f = counted(10);
+        ASSERT_EQ(counted::alive, 1);
+        function g = f;
+        ASSERT_EQ(counted::alive, 2);
+        function h = std::move(f);
+        ASSERT_EQ(counted::alive, 2);
+        ASSERT_FALSE(f);
+        ASSERT_EQ(h(1), 11);
+
+        g = counted(20);
+        ASSERT_EQ(counted::alive, 2);
+        swap(g, h);
+        ASSERT_EQ(g(1), 11);
+        ASSERT_EQ(h(1), 21);
+
+        h = nullptr;
+        ASSERT_EQ(counted::alive, 1);
+
+        // A smaller function converts into a larger one.
+        utils::inplace_function<int(int) const noexcept, sizeof(counted)>
+            small = counted(30);
+        function large = small;
+        ASSERT_EQ(counted::alive, 3);
+        function moved = std::move(small);
+        ASSERT_EQ(counted::alive, 3);
+        ASSERT_EQ(large(0), 30);
+        ASSERT_EQ(moved(0), 30);
+    }
+    ASSERT_EQ(counted::alive, 0);
+}
+
+TEST(InplaceFunction, Capacity)
+{
+    std::array<char, 48> big{};
+    big[0] = 'x';
+    auto lambda = [big]() noexcept { return big[0]; };
+    utils::inplace_function<char() noexcept, sizeof(lambda)> f = lambda;
+    ASSERT_EQ(f(), 'x');
+    static_assert(sizeof(f) >= sizeof(lambda) + sizeof(void *));
+}
+
+TEST(FunctionRef, Call)
+{
+    static_assert(std::is_trivially_copyable_v<utils::function_ref<void()>>);
+    static_assert(sizeof(utils::function_ref<void()>) == 2 * sizeof(void *));
+
+    auto apply = [](utils::function_ref<int(int) noexcept> aF, int aValue)
+    { return aF(aValue); };
+    ASSERT_EQ(apply(twice, 4), 8);
+    ASSERT_EQ(apply(&twice, 5), 10);
+    int offset = 100;
+    ASSERT_EQ(apply([&offset](int aValue) noexcept { return aValue + offset; },
+                    1),
+              101);
+
+    mutating m;
+    utils::function_ref<int()> ref = m;
+    ref();
+    ref();
+    ASSERT_EQ(m.calls, 2);
+
+    const counted c(7);
+    utils::function_ref<int(int) const noexcept> constRef = c;
+    ASSERT_EQ(constRef(1), 8);
+    utils::function_ref<int(int) const noexcept> copy = constRef;
+    ASSERT_EQ(copy(2), 9);
+
+    static_assert(
+        not std::is_constructible_v<utils::function_ref<int(int) noexcept>,
+                                    int (*)(int)>);
+}
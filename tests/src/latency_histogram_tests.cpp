@@ -0,0 +1,184 @@
+#include <gtest/gtest.h>
+#include <utils/latency_histogram.h>
+#include <utils/timer.h>
+
+#include <limits>
+#include <thread>
+#include <vector>
+
+namespace
+{
+using histogram = utils::latency_histogram<5>;
+using group = utils::latency_histogram_group<5>;
+}  // namespace
+
+TEST(LatencyHistogram, FixedFootprint)
+{
+    static_assert(histogram::kBucketCount == 61 * 16);
+    static_assert(sizeof(histogram) <
+                  (histogram::kBucketCount + 8) * sizeof(std::uint64_t));
+}
+
+TEST(LatencyHistogram, BucketsAreContiguous)
+{
+    ASSERT_EQ(histogram::bucket_lower(0), 0);
+    for (std::size_t i = 0; i + 1 < histogram::kBucketCount; ++i)
+    {
+        ASSERT_EQ(histogram::bucket_upper(i) + 1,
+                  histogram::bucket_lower(i + 1));
+        ASSERT_EQ(histogram::bucket_index(histogram::bucket_lower(i)), i);
+        ASSERT_EQ(histogram::bucket_index(histogram::bucket_upper(i)), i);
+    }
+    ASSERT_EQ(
+        histogram::bucket_index(std::numeric_limits<std::uint64_t>::max()),
+        histogram::kBucketCount - 1);
+}
+
+TEST(LatencyHistogram, RelativeError)
+{
+    for (std::uint64_t v = 1; v < (std::uint64_t{1} << 62); v = v * 3 + 1)
+    {
+        const std::size_t i = histogram::bucket_index(v);
+        const auto lower = histogram::bucket_lower(i);
+        const auto upper = histogram::bucket_upper(i);
+        ASSERT_LE(lower, v);
+        ASSERT_GE(upper, v);
+        ASSERT_LE(static_cast<double>(upper - lower),
+                  static_cast<double>(lower) / histogram::kSubBucketCount);
+    }
+}
+
+TEST(LatencyHistogram, Percentiles)
+{
+    histogram h;
+    ASSERT_TRUE(h.empty());
+    ASSERT_EQ(h.value_at_percentile(50), 0);
+    ASSERT_EQ(h.min(), 0);
+
+    for (std::uint64_t v = 1; v <= 10000; ++v)
+    {
+        h.record(v);
+    }
+    ASSERT_EQ(h.count(), 10000);
+    ASSERT_EQ(h.min(), 1);
+    ASSERT_EQ(h.max(), 10000);
+    ASSERT_DOUBLE_EQ(h.mean(), 5000.5);
+    ASSERT_EQ(h.value_at_percentile(0), 1);
+    ASSERT_EQ(h.value_at_percentile(100), 10000);
+    ASSERT_NEAR(static_cast<double>(h.value_at_percentile(50)), 5000.0,
+                5000.0 / 16);
+    ASSERT_NEAR(static_cast<double>(h.value_at_percentile(99)), 9900.0,
+                9900.0 / 16);
+    ASSERT_GE(h.value_at_percentile(99.9), h.value_at_percentile(99));
+}
+
+TEST(LatencyHistogram, DurationsAndCounts)
+{
+    histogram h;
+    h.record(std::chrono::microseconds(3));
+    h.record(std::chrono::nanoseconds(-5));
+    h.record(7, 3);
+    ASSERT_EQ(h.count(), 5);
+    ASSERT_EQ(h.count_at(histogram::bucket_index(7)), 3);
+    ASSERT_EQ(h.count_at(0), 1);
+    ASSERT_EQ(h.min(), 0);
+    ASSERT_EQ(h.max(), 3000);
+}
+
+TEST(LatencyHistogram, MergeAndCopy)
+{
+    histogram a;
+    histogram b;
+    for (std::uint64_t v = 0; v < 100; ++v)
+    {
+        a.record(v);
+        b.record(v + 1000);
+    }
+    a.merge(b);
+    ASSERT_EQ(a.count(), 200);
+    ASSERT_EQ(a.min(), 0);
+    ASSERT_EQ(a.max(), 1099);
+
+    histogram c = a;
+    ASSERT_EQ(c.count(), 200);
+    ASSERT_EQ(c.value_at_percentile(50), a.value_at_percentile(50));
+    c = b;
+    ASSERT_EQ(c.count(), 100);
+    ASSERT_EQ(c.min(), 1000);
+
+    c.reset();
+    ASSERT_TRUE(c.empty());
+    ASSERT_EQ(c.max(), 0);
+}
+
+TEST(LatencyHistogram, TimerSink)
+{
+    histogram h;
+    {
+        utils::timer t(h.sink());
+    }
+    {
+        utils::timer t(h.sink());
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    ASSERT_EQ(h.count(), 2);
+    ASSERT_GE(h.max(), 1'000'000);
+}
+
+TEST(LatencyHistogramGroup, PerThread)
+{
+    constexpr int kThreads = 4;
+    constexpr std::uint64_t kValues = 10000;
+    group g(kThreads);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t)
+    {
+        threads.emplace_back(
+            [&g, t]
+            {
+                auto handle = g.attach();
+                ASSERT_TRUE(handle);
+                for (std::uint64_t v = 0; v < kValues; ++v)
+                {
+                    handle.record(v * (t + 1));
+                }
+            });
+    }
+
+    // Snapshots may be taken while recording is in progress.
+    const auto partial = g.snapshot();
+    ASSERT_LE(partial.count(), kThreads * kValues);
+
+    for (auto &t: threads)
+    {
+        t.join();
+    }
+    const auto total = g.snapshot();
+    ASSERT_EQ(total.count(), kThreads * kValues);
+    ASSERT_EQ(total.max(), (kValues - 1) * kThreads);
+}
+
+TEST(LatencyHistogramGroup, AttachLimit)
+{
+    group g(2);
+    ASSERT_EQ(g.max_threads(), 2);
+    auto first = g.attach();
+    auto second = g.attach();
+    ASSERT_TRUE(first);
+    ASSERT_TRUE(second);
+    ASSERT_FALSE(g.attach());
+
+    first.record(10);
+    first.detach();
+    auto third = g.attach();
+    ASSERT_TRUE(third);
+    {
+        utils::timer t(third.sink());
+    }
+    const auto total = g.snapshot();
+    ASSERT_EQ(total.count(), 2);
+
+    g.reset();
+    ASSERT_TRUE(g.snapshot().empty());
+}
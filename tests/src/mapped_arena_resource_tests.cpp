@@ -0,0 +1,192 @@
+#include <gtest/gtest.h>
+#include <utils/memory/mapped_arena_resource.h>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+namespace
+{
+class MappedArenaResource : public ::testing::Test
+{
+   protected:
+    using mapped_arena_resource = utils::memory::mapped_arena_resource;
+
+    ~MappedArenaResource() override { std::remove(path_.c_str()); }
+
+    struct node
+    {
+        int value;
+        std::uint32_t next;
+    };
+
+    const std::string path_ =
+        ::testing::TempDir() + "utils_mapped_arena_" +
+        ::testing::UnitTest::GetInstance()->current_test_info()->name();
+};
+}  // namespace
+
+TEST_F(MappedArenaResource, Create)
+{
+    std::error_code ec;
+    mapped_arena_resource arena(path_.c_str(), 4096, nullptr, ec);
+    ASSERT_FALSE(ec);
+    ASSERT_TRUE(arena);
+    ASSERT_TRUE(arena.writable());
+    ASSERT_FALSE(arena.relocated());
+    ASSERT_EQ(arena.size(), 4096);
+    ASSERT_EQ(arena.used(), 0);
+    ASSERT_EQ(arena.root(), nullptr);
+}
+
+TEST_F(MappedArenaResource, Allocate)
+{
+    std::error_code ec;
+    mapped_arena_resource arena(path_.c_str(), 256, nullptr, ec);
+    ASSERT_FALSE(ec);
+
+    void *first = arena.allocate(3, 1);
+    ASSERT_EQ(first, arena.data());
+    void *second = arena.allocate(8, 8);
+    ASSERT_TRUE(second);
+    ASSERT_TRUE(utils::is_aligned(second, 8));
+    ASSERT_GT(second, first);
+    ASSERT_TRUE(arena.contains(second));
+    // allocate() is an exact bump: only the alignment gap is skipped.
+    ASSERT_EQ(second, arena.data() + 8);
+    ASSERT_EQ(arena.allocate(3, 1), arena.data() + 16);
+    ASSERT_EQ(arena.used(), 19);
+
+    const auto rest = arena.allocate_at_least(1, 1);
+    ASSERT_TRUE(rest.ptr);
+    ASSERT_EQ(rest.ptr, arena.data() + 19);
+    ASSERT_TRUE(utils::is_aligned(arena.data() + 19 + rest.count,
+                                  alignof(std::max_align_t)));
+
+    ASSERT_EQ(arena.allocate(arena.size()), nullptr);
+    arena.deallocate(first);
+
+    arena.release();
+    ASSERT_EQ(arena.used(), 0);
+    ASSERT_EQ(arena.allocate(arena.size(), 1), arena.data());
+    ASSERT_EQ(arena.allocate(1, 1), nullptr);
+}
+
+TEST_F(MappedArenaResource, SnapshotAndRestore)
+{
+    const void *base = nullptr;
+    std::size_t used = 0;
+    {
+        std::error_code ec;
+        mapped_arena_resource arena(path_.c_str(), 1 << 16, nullptr, ec);
+        ASSERT_FALSE(ec);
+
+        auto *nodes = static_cast<node *>(
+            arena.allocate(sizeof(node) * 16, alignof(node)));
+        ASSERT_TRUE(nodes);
+        for (int i = 0; i < 16; ++i)
+        {
+            nodes[i] = {i * i, static_cast<std::uint32_t>(i + 1)};
+        }
+        arena.set_root(nodes);
+        ASSERT_EQ(arena.root_as<node>(), nodes);
+        ASSERT_FALSE(arena.snapshot());
+
+        base = arena.data();
+        used = arena.used();
+    }
+
+    std::error_code ec;
+    mapped_arena_resource arena(path_.c_str(),
+                                mapped_arena_resource::access::read_write,
+                                false, ec);
+    ASSERT_FALSE(ec);
+    ASSERT_EQ(arena.used(), used);
+    if (!arena.relocated())
+    {
+        ASSERT_EQ(arena.data(), base);
+    }
+
+    const node *nodes = arena.root_as<node>();
+    ASSERT_TRUE(nodes);
+    for (int i = 0; i < 16; ++i)
+    {
+        ASSERT_EQ(nodes[i].value, i * i);
+        ASSERT_EQ(nodes[i].next, static_cast<std::uint32_t>(i + 1));
+    }
+
+    void *more = arena.allocate(16);
+    ASSERT_TRUE(more);
+    ASSERT_GE(static_cast<const std::byte *>(more),
+              reinterpret_cast<const std::byte *>(nodes + 16));
+}
+
+TEST_F(MappedArenaResource, ReadOnly)
+{
+    {
+        std::error_code ec;
+        mapped_arena_resource arena(path_.c_str(), 1024, nullptr, ec);
+        ASSERT_FALSE(ec);
+        char *text = static_cast<char *>(arena.allocate(6, 1));
+        std::memcpy(text, "hello", 6);
+        arena.set_root(text);
+    }
+
+    std::error_code ec;
+    mapped_arena_resource arena(
+        path_.c_str(), mapped_arena_resource::access::read_only, false, ec);
+    ASSERT_FALSE(ec);
+    ASSERT_FALSE(arena.writable());
+    ASSERT_STREQ(arena.root_as<const char>(), "hello");
+    ASSERT_EQ(arena.allocate(1), nullptr);
+    ASSERT_FALSE(arena.snapshot());
+}
+
+TEST_F(MappedArenaResource, FixedBase)
+{
+    const void *base = nullptr;
+    {
+        std::error_code ec;
+        mapped_arena_resource arena(path_.c_str(), 1024, nullptr, ec);
+        ASSERT_FALSE(ec);
+        base = arena.data();
+    }
+
+    std::error_code ec;
+    mapped_arena_resource arena(
+        path_.c_str(), mapped_arena_resource::access::read_only, true, ec);
+    if (ec)
+    {
+        ASSERT_EQ(ec, std::errc::address_in_use);
+        ASSERT_FALSE(arena);
+    }
+    else
+    {
+        ASSERT_FALSE(arena.relocated());
+        ASSERT_EQ(arena.data(), base);
+    }
+}
+
+TEST_F(MappedArenaResource, InvalidFile)
+{
+    std::FILE *file = std::fopen(path_.c_str(), "wb");
+    ASSERT_TRUE(file);
+    std::fputs("not an arena, just some bytes that are long enough", file);
+    std::fclose(file);
+
+    std::error_code ec;
+    mapped_arena_resource arena(
+        path_.c_str(), mapped_arena_resource::access::read_only, false, ec);
+    ASSERT_EQ(ec, std::errc::invalid_argument);
+    ASSERT_FALSE(arena);
+    ASSERT_EQ(arena.allocate(1), nullptr);
+}
+
+TEST_F(MappedArenaResource, MissingFile)
+{
+    std::error_code ec;
+    mapped_arena_resource arena(
+        path_.c_str(), mapped_arena_resource::access::read_only, false, ec);
+    ASSERT_EQ(ec, std::errc::no_such_file_or_directory);
+    ASSERT_FALSE(arena);
+}
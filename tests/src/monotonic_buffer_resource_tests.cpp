@@ -22,3 +22,32 @@ using MonotonicBufferResource = monotonic_buffer_resource_test<16, 256>;
 }  // namespace
 
 TEST_F(MonotonicBufferResource, Construct) { ASSERT_TRUE(true); }
+
+TEST_F(MonotonicBufferResource, AllocateAtLeast)
+{
+    const auto first = resource.allocate_at_least(3, 1);
+    ASSERT_EQ(first.ptr, data_);
+    ASSERT_EQ(first.count, alignof(std::max_align_t));
+
+    const auto second = resource.allocate_at_least(3, 1);
+    ASSERT_EQ(second.ptr, data_ + first.count);
+
+    const auto tail = resource.allocate_at_least(
+        sizeof(data_) - first.count - second.count, 1);
+    ASSERT_EQ(tail.ptr, data_ + first.count + second.count);
+    ASSERT_EQ(tail.count, sizeof(data_) - first.count - second.count);
+
+    const auto spilled = resource.allocate_at_least(8);
+    ASSERT_NE(spilled.ptr, nullptr);
+    ASSERT_GE(spilled.count, 8);
+    utils::memory::get_default_resource()->deallocate(spilled.ptr);
+}
+
+TEST_F(MonotonicBufferResource, AllocateIsExact)
+{
+    auto *const first = static_cast<std::byte *>(resource.allocate(3, 1));
+    auto *const second = static_cast<std::byte *>(resource.allocate(3, 1));
+    ASSERT_EQ(first, data_);
+    ASSERT_EQ(second, data_ + 3);
+    ASSERT_EQ(resource.allocate(4, 4), data_ + 8);
+}
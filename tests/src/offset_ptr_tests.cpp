@@ -0,0 +1,216 @@
+#include <gtest/gtest.h>
+#include <utils/memory/allocator.h>
+#include <utils/memory/monotonic_buffer_resource.h>
+#include <utils/memory/offset_ptr.h>
+#include <utils/small_vector.h>
+
+#include <cstring>
+#include <memory>
+#include <type_traits>
+
+namespace
+{
+using namespace utils::memory;
+
+struct offset_node
+{
+    int value;
+    offset_ptr<offset_node> next;
+};
+
+struct arena_tag;
+using test_arena = arena_base<arena_tag>;
+
+struct arena_node
+{
+    int value;
+    arena_ptr<arena_node, test_arena> next;
+};
+
+struct raw_node
+{
+    int value;
+    raw_node *next;
+};
+
+template <typename Node>
+Node *make_list(allocator<Node> &aAllocator, int aCount) noexcept
+{
+    Node *head = nullptr;
+    for (int i = aCount; i > 0; --i)
+    {
+        Node *node = aAllocator.allocate(1);
+        node->value = i;
+        node->next = head;
+        head = node;
+    }
+    return head;
+}
+
+template <typename Node>
+int sum_list(const Node *aHead) noexcept
+{
+    int sum = 0;
+    for (; aHead; aHead = aHead->next.get())
+    {
+        sum += aHead->value;
+    }
+    return sum;
+}
+}  // namespace
+
+TEST(OffsetPtr, Basics)
+{
+    int values[4] = {1, 2, 3, 4};
+    offset_ptr<int> null;
+    ASSERT_FALSE(null);
+    ASSERT_EQ(null.get(), nullptr);
+    ASSERT_EQ(null, nullptr);
+
+    offset_ptr<int> p = values;
+    ASSERT_TRUE(p);
+    ASSERT_EQ(*p, 1);
+    ASSERT_EQ(p[2], 3);
+    ASSERT_EQ((p + 3).get(), values + 3);
+    ++p;
+    ASSERT_EQ(*p, 2);
+    ASSERT_EQ(p - offset_ptr<int>(values), 1);
+    ASSERT_TRUE(offset_ptr<int>(values) < p);
+
+    offset_ptr<const int> c = p;
+    ASSERT_EQ(c.get(), values + 1);
+    ASSERT_EQ(offset_ptr<int>::pointer_to(values[3]).get(), values + 3);
+
+    p = nullptr;
+    ASSERT_FALSE(p);
+}
+
+TEST(OffsetPtr, CopyRecomputesOffset)
+{
+    int value = 7;
+    auto first = std::make_unique<offset_ptr<int>>(&value);
+    auto second = std::make_unique<offset_ptr<int>>(*first);
+    ASSERT_EQ(second->get(), &value);
+    *second = *first;
+    ASSERT_EQ(second->get(), &value);
+}
+
+TEST(OffsetPtr, PointerTraits)
+{
+    using traits = std::pointer_traits<offset_ptr<int>>;
+    static_assert(std::is_same_v<traits::element_type, int>);
+    static_assert(std::is_same_v<traits::rebind<long>, offset_ptr<long>>);
+    static_assert(!utils::is_trivially_relocatable_v<offset_ptr<int>>);
+    static_assert(
+        std::is_same_v<std::pointer_traits<arena_ptr<int, test_arena>>::
+                           rebind<long>,
+                       arena_ptr<long, test_arena>>);
+}
+
+TEST(OffsetPtr, VoidPointers)
+{
+    using void_ptr = std::pointer_traits<offset_ptr<int>>::rebind<void>;
+    using const_void_ptr =
+        std::pointer_traits<offset_ptr<int>>::rebind<const void>;
+    static_assert(std::is_same_v<void_ptr, offset_ptr<void>>);
+    static_assert(
+        std::is_same_v<std::pointer_traits<void_ptr>::element_type, void>);
+
+    int value = 3;
+    const offset_ptr<int> typed = std::pointer_traits<
+        offset_ptr<int>>::pointer_to(value);
+    const void_ptr untyped = typed;
+    const const_void_ptr constant = untyped;
+    ASSERT_EQ(untyped.get(), &value);
+    ASSERT_EQ(constant.get(), &value);
+    ASSERT_FALSE(void_ptr());
+}
+
+TEST(ArenaPtr, VoidPointers)
+{
+    using int_ptr = arena_ptr<int, test_arena>;
+    using void_ptr = std::pointer_traits<int_ptr>::rebind<void>;
+    using const_void_ptr = std::pointer_traits<int_ptr>::rebind<const void>;
+    static_assert(std::is_same_v<void_ptr, arena_ptr<void, test_arena>>);
+    static_assert(void_ptr::kGranularity == 1);
+    static_assert(const_void_ptr::kGranularity == 1);
+
+    alignas(int) std::byte buffer[64]{};
+    test_arena::bind(buffer);
+    int *value = reinterpret_cast<int *>(buffer + 2 * sizeof(int));
+    const int_ptr typed = std::pointer_traits<int_ptr>::pointer_to(*value);
+    const void_ptr untyped = typed;
+    const const_void_ptr constant = untyped;
+    ASSERT_EQ(typed.index(), 3);
+    ASSERT_EQ(untyped.index(), 2 * sizeof(int) + 1);
+    ASSERT_EQ(untyped.get(), value);
+    ASSERT_EQ(constant.get(), value);
+    ASSERT_EQ(void_ptr(buffer + 5).index(), 6);
+    test_arena::bind(nullptr);
+}
+
+TEST(OffsetPtr, PositionIndependent)
+{
+    alignas(std::max_align_t) std::byte first[1024]{};
+    alignas(std::max_align_t) std::byte second[1024]{};
+    monotonic_buffer_resource resource(first, sizeof(first), nullptr);
+    allocator<offset_node> alloc(&resource);
+
+    const offset_node *head = make_list(alloc, 10);
+    ASSERT_EQ(sum_list(head), 55);
+
+    std::memcpy(second, first, sizeof(first));
+    std::memset(first, 0, sizeof(first));
+    const auto *moved = reinterpret_cast<const offset_node *>(
+        second + (reinterpret_cast<const std::byte *>(head) - first));
+    ASSERT_EQ(sum_list(moved), 55);
+}
+
+TEST(OffsetPtr, InContainers)
+{
+    int values[3] = {1, 2, 3};
+    utils::small_vector<offset_ptr<int>, 2> ptrs;
+    for (int &v: values)
+    {
+        ptrs.push_back(&v);
+    }
+    ptrs.reserve(16);
+    ASSERT_FALSE(ptrs.is_inline());
+    for (std::size_t i = 0; i < 3; ++i)
+    {
+        ASSERT_EQ(ptrs[i].get(), values + i);
+    }
+}
+
+TEST(ArenaPtr, Compressed)
+{
+    static_assert(sizeof(arena_ptr<arena_node, test_arena>) == 4);
+    static_assert(sizeof(arena_ptr<arena_node, test_arena, 16>) == 2);
+    static_assert(sizeof(arena_node) < sizeof(raw_node));
+    static_assert(std::is_trivially_copyable_v<arena_node>);
+}
+
+TEST(ArenaPtr, RebindArena)
+{
+    alignas(std::max_align_t) std::byte first[1024]{};
+    alignas(std::max_align_t) std::byte second[1024]{};
+    monotonic_buffer_resource resource(first, sizeof(first), nullptr);
+    allocator<arena_node> alloc(&resource);
+
+    test_arena::bind(first);
+    arena_ptr<arena_node, test_arena> head = make_list(alloc, 10);
+    ASSERT_TRUE(head);
+    ASSERT_EQ(head.get()->value, 1);
+    ASSERT_EQ(sum_list(head.get()), 55);
+
+    std::memcpy(second, first, sizeof(first));
+    test_arena::bind(second);
+    ASSERT_EQ(head->value, 1);
+    ASSERT_EQ(sum_list(head.get()), 55);
+
+    const auto copy = decltype(head)::from_index(head.index());
+    ASSERT_EQ(copy, head);
+    ASSERT_EQ(decltype(head)::pointer_to(*head), head);
+    ASSERT_FALSE(decltype(head)(nullptr));
+    test_arena::bind(nullptr);
+}
@@ -50,3 +50,12 @@ TEST(PaddingCheckerTest, Padding)
             std::tuple<char, char, char>>);  // detected padding because it is
                                              // not trivially copyable
 }
+
+TEST(PaddingCheckerTest, CacheLineIsolation)
+{
+    using padded = utils::cache_line_padded<std::uint64_t>;
+    static_assert(utils::has_padding_v<padded>);
+    static_assert(utils::is_cache_line_isolated_v<padded>);
+    static_assert(not utils::is_cache_line_isolated_v<no_padding>);
+    static_assert(sizeof(padded) == utils::kCacheLineSize);
+}
@@ -0,0 +1,133 @@
+#include <gtest/gtest.h>
+#include <utils/clocks.h>
+#include <utils/perf_counters.h>
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+void touch_pages(std::size_t aCount)
+{
+    std::vector<char> pages(aCount * 4096);
+    for (std::size_t i = 0; i < pages.size(); i += 4096)
+    {
+        pages[i] = 1;
+    }
+    volatile char sink = pages[pages.size() / 2];
+    static_cast<void>(sink);
+}
+
+void spin(std::chrono::milliseconds aDuration)
+{
+    const auto end = std::chrono::steady_clock::now() + aDuration;
+    volatile std::uint64_t x = 0;
+    while (std::chrono::steady_clock::now() < end)
+    {
+        x = x + 1;
+    }
+}
+}  // namespace
+
+TEST(PerfCounters, Sample)
+{
+    utils::perf_sample a;
+    a.values[0] = 10;
+    a.values[5] = 7;
+    a.available = 0b100001;
+    utils::perf_sample b;
+    b.values[0] = 4;
+    b.values[5] = 2;
+    b.available = 0b000001;
+    const auto d = a - b;
+    ASSERT_TRUE(d.has(utils::perf_counter::kCycles));
+    ASSERT_FALSE(d.has(utils::perf_counter::kPageFaults));
+    ASSERT_EQ(d[utils::perf_counter::kCycles], 6);
+    ASSERT_EQ(d[utils::perf_counter::kPageFaults], 5);
+}
+
+TEST(PerfCounters, Group)
+{
+    utils::perf_counter_group group;
+#if defined(__linux__)
+    static constexpr const char *kSources[] = {"none", "rusage", "software",
+                                               "hardware"};
+    std::printf("perf counter source: %s\n",
+                kSources[static_cast<int>(group.source())]);
+    // Software counters are always there, through perf or getrusage().
+    ASSERT_NE(group.source(), utils::perf_source::kNone);
+    ASSERT_TRUE(group.available(utils::perf_counter::kPageFaults));
+    ASSERT_TRUE(group.available(utils::perf_counter::kContextSwitches));
+    ASSERT_TRUE(group.available(utils::perf_counter::kTaskClock));
+    ASSERT_EQ(group.available(utils::perf_counter::kCycles),
+              group.source() == utils::perf_source::kHardware);
+
+    const auto before = group.read();
+    touch_pages(64);
+    spin(std::chrono::milliseconds(5));
+    const auto delta = group.read() - before;
+    ASSERT_TRUE(delta.has(utils::perf_counter::kPageFaults));
+    ASSERT_GE(delta[utils::perf_counter::kPageFaults], 32);
+    ASSERT_TRUE(delta.has(utils::perf_counter::kTaskClock));
+    ASSERT_GE(delta[utils::perf_counter::kTaskClock], 1'000'000);
+    if (delta.has(utils::perf_counter::kInstructions))
+    {
+        ASSERT_GT(delta[utils::perf_counter::kInstructions], 0);
+    }
+#else
+    ASSERT_EQ(group.source(), utils::perf_source::kNone);
+    ASSERT_EQ(group.read().available, 0);
+#endif
+}
+
+TEST(PerfCounters, Timer)
+{
+    struct measurement
+    {
+        utils::perf_sample counters;
+        std::chrono::nanoseconds elapsed{};
+    } m;
+
+    utils::perf_counter_group group;
+    {
+        utils::perf_timer t(group,
+                            [&m](const auto &aTimer) noexcept
+                            {
+                                m.counters = aTimer.counters();
+                                m.elapsed = aTimer.leaked();
+                            });
+        ASSERT_EQ(t.start_counters().available, group.read().available);
+        spin(std::chrono::milliseconds(2));
+        ASSERT_EQ(t.counters_so_far().available, t.start_counters().available);
+    }
+    ASSERT_GE(m.elapsed, std::chrono::milliseconds(2));
+#if defined(__linux__)
+    ASSERT_TRUE(m.counters.has(utils::perf_counter::kTaskClock));
+    ASSERT_GE(m.counters[utils::perf_counter::kTaskClock], 1'000'000);
+#endif
+}
+
+TEST(PerfCounters, TimerClock)
+{
+    using timer = utils::details::perf_timer<alignof(void *),
+                                             2 * sizeof(void *),
+                                             utils::tsc_clock>;
+    utils::perf_counter_group group;
+    std::uint64_t faults = 0;
+    utils::tsc_clock::duration elapsed{};
+    {
+        timer t(group,
+                [&faults, &elapsed](const timer &aTimer) noexcept
+                {
+                    using utils::perf_counter;
+                    faults = aTimer.counters()[perf_counter::kPageFaults];
+                    elapsed = aTimer.leaked();
+                });
+        touch_pages(64);
+    }
+    ASSERT_GT(elapsed.count(), 0);
+#if defined(__linux__)
+    ASSERT_GE(faults, 32);
+#endif
+}
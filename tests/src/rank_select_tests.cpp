@@ -0,0 +1,146 @@
+#include <gtest/gtest.h>
+#include <utils/memory/monotonic_buffer_resource.h>
+#include <utils/rank_select.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace
+{
+using bitvector = utils::rank_select_bitvector;
+
+bitvector build(const std::vector<bool> &aBits, std::mt19937_64 &aRng)
+{
+    // Mixes single bits with partial and whole words.
+    bitvector::builder builder;
+    std::size_t i = 0;
+    while (i < aBits.size())
+    {
+        const std::size_t count =
+            std::min<std::size_t>(aBits.size() - i, aRng() % 65);
+        // Bits above count must be ignored.
+        std::uint64_t word = count < 64 ? aRng() << count : 0;
+        for (std::size_t j = 0; j < count; ++j)
+        {
+            word |= std::uint64_t{aBits[i + j]} << j;
+        }
+        EXPECT_TRUE(count == 1 ? builder.push_back(aBits[i])
+                               : builder.append(word, count));
+        i += count;
+    }
+    EXPECT_EQ(builder.size(), aBits.size());
+    return builder.build();
+}
+
+void expect_matches(const bitvector &aVector, const std::vector<bool> &aBits)
+{
+    ASSERT_EQ(aVector.size(), aBits.size());
+    std::size_t rank = 0;
+    for (std::size_t i = 0; i < aBits.size(); ++i)
+    {
+        ASSERT_EQ(aVector.rank1(i), rank) << i;
+        ASSERT_EQ(aVector.rank0(i), i - rank) << i;
+        ASSERT_EQ(aVector[i], aBits[i]) << i;
+        if (aBits[i])
+        {
+            ASSERT_EQ(aVector.select1(rank), i) << rank;
+            ++rank;
+        }
+    }
+    ASSERT_EQ(aVector.rank1(aBits.size()), rank);
+    ASSERT_EQ(aVector.count(), rank);
+    ASSERT_EQ(aVector.select1(rank), aBits.size());
+}
+}  // namespace
+
+TEST(RankSelect, Empty)
+{
+    const bitvector empty;
+    ASSERT_TRUE(empty.empty());
+    ASSERT_EQ(empty.rank1(0), 0);
+    ASSERT_EQ(empty.select1(0), 0);
+
+    bitvector::builder builder;
+    const bitvector built = builder.build();
+    ASSERT_EQ(built.size(), 0);
+    ASSERT_EQ(built.select1(0), 0);
+}
+
+TEST(RankSelect, MatchesReference)
+{
+    std::mt19937_64 rng(3);
+    for (const std::size_t size: {std::size_t{1}, std::size_t{64},
+                                  std::size_t{1023}, std::size_t{1024},
+                                  std::size_t{5000}, std::size_t{300000}})
+    {
+        for (const unsigned density: {0u, 1u, 50u, 99u, 100u})
+        {
+            std::vector<bool> bits(size);
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                bits[i] = rng() % 100 < density;
+            }
+            expect_matches(build(bits, rng), bits);
+        }
+    }
+}
+
+TEST(RankSelect, ClusteredOnes)
+{
+    // Long empty stretches make the select samples far apart.
+    std::mt19937_64 rng(11);
+    std::vector<bool> bits(1 << 21);
+    for (std::size_t i = 0; i < bits.size(); ++i)
+    {
+        bits[i] = (i / 100000) % 3 == 0 ? rng() % 2 : rng() % 50000 == 0;
+    }
+    expect_matches(build(bits, rng), bits);
+}
+
+TEST(RankSelect, Overhead)
+{
+    bitvector::builder builder;
+    ASSERT_TRUE(builder.reserve(1 << 20));
+    for (std::size_t i = 0; i < (1 << 20) / 64; ++i)
+    {
+        ASSERT_TRUE(builder.append(0x8000000000000001ull));
+    }
+    const bitvector v = builder.build();
+    ASSERT_EQ(v.count(), (1 << 20) / 32);
+    ASSERT_EQ(v.select1(3), 127);
+    const double bits = static_cast<double>(v.size()) / 8;
+    ASSERT_LT(static_cast<double>(v.memory_usage()), bits * 1.07);
+}
+
+TEST(RankSelect, AllocatesThroughResource)
+{
+    alignas(std::max_align_t) std::byte buffer[8192]{};
+    utils::memory::monotonic_buffer_resource resource(
+        buffer, utils::memory::null_memory_resource());
+    bitvector::builder builder(&resource);
+    ASSERT_TRUE(builder.reserve(4096));
+    for (std::size_t i = 0; i < 4096; ++i)
+    {
+        ASSERT_TRUE(builder.push_back(i % 3 == 0));
+    }
+    ASSERT_TRUE(builder.append(~std::uint64_t{}));
+    ASSERT_FALSE(builder.reserve(1 << 20));
+
+    bitvector v = builder.build();
+    ASSERT_EQ(v.get_allocator().resource(), &resource);
+    ASSERT_EQ(v.rank1(4096), 1366);
+    ASSERT_EQ(v.select1(1365), 4095);
+
+    bitvector other(std::move(v));
+    ASSERT_TRUE(v.empty());
+    ASSERT_EQ(other.select1(10), 30);
+    bitvector moved;
+    moved = std::move(other);
+    ASSERT_EQ(moved.size(), 4096 + 64);
+    ASSERT_EQ(moved.rank1(moved.size()), 1366 + 64);
+    ASSERT_EQ(moved.get_allocator().resource(),
+              utils::memory::get_default_resource());
+}
@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+#include <utils/fast_pimpl.h>
+#include <utils/memory/relocate.h>
+
+#include <array>
+#include <string>
+
+namespace
+{
+struct opted_in
+{
+    using trivially_relocatable = std::true_type;
+
+    opted_in(int aValue) noexcept : value(new int(aValue)) {}
+    opted_in(opted_in &&aOther) noexcept
+        : value(std::exchange(aOther.value, nullptr))
+    {
+    }
+    ~opted_in() { delete value; }
+
+    int *value;
+};
+
+struct counted
+{
+    counted(int aValue) noexcept : value(aValue) { ++alive; }
+    counted(counted &&aOther) noexcept : value(aOther.value)
+    {
+        ++alive;
+        ++moves;
+    }
+    ~counted() { --alive; }
+
+    int value;
+    inline static int alive = 0;
+    inline static int moves = 0;
+};
+
+template <typename T, std::size_t N>
+struct raw_buffer
+{
+    T *data() noexcept { return reinterpret_cast<T *>(storage); }
+    alignas(T) std::byte storage[sizeof(T) * N];
+};
+}  // namespace
+
+TEST(Relocate, Trait)
+{
+    static_assert(utils::is_trivially_relocatable_v<int>);
+    static_assert(utils::is_trivially_relocatable_v<opted_in>);
+    static_assert(not utils::is_trivially_relocatable_v<counted>);
+    static_assert(not utils::is_trivially_relocatable_v<std::string>);
+    static_assert(
+        utils::is_trivially_relocatable_v<utils::fast_pimpl<int, 4, 4>>);
+    static_assert(
+        not utils::is_trivially_relocatable_v<utils::flex_pimpl<counted, 16>>);
+    static_assert(utils::is_trivially_relocatable_v<
+                  utils::flex_pimpl<std::array<counted, 8>, 16>>);
+}
+
+TEST(Relocate, TriviallyRelocatable)
+{
+    raw_buffer<opted_in, 3> from;
+    raw_buffer<opted_in, 3> to;
+    for (int i = 0; i < 3; ++i)
+    {
+        new (from.data() + i) opted_in(i);
+    }
+
+    auto *end = utils::memory::uninitialized_relocate(
+        from.data(), from.data() + 3, to.data());
+    ASSERT_EQ(end, to.data() + 3);
+    for (int i = 0; i < 3; ++i)
+    {
+        ASSERT_EQ(*to.data()[i].value, i);
+        to.data()[i].~opted_in();
+    }
+}
+
+TEST(Relocate, ElementWiseFallback)
+{
+    raw_buffer<counted, 4> from;
+    raw_buffer<counted, 4> to;
+    for (int i = 0; i < 4; ++i)
+    {
+        new (from.data() + i) counted(i);
+    }
+    counted::moves = 0;
+
+    utils::memory::uninitialized_relocate_n(from.data(), 4, to.data());
+    ASSERT_EQ(counted::moves, 4);
+    ASSERT_EQ(counted::alive, 4);
+    for (int i = 0; i < 4; ++i)
+    {
+        ASSERT_EQ(to.data()[i].value, i);
+        to.data()[i].~counted();
+    }
+    ASSERT_EQ(counted::alive, 0);
+}
+
+TEST(Relocate, SingleObject)
+{
+    raw_buffer<counted, 1> from;
+    raw_buffer<counted, 1> to;
+    new (from.data()) counted(5);
+    utils::memory::relocate(from.data(), to.data());
+    ASSERT_EQ(counted::alive, 1);
+    ASSERT_EQ(to.data()->value, 5);
+    to.data()->~counted();
+}
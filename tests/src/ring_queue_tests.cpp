@@ -0,0 +1,278 @@
+#include <gtest/gtest.h>
+#include <utils/memory/monotonic_buffer_resource.h>
+#include <utils/ring_queue.h>
+
+#include <array>
+#include <memory>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+namespace
+{
+struct counted
+{
+    counted(int aValue = 0) noexcept : value(aValue) { ++alive; }
+    counted(const counted &aOther) noexcept : value(aOther.value) { ++alive; }
+    counted &operator=(const counted &) noexcept = default;
+    ~counted() { --alive; }
+
+    int value;
+    inline static int alive = 0;
+};
+
+constexpr int kItemsPerThread = 20000;
+}  // namespace
+
+TEST(RingQueue, Layout)
+{
+    static_assert(utils::is_cache_line_isolated_v<
+                  utils::cache_line_padded<std::atomic<std::size_t>>>);
+    static_assert(not utils::is_cache_line_isolated_v<std::atomic<int>>);
+    static_assert(sizeof(utils::spsc_queue<int>) >= 3 * utils::kCacheLineSize);
+    static_assert(sizeof(utils::mpmc_queue<int>) >= 3 * utils::kCacheLineSize);
+}
+
+TEST(SpscQueue, PushPop)
+{
+    utils::spsc_queue<int> q(5);
+    ASSERT_EQ(q.capacity(), 8);
+    ASSERT_TRUE(q.empty());
+
+    for (int i = 0; i < 8; ++i)
+    {
+        ASSERT_TRUE(q.try_push(i));
+    }
+    ASSERT_FALSE(q.try_push(8));
+    ASSERT_EQ(q.size(), 8);
+
+    int value = -1;
+    for (int i = 0; i < 8; ++i)
+    {
+        ASSERT_TRUE(q.try_pop(value));
+        ASSERT_EQ(value, i);
+    }
+    ASSERT_FALSE(q.try_pop(value));
+    ASSERT_TRUE(q.empty());
+}
+
+TEST(SpscQueue, Bulk)
+{
+    utils::spsc_queue<int> q(8);
+    std::array<int, 6> in{1, 2, 3, 4, 5, 6};
+    ASSERT_EQ(q.try_push_bulk(in.begin(), in.size()), 6);
+    ASSERT_EQ(q.try_push_bulk(in.begin(), in.size()), 2);
+
+    std::array<int, 16> out{};
+    ASSERT_EQ(q.try_pop_bulk(out.begin(), 3), 3);
+    ASSERT_EQ(out[0], 1);
+    ASSERT_EQ(out[2], 3);
+    ASSERT_EQ(q.try_pop_bulk(out.begin(), out.size()), 5);
+    ASSERT_EQ(out[2], 6);
+    ASSERT_EQ(out[3], 1);
+    ASSERT_EQ(out[4], 2);
+    ASSERT_EQ(q.try_pop_bulk(out.begin(), out.size()), 0);
+}
+
+TEST(SpscQueue, MoveOnly)
+{
+    utils::spsc_queue<std::unique_ptr<int>> q(4);
+    ASSERT_TRUE(q.try_emplace(std::make_unique<int>(7)));
+    std::unique_ptr<int> out;
+    ASSERT_TRUE(q.try_pop(out));
+    ASSERT_EQ(*out, 7);
+}
+
+TEST(SpscQueue, DestroysRemaining)
+{
+    {
+        utils::spsc_queue<counted> q(4);
+        q.try_emplace(1);
+        q.try_emplace(2);
+        q.try_emplace(3);
+        counted out;
+        q.try_pop(out);
+        ASSERT_EQ(counted::alive, 3);
+    }
+    ASSERT_EQ(counted::alive, 0);
+}
+
+TEST(SpscQueue, FromResource)
+{
+    alignas(utils::kCacheLineSize) std::byte buf[1024];
+    utils::memory::monotonic_buffer_resource r(
+        buf, utils::memory::null_memory_resource());
+    utils::spsc_queue<int> q(16, &r);
+    ASSERT_TRUE(q.try_push(1));
+}
+
+TEST(SpscQueue, TwoThreads)
+{
+    utils::spsc_queue<int> q(64);
+    std::thread producer(
+        [&q]
+        {
+            std::array<int, 8> batch{};
+            int next = 0;
+            while (next < kItemsPerThread)
+            {
+                const int count = std::min<int>(batch.size(),
+                                                kItemsPerThread - next);
+                for (int i = 0; i < count; ++i)
+                {
+                    batch[i] = next + i;
+                }
+                const auto pushed = q.try_push_bulk(batch.begin(), count);
+                if (!pushed)
+                {
+                    std::this_thread::yield();
+                }
+                next += static_cast<int>(pushed);
+            }
+        });
+
+    int expected = 0;
+    std::array<int, 16> out{};
+    while (expected < kItemsPerThread)
+    {
+        const auto count = q.try_pop_bulk(out.begin(), out.size());
+        if (!count)
+        {
+            std::this_thread::yield();
+        }
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            ASSERT_EQ(out[i], expected++);
+        }
+    }
+    producer.join();
+    ASSERT_TRUE(q.empty());
+}
+
+TEST(MpmcQueue, PushPop)
+{
+    utils::mpmc_queue<int> q(4);
+    ASSERT_EQ(q.capacity(), 4);
+    for (int i = 0; i < 4; ++i)
+    {
+        ASSERT_TRUE(q.try_push(i));
+    }
+    ASSERT_FALSE(q.try_push(4));
+
+    std::array<int, 8> in{10, 11, 12, 13};
+    ASSERT_EQ(q.try_push_bulk(in.begin(), 4), 0);
+
+    int value = -1;
+    ASSERT_TRUE(q.try_pop(value));
+    ASSERT_EQ(value, 0);
+    ASSERT_EQ(q.try_push_bulk(in.begin(), 4), 1);
+
+    std::array<int, 8> out{};
+    ASSERT_EQ(q.try_pop_bulk(out.begin(), out.size()), 4);
+    ASSERT_EQ(out[0], 1);
+    ASSERT_EQ(out[3], 10);
+    ASSERT_TRUE(q.empty());
+    ASSERT_FALSE(q.try_pop(value));
+}
+
+TEST(MpmcQueue, SmallCapacity)
+{
+    for (const std::size_t requested: {std::size_t{1}, std::size_t{2}})
+    {
+        utils::mpmc_queue<int> q(requested);
+        ASSERT_EQ(q.capacity(), 2);
+        ASSERT_TRUE(q.try_push(1));
+        ASSERT_TRUE(q.try_push(2));
+        ASSERT_FALSE(q.try_push(3));
+        for (int round = 0; round < 4; ++round)
+        {
+            int value = -1;
+            ASSERT_TRUE(q.try_pop(value));
+            ASSERT_EQ(value, round + 1);
+            ASSERT_TRUE(q.try_push(round + 3));
+            ASSERT_FALSE(q.try_push(0));
+        }
+        int value = -1;
+        ASSERT_TRUE(q.try_pop(value));
+        ASSERT_EQ(value, 5);
+        ASSERT_TRUE(q.try_pop(value));
+        ASSERT_EQ(value, 6);
+        ASSERT_FALSE(q.try_pop(value));
+    }
+}
+
+TEST(MpmcQueue, DestroysRemaining)
+{
+    {
+        utils::mpmc_queue<counted> q(8);
+        q.try_emplace(1);
+        q.try_emplace(2);
+        ASSERT_EQ(counted::alive, 2);
+    }
+    ASSERT_EQ(counted::alive, 0);
+}
+
+TEST(MpmcQueue, ManyThreads)
+{
+    constexpr int kThreads = 4;
+    utils::mpmc_queue<int> q(128);
+    std::atomic<long long> sum{};
+    std::atomic<int> consumed{};
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t)
+    {
+        threads.emplace_back(
+            [&q, t]
+            {
+                const bool bulk = t % 2;
+                std::array<int, 4> batch{};
+                int next = 1;
+                while (next <= kItemsPerThread)
+                {
+                    if (bulk)
+                    {
+                        const int count = std::min<int>(
+                            batch.size(), kItemsPerThread - next + 1);
+                        std::iota(batch.begin(), batch.begin() + count, next);
+                        next += static_cast<int>(
+                            q.try_push_bulk(batch.begin(), count));
+                    }
+                    else if (q.try_push(next))
+                    {
+                        ++next;
+                    }
+                    else
+                    {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        threads.emplace_back(
+            [&]
+            {
+                std::array<int, 4> out{};
+                while (consumed.load() < kThreads * kItemsPerThread)
+                {
+                    const auto count = q.try_pop_bulk(out.begin(), out.size());
+                    if (!count)
+                    {
+                        std::this_thread::yield();
+                    }
+                    for (std::size_t i = 0; i < count; ++i)
+                    {
+                        sum += out[i];
+                    }
+                    consumed += static_cast<int>(count);
+                }
+            });
+    }
+    for (auto &t: threads)
+    {
+        t.join();
+    }
+
+    const long long n = kItemsPerThread;
+    ASSERT_EQ(sum.load(), kThreads * n * (n + 1) / 2);
+    ASSERT_TRUE(q.empty());
+}
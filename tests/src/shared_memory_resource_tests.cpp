@@ -0,0 +1,220 @@
+#include <gtest/gtest.h>
+#include <utils/memory/shared_memory_resource.h>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <string>
+
+namespace
+{
+using shared_resource = utils::memory::shared_memory_resource<64, 64>;
+using utils::memory::shared_handle;
+}  // namespace
+
+TEST(SharedMemoryResource, CreateAndAttach)
+{
+    std::error_code ec;
+    shared_resource owner(nullptr, 64 * 64, ec);
+    ASSERT_FALSE(ec);
+    ASSERT_TRUE(owner);
+    ASSERT_TRUE(owner.owner());
+    ASSERT_TRUE(owner.blocks());
+
+    shared_resource peer(owner.fd(), ec);
+    ASSERT_FALSE(ec);
+    ASSERT_TRUE(peer);
+    ASSERT_FALSE(peer.owner());
+    ASSERT_FALSE(peer.blocks());
+    ASSERT_EQ(peer.size(), owner.size());
+    ASSERT_NE(peer.fd(), owner.fd());
+}
+
+TEST(SharedMemoryResource, HoldsRequestedBlocks)
+{
+    std::error_code ec;
+    shared_resource owner(nullptr, 8 * 64 - 10, ec);
+    ASSERT_FALSE(ec);
+    ASSERT_EQ(owner.blocks()->size(), 8 * 64);
+    for (int i = 0; i < 8; ++i)
+    {
+        ASSERT_TRUE(owner.allocate(64)) << i;
+    }
+    ASSERT_EQ(owner.allocate(1), nullptr);
+}
+
+TEST(SharedMemoryResource, HandOffByHandle)
+{
+    std::error_code ec;
+    shared_resource owner(nullptr, 64 * 64, ec);
+    ASSERT_FALSE(ec);
+    shared_resource peer(owner.fd(), ec);
+    ASSERT_FALSE(ec);
+
+    auto *buffer = static_cast<char *>(owner.allocate(100));
+    ASSERT_TRUE(buffer);
+    std::strcpy(buffer, "zero copy");
+    const shared_handle handle = owner.to_handle(buffer);
+    ASSERT_TRUE(handle);
+    ASSERT_EQ(owner.from_handle(handle), buffer);
+    ASSERT_EQ(owner.to_handle(nullptr), shared_handle{});
+
+    auto *view = static_cast<char *>(peer.from_handle(handle));
+    ASSERT_NE(view, buffer);
+    ASSERT_STREQ(view, "zero copy");
+    std::strcpy(view, "answer");
+    ASSERT_STREQ(buffer, "answer");
+
+    ASSERT_EQ(peer.allocate(8), nullptr);
+    ASSERT_EQ(owner.blocks()->busy_count(), 1);
+    peer.deallocate(view);
+    ASSERT_EQ(owner.blocks()->busy_count(), 1);
+    ASSERT_EQ(owner.reclaim(), 1);
+    ASSERT_EQ(owner.blocks()->busy_count(), 0);
+    ASSERT_EQ(owner.reclaim(), 0);
+}
+
+TEST(SharedMemoryResource, AllocationReclaimsReturnedBuffers)
+{
+    std::error_code ec;
+    shared_resource owner(nullptr, 4 * 64, ec);
+    ASSERT_FALSE(ec);
+    shared_resource peer(owner.fd(), ec);
+    ASSERT_FALSE(ec);
+
+    void *first = owner.allocate(owner.blocks()->size());
+    ASSERT_TRUE(first);
+    ASSERT_EQ(owner.allocate(1), nullptr);
+
+    peer.deallocate(peer.from_handle(owner.to_handle(first)));
+    ASSERT_EQ(owner.allocate(1), first);
+    owner.deallocate(first);
+}
+
+TEST(SharedMemoryResource, ReturnRingWraps)
+{
+    std::error_code ec;
+    shared_resource owner(nullptr, 64 * 64, ec);
+    ASSERT_FALSE(ec);
+    shared_resource peer(owner.fd(), ec);
+    ASSERT_FALSE(ec);
+
+    for (int round = 0; round < 5; ++round)
+    {
+        shared_handle handles[48];
+        for (auto &h: handles)
+        {
+            h = owner.to_handle(owner.allocate(1));
+            ASSERT_TRUE(h);
+        }
+        for (auto h: handles)
+        {
+            peer.deallocate(peer.from_handle(h));
+        }
+        ASSERT_EQ(owner.reclaim(), 48);
+        ASSERT_EQ(owner.blocks()->busy_count(), 0);
+    }
+}
+
+TEST(SharedMemoryResource, DoubleReturnAborts)
+{
+    std::error_code ec;
+    shared_resource owner(nullptr, 64 * 64, ec);
+    ASSERT_FALSE(ec);
+    shared_resource peer(owner.fd(), ec);
+    ASSERT_FALSE(ec);
+
+    void *view = peer.from_handle(owner.to_handle(owner.allocate(1)));
+    ASSERT_DEATH(
+        {
+            for (std::size_t i = 0; i <= shared_resource::kReturnCapacity;
+                 ++i)
+            {
+                peer.deallocate(view);
+            }
+        },
+        "returned twice");
+}
+
+TEST(SharedMemoryResource, Named)
+{
+    const std::string name = "/utils_shm_test_" + std::to_string(::getpid());
+    std::error_code ec;
+    {
+        shared_resource owner(name.c_str(), 64 * 64, ec);
+        ASSERT_FALSE(ec);
+        shared_resource duplicate(name.c_str(), 64 * 64, ec);
+        ASSERT_EQ(ec, std::errc::file_exists);
+
+        shared_resource peer(name.c_str(), ec);
+        ASSERT_FALSE(ec);
+        auto *value = static_cast<int *>(owner.allocate(sizeof(int)));
+        *value = 42;
+        ASSERT_EQ(*static_cast<int *>(peer.from_handle(owner.to_handle(value))),
+                  42);
+    }
+    ASSERT_FALSE(shared_resource::remove(name.c_str()));
+    shared_resource missing(name.c_str(), ec);
+    ASSERT_EQ(ec, std::errc::no_such_file_or_directory);
+    ASSERT_FALSE(missing);
+}
+
+TEST(SharedMemoryResource, Mismatch)
+{
+    std::error_code ec;
+    shared_resource owner(nullptr, 64 * 64, ec);
+    ASSERT_FALSE(ec);
+
+    utils::memory::shared_memory_resource<64, 128> other(owner.fd(), ec);
+    ASSERT_EQ(ec, std::errc::invalid_argument);
+    ASSERT_FALSE(other);
+
+    shared_resource closed(-1, ec);
+    ASSERT_TRUE(ec);
+    ASSERT_FALSE(closed);
+}
+
+TEST(SharedMemoryResource, AcrossProcesses)
+{
+    std::error_code ec;
+    shared_resource owner(nullptr, 64 * 64, ec);
+    ASSERT_FALSE(ec);
+
+    auto *request = static_cast<int *>(owner.allocate(sizeof(int) * 16));
+    auto *reply = static_cast<int *>(owner.allocate(sizeof(int) * 16));
+    for (int i = 0; i < 16; ++i)
+    {
+        request[i] = i;
+    }
+    const shared_handle in = owner.to_handle(request);
+    const shared_handle out = owner.to_handle(reply);
+
+    const pid_t pid = ::fork();
+    ASSERT_NE(pid, -1);
+    if (!pid)
+    {
+        std::error_code child_ec;
+        shared_resource peer(owner.fd(), child_ec);
+        const auto *src = static_cast<const int *>(peer.from_handle(in));
+        auto *dst = static_cast<int *>(peer.from_handle(out));
+        for (int i = 0; i < 16; ++i)
+        {
+            dst[i] = src[i] * src[i];
+        }
+        peer.deallocate(peer.from_handle(in));
+        ::_exit(child_ec ? 1 : 0);
+    }
+
+    int status = 0;
+    ASSERT_EQ(::waitpid(pid, &status, 0), pid);
+    ASSERT_TRUE(WIFEXITED(status));
+    ASSERT_EQ(WEXITSTATUS(status), 0);
+    for (int i = 0; i < 16; ++i)
+    {
+        ASSERT_EQ(reply[i], i * i);
+    }
+    ASSERT_EQ(owner.reclaim(), 1);
+    ASSERT_EQ(owner.blocks()->busy_count(), 1);
+    owner.deallocate(reply);
+}
@@ -0,0 +1,269 @@
+#include <gtest/gtest.h>
+#include <utils/simd.h>
+
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <type_traits>
+
+namespace
+{
+template <typename T, std::size_t N>
+struct lanes
+{
+    using type = T;
+    static constexpr std::size_t kSize = N;
+};
+
+template <typename T>
+T random_lane(std::mt19937_64 &aRng)
+{
+    if constexpr (std::is_floating_point_v<T>)
+    {
+        // Small integers, so that equal lanes and exact sums are common.
+        return static_cast<T>(static_cast<int>(aRng() % 17) - 8) / T{2};
+    }
+    else if (aRng() % 4 == 0)
+    {
+        // Extremes exercise wrapping and the unsigned compares.
+        return (aRng() % 2) ? std::numeric_limits<T>::max()
+                            : std::numeric_limits<T>::min();
+    }
+    else
+    {
+        return static_cast<T>(aRng());
+    }
+}
+
+template <typename T, std::size_t N>
+utils::simd<T, N> random_simd(std::mt19937_64 &aRng)
+{
+    utils::simd<T, N> result;
+    for (std::size_t i = 0; i < N; ++i)
+    {
+        result.set(i, random_lane<T>(aRng));
+    }
+    return result;
+}
+
+template <typename T, std::size_t N, typename Op>
+void expect_lanes(const utils::simd<T, N> &aResult,
+                  const utils::simd<T, N> &aLhs,
+                  const utils::simd<T, N> &aRhs, Op aOp)
+{
+    for (std::size_t i = 0; i < N; ++i)
+    {
+        ASSERT_EQ(aResult[i], static_cast<T>(aOp(aLhs[i], aRhs[i])))
+            << "lane " << i;
+    }
+}
+
+template <typename T, std::size_t N, typename Op>
+void expect_mask(const utils::simd_mask<T, N> &aResult,
+                 const utils::simd<T, N> &aLhs,
+                 const utils::simd<T, N> &aRhs, Op aOp)
+{
+    std::uint64_t bits = 0;
+    for (std::size_t i = 0; i < N; ++i)
+    {
+        const bool expected = aOp(aLhs[i], aRhs[i]);
+        ASSERT_EQ(aResult[i], expected) << "lane " << i;
+        ASSERT_EQ(aResult.lanes()[i],
+                  expected ? static_cast<decltype(aResult.lanes()[i])>(~0ull)
+                           : 0);
+        bits |= std::uint64_t{expected} << i;
+    }
+    ASSERT_EQ(aResult.bits(), bits);
+}
+
+template <typename T>
+T wrap(unsigned long long aValue)
+{
+    return static_cast<T>(aValue);
+}
+
+template <typename Lanes>
+class SimdTyped : public ::testing::Test
+{
+};
+
+using lane_types = ::testing::Types<
+    lanes<float, 4>, lanes<float, 8>, lanes<float, 16>, lanes<double, 2>,
+    lanes<double, 4>, lanes<double, 1>, lanes<std::int8_t, 16>,
+    lanes<std::int8_t, 32>, lanes<std::uint8_t, 16>, lanes<std::uint8_t, 64>,
+    lanes<std::int16_t, 8>, lanes<std::int16_t, 16>, lanes<std::uint16_t, 8>,
+    lanes<std::uint16_t, 16>, lanes<std::int32_t, 4>, lanes<std::int32_t, 8>,
+    lanes<std::uint32_t, 4>, lanes<std::uint32_t, 16>, lanes<std::int64_t, 2>,
+    lanes<std::int64_t, 4>, lanes<std::uint64_t, 2>, lanes<std::uint64_t, 4>,
+    lanes<std::int32_t, 2>>;
+
+TYPED_TEST_SUITE(SimdTyped, lane_types);
+}  // namespace
+
+TYPED_TEST(SimdTyped, MatchesScalar)
+{
+    using T = typename TypeParam::type;
+    constexpr std::size_t N = TypeParam::kSize;
+    using vec = utils::simd<T, N>;
+    static_assert(alignof(vec) == vec::kAlignment);
+    static_assert(sizeof(vec) == N * sizeof(T));
+
+    std::mt19937_64 rng(N * sizeof(T));
+    for (int round = 0; round < 200; ++round)
+    {
+        const vec a = random_simd<T, N>(rng);
+        vec b = random_simd<T, N>(rng);
+        if (round % 5 == 0)
+        {
+            b.set(round % N, a[round % N]);
+        }
+
+        expect_lanes(a + b, a, b, utils::details::simd_plus{});
+        expect_lanes(a - b, a, b, utils::details::simd_minus{});
+        expect_lanes(a * b, a, b, utils::details::simd_multiplies{});
+        expect_lanes(min(a, b), a, b, utils::details::simd_min{});
+        expect_lanes(max(a, b), a, b, utils::details::simd_max{});
+        if constexpr (std::is_integral_v<T>)
+        {
+            expect_lanes(a & b, a, b, utils::details::simd_bit_and{});
+            expect_lanes(a | b, a, b, utils::details::simd_bit_or{});
+            expect_lanes(a ^ b, a, b, utils::details::simd_bit_xor{});
+            const vec notA = ~a;
+            const vec shifted = (a << 3) >> 2;
+            for (std::size_t i = 0; i < N; ++i)
+            {
+                ASSERT_EQ(notA[i], static_cast<T>(~a[i]));
+                const auto wide = static_cast<unsigned long long>(a[i]);
+                ASSERT_EQ(shifted[i], static_cast<T>(wrap<T>(wide << 3) >> 2));
+            }
+        }
+        else
+        {
+            expect_lanes(a / (b + vec(T{100})), a, b + vec(T{100}),
+                         utils::details::simd_divides{});
+        }
+
+        expect_mask(a == b, a, b, utils::details::simd_equal{});
+        expect_mask(a != b, a, b, utils::details::simd_not_equal{});
+        expect_mask(a < b, a, b, utils::details::simd_less{});
+        expect_mask(a <= b, a, b, utils::details::simd_less_equal{});
+        expect_mask(a > b, a, b, utils::details::simd_greater{});
+        expect_mask(a >= b, a, b, utils::details::simd_greater_equal{});
+
+        const auto mask = a < b;
+        const vec selected = select(mask, a, b);
+        T sum{};
+        T least = a[0];
+        T greatest = a[0];
+        for (std::size_t i = 0; i < N; ++i)
+        {
+            ASSERT_EQ(selected[i], mask[i] ? a[i] : b[i]);
+            sum = utils::details::simd_plus{}(sum, a[i]);
+            least = std::min(least, a[i]);
+            greatest = std::max(greatest, a[i]);
+        }
+        ASSERT_EQ(utils::reduce_add(a), sum);
+        ASSERT_EQ(utils::reduce_min(a), least);
+        ASSERT_EQ(utils::reduce_max(a), greatest);
+
+        ASSERT_EQ((mask & !mask).bits(), 0);
+        ASSERT_TRUE((mask | !mask).all());
+        ASSERT_EQ(mask.count() + (!mask).count(), N);
+        ASSERT_EQ((mask ^ mask).none(), true);
+        ASSERT_EQ(mask.any(), mask.count() > 0);
+    }
+}
+
+TEST(Simd, Constexpr)
+{
+    using vec = utils::simd<std::int32_t, 4>;
+    constexpr vec a(1, 2, 3, 4);
+    constexpr vec b(4);
+    constexpr vec sum = a + b * vec(2) - vec(1);
+    static_assert(sum[0] == 8 && sum[3] == 11);
+    static_assert(utils::reduce_add(a) == 10);
+    static_assert(utils::reduce_max(a) == 4);
+    static_assert((a < vec(3)).bits() == 0b0011);
+    static_assert((a == b).find_first() == 3);
+    static_assert((a > b).find_first() == 4);
+    static_assert(utils::select(a < vec(3), a, -a)[2] == -3);
+    static_assert(utils::reverse(a)[0] == 4);
+    static_assert(utils::shuffle<3, 3>(a)[1] == 4);
+    static_assert(((a << 4) >> 4)[1] == 2);
+
+    constexpr utils::simd<float, 4> f(0.5f, -1.0f, 2.0f, 0.0f);
+    static_assert(utils::reduce_add(f * f) == 5.25f);
+    static_assert((-f)[1] == 1.0f);
+    static_assert((f >= utils::simd<float, 4>(0.0f)).count() == 3);
+
+    // Integer lanes wrap instead of overflowing.
+    constexpr utils::simd<std::int8_t, 16> big(std::int8_t{127});
+    static_assert((big + big)[0] == -2);
+    constexpr utils::simd<std::uint16_t, 8> u(std::uint16_t{65535});
+    static_assert((u * u)[5] == 1);
+}
+
+TEST(Simd, LoadStore)
+{
+    using vec = utils::simd<float, 8>;
+    alignas(64) float data[17];
+    for (std::size_t i = 0; i < 17; ++i)
+    {
+        data[i] = static_cast<float>(i);
+    }
+    const vec aligned = vec::load_aligned(data + 8);
+    ASSERT_EQ(aligned[0], 8.0f);
+    ASSERT_EQ(aligned[7], 15.0f);
+    const vec unaligned = vec::load(data + 1);
+    ASSERT_EQ(unaligned[0], 1.0f);
+    ASSERT_EQ(unaligned[7], 8.0f);
+
+    (aligned + unaligned).store(data + 9);
+    ASSERT_EQ(data[9], 9.0f);
+    ASSERT_EQ(data[16], 23.0f);
+    vec(0.0f).store_aligned(data);
+    ASSERT_EQ(data[7], 0.0f);
+    ASSERT_EQ(data[8], 8.0f);
+
+    ASSERT_DEATH(vec::load_aligned(data + 1), "misaligned");
+}
+
+TEST(Simd, Shuffle)
+{
+    const utils::simd<std::uint16_t, 8> v(0, 1, 2, 3, 4, 5, 6, 7);
+    const auto odd = utils::shuffle<1, 3, 5, 7>(v);
+    static_assert(std::is_same_v<decltype(odd)::value_type, std::uint16_t>);
+    static_assert(decltype(odd)::kSize == 4);
+    ASSERT_EQ(odd[0], 1);
+    ASSERT_EQ(odd[3], 7);
+    const auto reversed = utils::reverse(v);
+    const auto halves = v.high() + v.low();
+    for (std::size_t i = 0; i < 8; ++i)
+    {
+        ASSERT_EQ(reversed[i], 7 - i);
+    }
+    ASSERT_EQ(halves[0], 4);
+    ASSERT_EQ(halves[3], 10);
+}
+
+TEST(Simd, Mask)
+{
+    using mask = utils::simd_mask<double, 4>;
+    mask m;
+    ASSERT_TRUE(m.none());
+    m.set(2, true);
+    ASSERT_EQ(m.bits(), 0b0100);
+    ASSERT_EQ(m.find_first(), 2);
+    m |= mask(true);
+    ASSERT_TRUE(m.all());
+    m ^= mask(true);
+    ASSERT_TRUE(m.none());
+
+    // Unordered lanes compare false except for !=.
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    const utils::simd<double, 4> a(nan, 1.0, 2.0, nan);
+    const utils::simd<double, 4> b(1.0, 1.0, nan, nan);
+    ASSERT_EQ((a == b).bits(), 0b0010);
+    ASSERT_EQ((a != b).bits(), 0b1101);
+    ASSERT_EQ((a < b).bits() | (a > b).bits(), 0);
+}
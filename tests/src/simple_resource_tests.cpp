@@ -464,6 +464,26 @@ TEST_F(NaiveMemoryResourceA4N32S8, DeallocateAndAllocateAgainOneChar)
     ASSERT_EQ(resource.busy_count(), resource.kMaxBlockCount);
 }
 
+TEST_F(NaiveMemoryResourceA4N32S8, SkipsFreeRegionThatDoesNotFit)
+{
+    for (BIndex i = 0; i < 3; ++i)
+    {
+        allocated_pointers[i] = resource.allocate(sizeof(char), alignof(char));
+    }
+    resource.deallocate(allocated_pointers[1]);
+    allocated_pointers[1] = nullptr;
+
+    // The one-block region at block 1 is too small, the search moves on.
+    allocated_pointers[3] = resource.allocate(12, alignof(char));
+    ASSERT_EQ(allocated_pointers[3], data_ + 3 * 8);
+    ASSERT_FALSE(resource.in_use(1));
+    ASSERT_TRUE(resource.in_use(3));
+
+    void *spilled = resource.allocate(resource.size(), alignof(char));
+    ASSERT_NE(spilled, nullptr);
+    resource.deallocate(spilled);
+}
+
 TEST_F(FreeRegionAtTheBeginningOfTheResource,
        AllocateAtTheBeginningOfFreeRegion)
 {
@@ -851,3 +871,82 @@ TEST_F(NaiveMemoryResourceDeathTest, DeallocatePointerThatNotInUse)
         },
         DeallocatingNotAllocatedPointer());
 }
+
+using UsageA32N32S8 = naive_resource<32, 32, 8>;
+
+TEST_F(UsageA32N32S8, FreshResource)
+{
+    const auto stats = c_resource.usage();
+    ASSERT_EQ(stats.free_bytes, 256);
+    ASSERT_EQ(stats.busy_bytes, 0);
+    ASSERT_EQ(stats.free_region_count, 1);
+    ASSERT_EQ(stats.largest_free_run, 256);
+    ASSERT_EQ(stats.free_histogram[5], 1);
+    ASSERT_DOUBLE_EQ(stats.external_fragmentation, 0.0);
+    ASSERT_EQ(stats.allocation_count, 0);
+    ASSERT_EQ(stats.upstream_spills, 0);
+}
+
+TEST_F(UsageA32N32S8, FragmentedResource)
+{
+    for (int i = 0; i < 3; ++i)
+    {
+        allocated_pointers[i] = resource.allocate(sizeof(char), alignof(char));
+    }
+    resource.deallocate(allocated_pointers[1]);
+    allocated_pointers[1] = nullptr;
+
+    const auto stats = c_resource.usage();
+    ASSERT_EQ(stats.busy_bytes, 16);
+    ASSERT_EQ(stats.free_bytes, 240);
+    ASSERT_EQ(stats.free_region_count, 2);
+    ASSERT_EQ(stats.largest_free_run, 232);
+    ASSERT_EQ(stats.free_histogram[0], 1);
+    ASSERT_EQ(stats.free_histogram[4], 1);
+    ASSERT_DOUBLE_EQ(stats.external_fragmentation, 1.0 - 232.0 / 240.0);
+    ASSERT_EQ(stats.allocation_count, 3);
+    ASSERT_DOUBLE_EQ(stats.average_internal_waste, 7.0);
+}
+
+TEST_F(UsageA32N32S8, AlignmentSkipAndSpills)
+{
+    allocated_pointers[0] = resource.allocate(sizeof(char), alignof(char));
+    allocated_pointers[1] = resource.allocate(sizeof(char), 32);
+    ASSERT_EQ(c_resource.usage().average_alignment_skip, 12.0);
+
+    void *spilled = resource.allocate(1024);
+    ASSERT_NE(spilled, nullptr);
+    const auto stats = c_resource.usage();
+    ASSERT_EQ(stats.upstream_spills, 1);
+    ASSERT_EQ(stats.allocation_count, 2);
+    ASSERT_EQ(stats.free_region_count, 2);
+    resource.deallocate(spilled);
+}
+
+TEST_F(UsageA32N32S8, AllocateAtLeast)
+{
+    const auto result = resource.allocate_at_least(3, 1);
+    ASSERT_EQ(result.ptr, data_);
+    ASSERT_EQ(result.count, simple_resource::kBlockSize);
+
+    const auto spilled = resource.allocate_at_least(1024);
+    ASSERT_NE(spilled.ptr, nullptr);
+    ASSERT_GE(spilled.count, 1024);
+    resource.deallocate(spilled.ptr);
+    resource.deallocate(result.ptr);
+}
+
+TEST_F(UsageA32N32S8, ExactBlockMultiple)
+{
+    allocated_pointers[0] = resource.allocate(simple_resource::kBlockSize, 1);
+    ASSERT_EQ(allocated_pointers[0], data_);
+    ASSERT_EQ(c_resource.usage().busy_bytes, simple_resource::kBlockSize);
+    resource.deallocate(allocated_pointers[0]);
+
+    allocated_pointers[0] = resource.allocate(c_resource.size(), 1);
+    ASSERT_EQ(allocated_pointers[0], data_);
+    ASSERT_EQ(c_resource.usage().free_bytes, 0);
+    resource.deallocate(allocated_pointers[0]);
+    allocated_pointers[0] = nullptr;
+    ASSERT_EQ(c_resource.usage().free_bytes, c_resource.size());
+}
@@ -0,0 +1,155 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <utils/memory/monotonic_buffer_resource.h>
+#include <utils/slot_map.h>
+
+#include <vector>
+
+namespace
+{
+using int_slot_map = utils::slot_map<int>;
+using handle = int_slot_map::handle;
+
+struct point
+{
+    point(int aX, int aY) noexcept : x(aX), y(aY) {}
+    int x;
+    int y;
+};
+}  // namespace
+
+TEST(SlotMap, HandleLayout)
+{
+    static_assert(sizeof(handle) == sizeof(uint32_t));
+    static_assert(sizeof(handle::index_type) == sizeof(uint32_t));
+    static_assert(sizeof(handle::generation_type) == sizeof(uint16_t));
+    static_assert(sizeof(utils::slot_map<int, 32, 32>::handle) ==
+                  sizeof(uint64_t));
+
+    constexpr handle h{5, 7};
+    static_assert(h.index() == 5);
+    static_assert(h.generation() == 7);
+    static_assert(not handle{});
+}
+
+TEST(SlotMap, DefaultConstructor)
+{
+    int_slot_map map;
+    ASSERT_TRUE(map.empty());
+    ASSERT_EQ(map.size(), 0);
+    ASSERT_EQ(map.begin(), map.end());
+    ASSERT_EQ(map.get_allocator().resource(),
+              utils::memory::get_default_resource());
+}
+
+TEST(SlotMap, InsertFind)
+{
+    int_slot_map map;
+    const auto h1 = map.insert(1);
+    const auto h2 = map.insert(2);
+    ASSERT_TRUE(h1);
+    ASSERT_TRUE(h2);
+    ASSERT_NE(h1, h2);
+    ASSERT_EQ(map.size(), 2);
+    ASSERT_EQ(*map.find(h1), 1);
+    ASSERT_EQ(map[h2], 2);
+}
+
+TEST(SlotMap, EraseInvalidatesHandle)
+{
+    int_slot_map map;
+    const auto h1 = map.insert(1);
+    const auto h2 = map.insert(2);
+    ASSERT_TRUE(map.erase(h1));
+    ASSERT_FALSE(map.erase(h1));
+    ASSERT_FALSE(map.contains(h1));
+    ASSERT_EQ(map.find(h1), nullptr);
+    ASSERT_EQ(map[h2], 2);
+
+    const auto h3 = map.insert(3);
+    ASSERT_EQ(h3.index(), h1.index());
+    ASSERT_NE(h3.generation(), h1.generation());
+    ASSERT_FALSE(map.contains(h1));
+    ASSERT_EQ(map[h3], 3);
+}
+
+TEST(SlotMap, DenseIteration)
+{
+    int_slot_map map;
+    std::vector<handle> handles;
+    for (int i = 0; i < 100; ++i)
+    {
+        handles.push_back(map.insert(i));
+    }
+    for (int i = 0; i < 100; i += 2)
+    {
+        ASSERT_TRUE(map.erase(handles[static_cast<std::size_t>(i)]));
+    }
+
+    ASSERT_EQ(map.size(), 50);
+    ASSERT_EQ(static_cast<std::size_t>(map.end() - map.begin()), map.size());
+    int sum = 0;
+    for (int v: map)
+    {
+        ASSERT_EQ(v % 2, 1);
+        sum += v;
+    }
+    ASSERT_EQ(sum, 2500);
+
+    for (std::size_t i = 0; i < map.size(); ++i)
+    {
+        ASSERT_EQ(map.find(map.handle_at(i)), map.data() + i);
+    }
+}
+
+TEST(SlotMap, GenerationWrapsSkippingZero)
+{
+    utils::slot_map<int, 8, 2> map;
+    auto h = map.insert(0);
+    for (int i = 0; i < 10; ++i)
+    {
+        ASSERT_TRUE(map.erase(h));
+        h = map.insert(i);
+        ASSERT_TRUE(h);
+        ASSERT_EQ(h.index(), 0);
+    }
+}
+
+TEST(SlotMap, CapacityIsBoundedByIndexBits)
+{
+    utils::slot_map<int, 4, 4> map;
+    for (std::size_t i = 0; i < map.max_size(); ++i)
+    {
+        ASSERT_TRUE(map.insert(static_cast<int>(i)));
+    }
+    ASSERT_FALSE(map.insert(0));
+}
+
+TEST(SlotMap, AllocatesThroughResource)
+{
+    alignas(std::max_align_t) std::byte buffer[4096]{};
+    utils::memory::monotonic_buffer_resource resource(
+        buffer, utils::memory::null_memory_resource());
+    utils::slot_map<point> map(&resource);
+    ASSERT_TRUE(map.reserve(16));
+    const auto h = map.emplace(3, 4);
+    ASSERT_EQ(map[h].x, 3);
+    ASSERT_EQ(map[h].y, 4);
+    ASSERT_GE(static_cast<void *>(map.data()), static_cast<void *>(buffer));
+    ASSERT_LT(static_cast<void *>(map.data()),
+              static_cast<void *>(buffer + sizeof(buffer)));
+    ASSERT_FALSE(map.reserve(1024));
+}
+
+TEST(SlotMap, MoveKeepsHandles)
+{
+    int_slot_map map;
+    const auto h = map.insert(42);
+    int_slot_map other(std::move(map));
+    ASSERT_TRUE(map.empty());
+    ASSERT_EQ(other[h], 42);
+
+    int_slot_map third;
+    third = std::move(other);
+    ASSERT_EQ(third[h], 42);
+}
@@ -0,0 +1,172 @@
+#include <gtest/gtest.h>
+#include <utils/memory/monotonic_buffer_resource.h>
+#include <utils/small_vector.h>
+
+#include <memory>
+
+namespace
+{
+using int_vector = utils::small_vector<int, 4>;
+}  // namespace
+
+TEST(SmallVector, StaysInlineUpToN)
+{
+    int_vector v{1, 2, 3, 4};
+    ASSERT_TRUE(v.is_inline());
+    ASSERT_EQ(v.capacity(), 4);
+    v.push_back(5);
+    ASSERT_FALSE(v.is_inline());
+    ASSERT_EQ(v.size(), 5);
+    ASSERT_GE(v.capacity(), 5);
+    for (int i = 0; i < 5; ++i)
+    {
+        ASSERT_EQ(v[static_cast<std::size_t>(i)], i + 1);
+    }
+}
+
+TEST(SmallVector, SpillsThroughResource)
+{
+    alignas(std::max_align_t) std::byte buffer[256]{};
+    utils::memory::monotonic_buffer_resource resource(
+        buffer, utils::memory::null_memory_resource());
+    utils::small_vector<int, 2> v(&resource);
+    v.push_back(1);
+    v.push_back(2);
+    ASSERT_TRUE(v.is_inline());
+    v.push_back(3);
+    ASSERT_EQ(static_cast<void *>(v.data()), static_cast<void *>(buffer));
+    ASSERT_FALSE(v.reserve(1024));
+    ASSERT_EQ(v.size(), 3);
+}
+
+TEST(SmallVector, UsesAllocationSlack)
+{
+    alignas(std::max_align_t) std::byte buffer[256]{};
+    utils::memory::monotonic_buffer_resource resource(
+        buffer, utils::memory::null_memory_resource());
+    utils::small_vector<int, 2> v(&resource);
+    ASSERT_TRUE(v.reserve(5));
+    const std::size_t usable =
+        utils::next_multiple_of(alignof(std::max_align_t), 5 * sizeof(int));
+    ASSERT_EQ(v.capacity(), usable / sizeof(int));
+}
+
+TEST(SmallVector, MoveInlineAndHeap)
+{
+    int_vector a{1, 2};
+    int_vector b(std::move(a));
+    ASSERT_TRUE(a.empty());
+    ASSERT_TRUE(b.is_inline());
+    ASSERT_EQ(b, (int_vector{1, 2}));
+
+    int_vector c{1, 2, 3, 4, 5, 6};
+    const int *heap = c.data();
+    int_vector d(std::move(c));
+    ASSERT_TRUE(c.is_inline());
+    ASSERT_EQ(d.data(), heap);
+
+    b = std::move(d);
+    ASSERT_EQ(b.data(), heap);
+    ASSERT_EQ(b.size(), 6);
+}
+
+TEST(SmallVector, CopyAndErase)
+{
+    int_vector a{1, 2, 3, 4, 5, 6};
+    int_vector b(a);
+    ASSERT_EQ(a, b);
+    b.erase(b.begin() + 1, b.begin() + 4);
+    ASSERT_EQ(b, (int_vector{1, 5, 6}));
+    b = a;
+    ASSERT_EQ(a, b);
+}
+
+TEST(SmallVector, PushBackOwnElement)
+{
+    // Every growth after the first moves from one heap buffer to another.
+    utils::small_vector<std::shared_ptr<int>, 1> v;
+    v.push_back(std::make_shared<int>(42));
+    for (int i = 0; i < 8; ++i)
+    {
+        v.push_back(v[0]);
+        v.emplace_back(v.back());
+    }
+    ASSERT_EQ(v.size(), 17);
+    for (const auto &p: v)
+    {
+        ASSERT_TRUE(p);
+        ASSERT_EQ(*p, 42);
+    }
+    ASSERT_EQ(v[0].use_count(), 17);
+}
+
+TEST(SmallVector, NonTrivialType)
+{
+    utils::small_vector<std::unique_ptr<int>, 2> v;
+    for (int i = 0; i < 10; ++i)
+    {
+        v.emplace_back(new int(i));
+    }
+    v.erase(v.begin());
+    ASSERT_EQ(*v.front(), 1);
+    ASSERT_EQ(*v.back(), 9);
+    v.resize(2);
+    ASSERT_EQ(v.size(), 2);
+}
+
+TEST(SmallVector, NestedVectorsShareResource)
+{
+    alignas(std::max_align_t) std::byte buffer[1024]{};
+    utils::memory::monotonic_buffer_resource resource(
+        buffer, utils::memory::null_memory_resource());
+    using inner = utils::small_vector<int, 1>;
+    utils::small_vector<inner, 1> outer(&resource);
+
+    outer.emplace_back();
+    outer.emplace_back();
+    outer[1].push_back(1);
+    outer[1].push_back(2);
+    ASSERT_EQ(outer[1].get_allocator().resource(), &resource);
+    ASSERT_FALSE(outer[1].is_inline());
+
+    const inner copy(outer[1], &resource);
+    ASSERT_EQ(copy.get_allocator().resource(), &resource);
+    ASSERT_EQ(copy, outer[1]);
+}
+
+TEST(SmallVector, MoveAssignAcrossResources)
+{
+    alignas(std::max_align_t) std::byte buffer[1024]{};
+    utils::memory::monotonic_buffer_resource resource(
+        buffer, utils::memory::null_memory_resource());
+    using inner = utils::small_vector<int, 1>;
+    utils::small_vector<inner, 2> source(&resource);
+    source.emplace_back();
+    source[0].push_back(1);
+    source[0].push_back(2);
+
+    // Inline source, different allocator: the elements must be rebuilt.
+    utils::small_vector<inner, 2> target;
+    target = std::move(source);
+    ASSERT_TRUE(source.empty());
+    ASSERT_EQ(target.size(), 1);
+    ASSERT_EQ(target[0], (inner{1, 2}));
+    ASSERT_EQ(target[0].get_allocator().resource(),
+              utils::memory::get_default_resource());
+
+    // Heap source, different allocator.
+    utils::small_vector<inner, 2> heap(&resource);
+    for (int i = 0; i < 3; ++i)
+    {
+        heap.emplace_back().push_back(i);
+    }
+    target = std::move(heap);
+    ASSERT_TRUE(heap.empty());
+    ASSERT_EQ(target.size(), 3);
+    for (const auto &v: target)
+    {
+        ASSERT_EQ(v.get_allocator().resource(),
+                  utils::memory::get_default_resource());
+    }
+    ASSERT_EQ(target[2], (inner{2}));
+}
@@ -0,0 +1,79 @@
+#include <gtest/gtest.h>
+#include <utils/static_vector.h>
+
+#include <memory>
+
+namespace
+{
+template <std::size_t N>
+constexpr auto make_squares() noexcept
+{
+    utils::static_vector<int, N> v;
+    for (std::size_t i = 0; i < N; ++i)
+    {
+        v.push_back(static_cast<int>(i * i));
+    }
+    return v;
+}
+
+constexpr int sum_after_erase() noexcept
+{
+    auto v = make_squares<5>();
+    v.erase(v.begin() + 1, v.begin() + 3);
+    int sum = 0;
+    for (int i: v)
+    {
+        sum += i;
+    }
+    return sum;
+}
+}  // namespace
+
+TEST(StaticVector, Constexpr)
+{
+    constexpr auto v = make_squares<4>();
+    static_assert(v.size() == 4);
+    static_assert(v[3] == 9);
+    static_assert(v.full());
+    static_assert(sum_after_erase() == 0 + 9 + 16);
+    static_assert(utils::static_vector<int, 2>{1, 2} ==
+                  utils::static_vector<int, 2>{1, 2});
+}
+
+TEST(StaticVector, CompactSize)
+{
+    static_assert(sizeof(utils::static_vector<char, 8>) == 9);
+    static_assert(std::is_trivially_copyable_v<utils::static_vector<int, 8>>);
+}
+
+TEST(StaticVector, TryEmplaceBackWhenFull)
+{
+    utils::static_vector<int, 2> v{1, 2};
+    ASSERT_EQ(v.try_emplace_back(3), nullptr);
+    v.pop_back();
+    ASSERT_NE(v.try_emplace_back(3), nullptr);
+    ASSERT_EQ(v.back(), 3);
+}
+
+TEST(StaticVector, NonTrivialType)
+{
+    utils::static_vector<std::unique_ptr<int>, 4> v;
+    v.emplace_back(new int(1));
+    v.emplace_back(new int(2));
+    v.emplace_back(new int(3));
+    v.erase(v.begin());
+    ASSERT_EQ(v.size(), 2);
+    ASSERT_EQ(*v[0], 2);
+    ASSERT_EQ(*v[1], 3);
+
+    auto moved = std::move(v);
+    ASSERT_EQ(*moved.front(), 2);
+    moved.resize(4);
+    ASSERT_EQ(moved.back(), nullptr);
+}
+
+TEST(StaticVectorDeathTest, Overflow)
+{
+    utils::static_vector<int, 1> v{1};
+    ASSERT_DEATH(v.push_back(2), "");
+}
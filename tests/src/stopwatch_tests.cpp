@@ -0,0 +1,146 @@
+#include <gtest/gtest.h>
+#include <utils/clocks.h>
+#include <utils/stopwatch.h>
+
+#include <thread>
+
+namespace
+{
+using namespace std::chrono_literals;
+
+// Clock advanced by hand so that lap lengths are exact.
+struct manual_clock
+{
+    using rep = std::int64_t;
+    using period = std::nano;
+    using duration = std::chrono::nanoseconds;
+    using time_point = std::chrono::time_point<manual_clock>;
+    static constexpr bool is_steady = true;
+
+    static inline time_point current{};
+
+    static time_point now() noexcept { return current; }
+    static void advance(duration aBy) noexcept { current += aBy; }
+};
+
+using manual_stopwatch =
+    utils::details::stopwatch<alignof(void *), sizeof(void *), manual_clock>;
+
+std::size_t gFinishedLaps = 0;
+
+void on_finish(const utils::stopwatch &aStopwatch) noexcept
+{
+    gFinishedLaps = aStopwatch.laps();
+}
+}  // namespace
+
+TEST(Stopwatch, Traits)
+{
+    static_assert(std::is_nothrow_default_constructible_v<utils::stopwatch>);
+    static_assert(not std::is_copy_constructible_v<utils::stopwatch>);
+    static_assert(std::is_nothrow_move_constructible_v<utils::stopwatch>);
+    static_assert(std::is_nothrow_move_assignable_v<utils::stopwatch>);
+}
+
+TEST(Stopwatch, PauseResume)
+{
+    manual_stopwatch sw;
+    ASSERT_FALSE(sw.running());
+    ASSERT_EQ(sw.laps(), 0);
+    ASSERT_EQ(sw.min_lap(), 0ns);
+    ASSERT_EQ(sw.mean_lap(), 0ns);
+    ASSERT_EQ(sw.pause(), 0ns);
+
+    sw.resume();
+    manual_clock::advance(30ns);
+    ASSERT_EQ(sw.elapsed(), 30ns);
+    sw.resume();
+    manual_clock::advance(20ns);
+    ASSERT_EQ(sw.pause(), 50ns);
+    ASSERT_FALSE(sw.running());
+
+    // Time spent paused is not counted.
+    manual_clock::advance(1000ns);
+    sw.resume();
+    manual_clock::advance(10ns);
+    ASSERT_EQ(sw.pause(), 10ns);
+    sw.resume();
+    manual_clock::advance(90ns);
+    sw.pause();
+
+    ASSERT_EQ(sw.laps(), 3);
+    ASSERT_EQ(sw.total(), 150ns);
+    ASSERT_EQ(sw.elapsed(), 150ns);
+    ASSERT_EQ(sw.min_lap(), 10ns);
+    ASSERT_EQ(sw.max_lap(), 90ns);
+    ASSERT_EQ(sw.last_lap(), 90ns);
+    ASSERT_EQ(sw.mean_lap(), 50ns);
+
+    sw.reset();
+    ASSERT_EQ(sw.laps(), 0);
+    ASSERT_EQ(sw.total(), 0ns);
+    ASSERT_EQ(sw.max_lap(), 0ns);
+}
+
+TEST(Stopwatch, Lap)
+{
+    manual_stopwatch sw;
+    ASSERT_EQ(sw.lap(), 0ns);
+    ASSERT_TRUE(sw.running());
+    ASSERT_EQ(sw.laps(), 0);
+    for (int i = 1; i <= 4; ++i)
+    {
+        manual_clock::advance(i * 10ns);
+        ASSERT_EQ(sw.lap(), i * 10ns);
+    }
+    ASSERT_TRUE(sw.running());
+    ASSERT_EQ(sw.laps(), 4);
+    ASSERT_EQ(sw.total(), 100ns);
+    manual_clock::advance(5ns);
+    ASSERT_EQ(sw.elapsed(), 105ns);
+    ASSERT_EQ(sw.min_lap(), 10ns);
+    ASSERT_EQ(sw.max_lap(), 40ns);
+}
+
+TEST(Stopwatch, FinishCallback)
+{
+    std::chrono::nanoseconds total{};
+    {
+        manual_stopwatch sw([&total](const auto &aStopwatch) noexcept
+                            { total = aStopwatch.total(); });
+        sw.resume();
+        manual_clock::advance(7ns);
+        sw.pause();
+        sw.resume();
+        manual_clock::advance(3ns);
+        // Still running: the destructor closes the lap before the callback.
+    }
+    ASSERT_EQ(total, 10ns);
+
+    gFinishedLaps = 0;
+    {
+        utils::stopwatch sw(on_finish);
+        utils::stopwatch moved(std::move(sw));
+        moved.lap();
+        moved.lap();
+    }
+    ASSERT_EQ(gFinishedLaps, 2);
+}
+
+TEST(Stopwatch, RealClocks)
+{
+    utils::details::stopwatch<alignof(void *), sizeof(void *),
+                              utils::tsc_clock>
+        sw;
+    for (int i = 0; i < 3; ++i)
+    {
+        sw.resume();
+        std::this_thread::sleep_for(1ms);
+        sw.pause();
+        std::this_thread::sleep_for(1ms);
+    }
+    ASSERT_EQ(sw.laps(), 3);
+    ASSERT_GE(sw.total(), 3ms);
+    ASSERT_GE(sw.min_lap(), 1ms);
+    ASSERT_LE(sw.min_lap(), sw.max_lap());
+}
@@ -0,0 +1,231 @@
+#include <gtest/gtest.h>
+#include <utils/memory/monotonic_buffer_resource.h>
+#include <utils/timing_wheel.h>
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+
+namespace
+{
+using namespace std::chrono_literals;
+using clock = std::chrono::steady_clock;
+
+// 3 levels of 4 slots: cascades and the far-future path are easy to reach.
+using small_wheel =
+    utils::details::timing_wheel<alignof(void *), 4 * sizeof(void *), clock,
+                                 2, 3>;
+
+struct counted
+{
+    static inline int alive = 0;
+    int *calls;
+
+    explicit counted(int *aCalls) noexcept : calls(aCalls) { ++alive; }
+    counted(const counted &aOther) noexcept : calls(aOther.calls) { ++alive; }
+    ~counted() { --alive; }
+
+    void operator()() const noexcept { ++*calls; }
+};
+}  // namespace
+
+TEST(TimingWheel, FiresInOrderAndNeverEarly)
+{
+    const auto t0 = clock::time_point{};
+    utils::timing_wheel wheel(1ms, t0);
+    std::vector<int> order;
+    wheel.schedule_at(t0 + 5ms, [&order]() noexcept { order.push_back(5); });
+    wheel.schedule_at(t0 + 2ms, [&order]() noexcept { order.push_back(2); });
+    // Rounded up to the 3rd tick.
+    wheel.schedule_at(t0 + 2500us,
+                      [&order]() noexcept { order.push_back(3); });
+    ASSERT_EQ(wheel.size(), 3);
+
+    ASSERT_EQ(wheel.advance(t0 + 1ms), 0);
+    ASSERT_EQ(wheel.advance(t0 + 2ms), 1);
+    ASSERT_EQ(wheel.advance(t0 + 2900us), 0);
+    ASSERT_EQ(wheel.advance(t0 + 10ms), 2);
+    ASSERT_EQ(order, (std::vector<int>{2, 3, 5}));
+    ASSERT_TRUE(wheel.empty());
+    ASSERT_EQ(wheel.now(), t0 + 10ms);
+
+    // Past deadlines fire on the next tick.
+    int calls = 0;
+    wheel.schedule_at(t0, [&calls]() noexcept { ++calls; });
+    ASSERT_EQ(wheel.advance(t0 + 10ms), 0);
+    ASSERT_EQ(wheel.advance(t0 + 11ms), 1);
+    ASSERT_EQ(calls, 1);
+}
+
+TEST(TimingWheel, Cancel)
+{
+    const auto t0 = clock::time_point{};
+    small_wheel wheel(1ms, t0);
+    int calls = 0;
+    {
+        auto keep = wheel.schedule_after(3ms, counted(&calls));
+        auto drop = wheel.schedule_after(40ms, counted(&calls));
+        auto dropFar = wheel.schedule_after(500ms, counted(&calls));
+        ASSERT_EQ(counted::alive, 3);
+        ASSERT_TRUE(wheel.cancel(drop));
+        ASSERT_FALSE(drop);
+        ASSERT_FALSE(wheel.cancel(drop));
+        ASSERT_TRUE(wheel.cancel(dropFar));
+        ASSERT_EQ(counted::alive, 1);
+        ASSERT_EQ(wheel.size(), 1);
+
+        ASSERT_EQ(wheel.advance(t0 + 1s), 1);
+        ASSERT_EQ(calls, 1);
+        ASSERT_EQ(counted::alive, 0);
+        // The node was recycled; the stale handle must not cancel its reuse.
+        auto reuse = wheel.schedule_after(1ms, counted(&calls));
+        ASSERT_TRUE(reuse);
+        ASSERT_FALSE(wheel.cancel(keep));
+        ASSERT_EQ(wheel.size(), 1);
+    }
+    {
+        small_wheel other(1ms, t0);
+        other.schedule_after(1ms, counted(&calls));
+        ASSERT_EQ(counted::alive, 2);
+    }
+    // Pending callbacks are destroyed, not run, with their wheel.
+    ASSERT_EQ(counted::alive, 1);
+    ASSERT_EQ(calls, 1);
+}
+
+TEST(TimingWheel, MatchesReference)
+{
+    const auto t0 = clock::time_point{};
+    small_wheel wheel(1ms, t0);
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> delay(0, 150);
+
+    struct entry
+    {
+        // Deadline in ticks, at least one tick after scheduling.
+        std::int64_t deadline;
+        std::int64_t fired_at{-1};
+        small_wheel::handle handle;
+        bool cancelled{};
+    };
+    std::vector<entry> entries(2000);
+    std::vector<std::int64_t> advances;
+    std::int64_t now = 0;
+    for (std::size_t i = 0; i < entries.size(); ++i)
+    {
+        auto &e = entries[i];
+        const std::int64_t deadline = now + delay(rng);
+        e.deadline = std::max(deadline, now + 1);
+        e.handle = wheel.schedule_at(
+            t0 + std::chrono::milliseconds(deadline),
+            [&e, &now]() noexcept { e.fired_at = now; });
+        ASSERT_TRUE(e.handle);
+        if (i % 7 == 3)
+        {
+            e.cancelled = wheel.cancel(entries[i / 2].handle);
+            if (e.cancelled)
+            {
+                entries[i / 2].deadline = -1;
+            }
+        }
+        if (i % 3 == 0)
+        {
+            now += delay(rng) / 10;
+            wheel.advance(t0 + std::chrono::milliseconds(now));
+            advances.push_back(now);
+        }
+    }
+    now += 1000;
+    wheel.advance(t0 + std::chrono::milliseconds(now));
+    advances.push_back(now);
+    ASSERT_TRUE(wheel.empty());
+
+    for (const auto &e: entries)
+    {
+        if (e.deadline < 0)
+        {
+            ASSERT_EQ(e.fired_at, -1);
+            continue;
+        }
+        // Fired by the first advance() that reached the deadline.
+        ASSERT_EQ(e.fired_at, *std::lower_bound(advances.begin(),
+                                                advances.end(), e.deadline));
+    }
+}
+
+TEST(TimingWheel, ExactTicksAcrossLevels)
+{
+    const auto t0 = clock::time_point{};
+    small_wheel wheel(1ms, t0);
+    std::vector<std::int64_t> fired;
+    std::int64_t now = 0;
+    // 200 and 1000 lie beyond the 64 ticks the three levels can represent.
+    for (std::int64_t d: {1, 3, 4, 5, 15, 16, 17, 63, 64, 65, 200, 1000})
+    {
+        wheel.schedule_at(t0 + std::chrono::milliseconds(d),
+                          [&fired, &now]() noexcept { fired.push_back(now); });
+    }
+    for (now = 1; now <= 1000; ++now)
+    {
+        wheel.advance(t0 + std::chrono::milliseconds(now));
+    }
+    ASSERT_EQ(fired, (std::vector<std::int64_t>{1, 3, 4, 5, 15, 16, 17, 63, 64,
+                                                65, 200, 1000}));
+}
+
+TEST(TimingWheel, ScheduleFromCallback)
+{
+    const auto t0 = clock::time_point{};
+    utils::timing_wheel wheel(1ms, t0);
+    int ticks = 0;
+    struct periodic
+    {
+        utils::timing_wheel *wheel;
+        int *ticks;
+
+        void operator()() const noexcept
+        {
+            if (++*ticks < 5)
+            {
+                wheel->schedule_after(10ms, *this);
+            }
+        }
+    };
+    wheel.schedule_after(10ms, periodic{&wheel, &ticks});
+    ASSERT_EQ(wheel.advance(t0 + 1s), 5);
+    ASSERT_EQ(ticks, 5);
+    ASSERT_TRUE(wheel.empty());
+}
+
+TEST(TimingWheel, NodesFromResource)
+{
+    alignas(std::max_align_t) std::byte buf[4096];
+    utils::memory::monotonic_buffer_resource r(
+        buf, utils::memory::null_memory_resource());
+    const auto t0 = clock::time_point{};
+    utils::timing_wheel wheel(1ms, t0, &r);
+
+    std::size_t reserved = 0;
+    while (wheel.reserve(reserved + 1))
+    {
+        ++reserved;
+    }
+    ASSERT_GT(reserved, 10);
+
+    int calls = 0;
+    std::vector<utils::timing_wheel::handle> handles;
+    for (std::size_t i = 0; i < reserved; ++i)
+    {
+        handles.push_back(
+            wheel.schedule_after(1ms, [&calls]() noexcept { ++calls; }));
+        ASSERT_TRUE(handles.back());
+    }
+    // The resource is exhausted; the wheel reports it instead of failing.
+    ASSERT_FALSE(wheel.schedule_after(1ms, [&calls]() noexcept { ++calls; }));
+
+    ASSERT_EQ(wheel.advance(t0 + 1ms), reserved);
+    ASSERT_EQ(calls, static_cast<int>(reserved));
+    // Fired nodes are reused.
+    ASSERT_TRUE(wheel.schedule_after(1ms, [&calls]() noexcept { ++calls; }));
+}
@@ -0,0 +1,181 @@
+#define UTILS_ENABLE_TRACING
+#include <gtest/gtest.h>
+#include <utils/trace.h>
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+std::vector<utils::trace_event> drain_all(utils::trace_collector &aCollector)
+{
+    std::vector<utils::trace_event> events;
+    aCollector.drain([&](const utils::trace_event &aEvent) noexcept
+                     { events.push_back(aEvent); });
+    return events;
+}
+
+std::string read_file(const char *aPath)
+{
+    std::ifstream in(aPath);
+    return {std::istreambuf_iterator<char>(in),
+            std::istreambuf_iterator<char>()};
+}
+
+std::size_t count_of(const std::string &aText, const std::string &aNeedle)
+{
+    std::size_t count = 0;
+    for (auto pos = aText.find(aNeedle); pos != std::string::npos;
+         pos = aText.find(aNeedle, pos + 1))
+    {
+        ++count;
+    }
+    return count;
+}
+}  // namespace
+
+TEST(Trace, NestedZones)
+{
+    utils::trace_collector collector(64);
+    {
+        utils::trace_zone outer(collector, "outer");
+        {
+            utils::trace_zone inner(collector, "inner");
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    const auto events = drain_all(collector);
+    ASSERT_EQ(events.size(), 2);
+    // Zones are recorded when they end.
+    ASSERT_STREQ(events[0].name, "inner");
+    ASSERT_EQ(events[0].depth, 1);
+    ASSERT_STREQ(events[1].name, "outer");
+    ASSERT_EQ(events[1].depth, 0);
+    ASSERT_EQ(events[0].thread_id, events[1].thread_id);
+    ASSERT_GE(events[0].duration_ns, 1'000'000);
+    ASSERT_GE(events[0].start_ns, events[1].start_ns);
+    ASSERT_GE(events[1].duration_ns, events[0].duration_ns);
+    ASSERT_EQ(collector.local_buffer().id(), events[0].thread_id);
+    ASSERT_TRUE(drain_all(collector).empty());
+}
+
+TEST(Trace, FullBufferDrops)
+{
+    utils::trace_collector collector(4);
+    for (int i = 0; i < 10; ++i)
+    {
+        utils::trace_zone zone(collector, "zone");
+    }
+    ASSERT_EQ(drain_all(collector).size(), 4);
+    ASSERT_EQ(collector.dropped(), 6);
+}
+
+TEST(Trace, PerThreadBuffers)
+{
+    constexpr int kThreads = 4;
+    constexpr int kZones = 1000;
+    utils::trace_collector collector(kZones);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t)
+    {
+        threads.emplace_back(
+            [&collector]
+            {
+                for (int i = 0; i < kZones; ++i)
+                {
+                    utils::trace_zone zone(collector, "work");
+                }
+            });
+    }
+    for (auto &t: threads)
+    {
+        t.join();
+    }
+
+    const auto events = drain_all(collector);
+    ASSERT_EQ(events.size(), kThreads * kZones);
+    std::vector<int> perThread(kThreads + 1);
+    for (const auto &e: events)
+    {
+        ASSERT_GE(e.thread_id, 1);
+        ASSERT_LE(e.thread_id, kThreads);
+        ASSERT_EQ(e.depth, 0);
+        ++perThread[e.thread_id];
+    }
+    for (int t = 1; t <= kThreads; ++t)
+    {
+        ASSERT_EQ(perThread[t], kZones);
+    }
+    ASSERT_EQ(collector.dropped(), 0);
+}
+
+TEST(Trace, WriteJson)
+{
+    utils::trace_collector collector(16);
+    {
+        utils::trace_zone zone(collector, "say \"hi\"\\");
+    }
+    std::FILE *file = std::tmpfile();
+    ASSERT_NE(file, nullptr);
+    ASSERT_TRUE(collector.write_json(file));
+
+    std::rewind(file);
+    std::string text;
+    for (int c = std::fgetc(file); c != EOF; c = std::fgetc(file))
+    {
+        text.push_back(static_cast<char>(c));
+    }
+    std::fclose(file);
+
+    ASSERT_EQ(text.rfind("{\"traceEvents\":[", 0), 0);
+    ASSERT_NE(text.find("\"name\":\"say \\\"hi\\\"\\\\\""), std::string::npos);
+    ASSERT_NE(text.find("\"ph\":\"X\""), std::string::npos);
+    ASSERT_NE(text.find("\"args\":{\"depth\":0}"), std::string::npos);
+    ASSERT_EQ(text.substr(text.size() - 4), "\n]}\n");
+}
+
+TEST(Trace, BackgroundFlush)
+{
+    const std::string path = testing::TempDir() + "utils_trace_tests.json";
+    utils::trace_collector collector(256);
+    ASSERT_TRUE(collector.start(path.c_str(), std::chrono::milliseconds(1)));
+    ASSERT_FALSE(collector.start(path.c_str()));
+
+    for (int round = 0; round < 5; ++round)
+    {
+        for (int i = 0; i < 100; ++i)
+        {
+            utils::trace_zone zone(collector, "tick");
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    ASSERT_TRUE(collector.stop());
+    ASSERT_TRUE(collector.stop());
+
+    const std::string text = read_file(path.c_str());
+    std::remove(path.c_str());
+    ASSERT_EQ(text.rfind("{\"traceEvents\":[\n{", 0), 0);
+    ASSERT_EQ(count_of(text, "\"name\":\"tick\""), 500);
+    ASSERT_EQ(count_of(text, "},\n{"), 499);
+    ASSERT_EQ(text.substr(text.size() - 4), "\n]}\n");
+}
+
+TEST(Trace, Macro)
+{
+    drain_all(utils::default_trace_collector());
+    {
+        UTILS_TRACE_ZONE("macro outer");
+        UTILS_TRACE_ZONE("macro inner");
+    }
+    const auto events = drain_all(utils::default_trace_collector());
+    ASSERT_EQ(events.size(), 2);
+    ASSERT_STREQ(events[0].name, "macro inner");
+    ASSERT_EQ(events[0].depth, 1);
+    ASSERT_STREQ(events[1].name, "macro outer");
+}